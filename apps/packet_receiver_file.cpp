@@ -49,8 +49,7 @@ int main(int argc, char** argv)
 
     const char* connection_error = "connection error";
 
-    if (fg.connect<"out">(file_source).to<"in">(*packet_receiver.syncword_detection) !=
-        gr::ConnectionResult::SUCCESS) {
+    if (packet_receiver.connect_input(fg, file_source) != gr::ConnectionResult::SUCCESS) {
         throw gr::exception(connection_error);
     }
     if (fg.connect<"out">(*packet_receiver.payload_crc_check)
@@ -55,7 +55,7 @@ int main(int argc, char** argv)
 
     const char* connection_error = "connection error";
 
-    if (fg.connect<"out">(soapy_source).to<"in">(*packet_receiver.syncword_detection) !=
+    if (packet_receiver.connect_input(fg, soapy_source) !=
         gr::ConnectionResult::SUCCESS) {
         throw gr::exception(connection_error);
     }
@@ -158,8 +158,7 @@ int main(int argc, char** argv)
         gr::ConnectionResult::SUCCESS) {
         throw gr::exception(connection_error);
     }
-    if (fg.connect<"out">(add_noise).to<"in">(*packet_receiver.syncword_detection) !=
-        gr::ConnectionResult::SUCCESS) {
+    if (packet_receiver.connect_input(fg, add_noise) != gr::ConnectionResult::SUCCESS) {
         throw gr::exception(connection_error);
     }
     if (fg.connect<"out">(*packet_receiver.payload_crc_check)
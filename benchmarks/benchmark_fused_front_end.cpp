@@ -0,0 +1,210 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/additive_scrambler.hpp>
+#include <gnuradio-4.0/packet-modem/coarse_frequency_correction.hpp>
+#include <gnuradio-4.0/packet-modem/constellation_llr_decoder.hpp>
+#include <gnuradio-4.0/packet-modem/costas_loop.hpp>
+#include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/fused_front_end.hpp>
+#include <gnuradio-4.0/packet-modem/fused_symbol_decoder.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/symbol_filter.hpp>
+#include <gnuradio-4.0/packet-modem/syncword_remove.hpp>
+#include <gnuradio-4.0/packet-modem/syncword_wipeoff.hpp>
+#include <gnuradio-4.0/packet-modem/vector_source.hpp>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+
+using c64 = std::complex<float>;
+
+constexpr size_t num_arms = 32;
+constexpr size_t syncword_size = 64;
+constexpr size_t header_size = 128;
+constexpr size_t payload_size = 2000;
+
+template <typename Source, typename Sink>
+void connect(gr::Graph& fg, Source& source, Sink& sink)
+{
+    if (fg.connect<"out">(source).template to<"in">(sink) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception("connection_error");
+    }
+}
+
+// Runs the flowgraph with the single-threaded scheduler, so that the time
+// measured is the total time spent in the blocks, and returns the time per item
+double run(gr::Graph&& fg, uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    gr::scheduler::Simple sched{ std::move(fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+           static_cast<double>(num_items);
+}
+
+// Runs num_items samples through the Coarse Frequency Correction, Symbol Filter
+// and Syncword Wipe-off blocks, or through the Fused Front End block, with the
+// same parameters as in the packet receiver
+double benchmark_front_end(bool fused, size_t samples_per_symbol, uint64_t num_items)
+{
+    const auto rrc_taps = gr::packet_modem::firdes::root_raised_cosine(
+        1.0, static_cast<double>(samples_per_symbol), 1.0, 0.35, samples_per_symbol * 11);
+    auto taps = gr::packet_modem::firdes::root_raised_cosine(
+        static_cast<double>(num_arms),
+        static_cast<double>(num_arms * samples_per_symbol),
+        1.0,
+        0.35,
+        num_arms * samples_per_symbol * 11U);
+    taps.pop_back();
+    const size_t freq_correction_delay = (rrc_taps.size() - 1) / 2 + samples_per_symbol;
+    const std::vector<float> syncword(syncword_size, 1.0f);
+    const gr::property_map symbol_filter_settings = {
+        { "taps", taps },
+        { "num_arms", num_arms },
+        { "samples_per_symbol", samples_per_symbol },
+        { "delay", rrc_taps.size() - 1 }
+    };
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+    connect(fg, source, head);
+    if (fused) {
+        auto settings = symbol_filter_settings;
+        settings["freq_correction_delay"] = freq_correction_delay;
+        settings["syncword"] = syncword;
+        auto& front_end = fg.emplaceBlock<gr::packet_modem::FusedFrontEnd<>>(settings);
+        connect(fg, head, front_end);
+        connect(fg, front_end, sink);
+    } else {
+        auto& freq_correction =
+            fg.emplaceBlock<gr::packet_modem::CoarseFrequencyCorrection<>>(
+                { { "delay", freq_correction_delay } });
+        auto& symbol_filter =
+            fg.emplaceBlock<gr::packet_modem::SymbolFilter<c64, c64, float>>(
+                symbol_filter_settings);
+        auto& syncword_wipeoff = fg.emplaceBlock<gr::packet_modem::SyncwordWipeoff<>>(
+            { { "syncword", syncword } });
+        connect(fg, head, freq_correction);
+        connect(fg, freq_correction, symbol_filter);
+        connect(fg, symbol_filter, syncword_wipeoff);
+        connect(fg, syncword_wipeoff, sink);
+    }
+    return run(std::move(fg), num_items);
+}
+
+// Runs num_items symbols through the Costas Loop, Syncword Remove, Constellation
+// LLR Decoder and Additive Scrambler blocks, or through the Fused Symbol Decoder
+// block. The input is a repeated QPSK packet tagged in the same way as the
+// output of the Payload Metadata Insert block.
+double benchmark_symbol_decoder(bool fused, uint64_t num_items)
+{
+    using namespace std::string_literals;
+
+    std::vector<c64> symbols;
+    std::default_random_engine e(0);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    std::uniform_int_distribution<int> bits(0, 3);
+    const float a = 1.0f / std::numbers::sqrt2_v<float>;
+    for (size_t j = 0; j < syncword_size + header_size + payload_size; ++j) {
+        c64 z{ 1.0f, 0.0f };
+        if (j >= syncword_size) {
+            const int n = bits(e);
+            z = c64{ n % 2 == 0 ? a : -a, n / 2 == 0 ? a : -a };
+        }
+        symbols.push_back(z + c64{ noise(e), noise(e) });
+    }
+    const std::vector<gr::Tag> tags = {
+        { 0,
+          { { "syncword_amplitude", 1.0f },
+            { "syncword_phase", 0.0f },
+            { "constellation", "PILOT"s },
+            { "loop_bandwidth", 0.02 } } },
+        { static_cast<ssize_t>(syncword_size),
+          { { "constellation", "QPSK"s },
+            { "header_start", pmtv::pmt_null() },
+            { "loop_bandwidth", 0.01 } } },
+        { static_cast<ssize_t>(syncword_size + header_size),
+          { { "payload_symbols", static_cast<uint64_t>(payload_size) },
+            { "loop_bandwidth", 0.005 } } }
+    };
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::VectorSource<c64>>(
+        { { "repeat", true } });
+    source.data = symbols;
+    source.tags = tags;
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<float>>();
+    connect(fg, source, head);
+    if (fused) {
+        auto& symbol_decoder = fg.emplaceBlock<gr::packet_modem::FusedSymbolDecoder<>>(
+            { { "noise_sigma", 0.7f },
+              { "scrambler_mask", uint64_t{ 0x4001U } },
+              { "scrambler_seed", uint64_t{ 0x18E38U } },
+              { "scrambler_length", uint64_t{ 16U } },
+              { "scrambler_reset_tag_key", "header_start" } });
+        connect(fg, head, symbol_decoder);
+        connect(fg, symbol_decoder, sink);
+    } else {
+        auto& costas_loop = fg.emplaceBlock<gr::packet_modem::CostasLoop<>>();
+        auto& syncword_remove = fg.emplaceBlock<gr::packet_modem::SyncwordRemove<>>();
+        auto& constellation_decoder =
+            fg.emplaceBlock<gr::packet_modem::ConstellationLLRDecoder<>>(
+                { { "noise_sigma", 0.7f }, { "constellation", "QPSK" } });
+        auto& descrambler = fg.emplaceBlock<gr::packet_modem::AdditiveScrambler<float>>(
+            { { "mask", uint64_t{ 0x4001U } },
+              { "seed", uint64_t{ 0x18E38U } },
+              { "length", uint64_t{ 16U } },
+              { "reset_tag_key", "header_start" } });
+        connect(fg, head, costas_loop);
+        connect(fg, costas_loop, syncword_remove);
+        connect(fg, syncword_remove, constellation_decoder);
+        connect(fg, constellation_decoder, descrambler);
+        connect(fg, descrambler, sink);
+    }
+    return run(std::move(fg), num_items);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 1) || (argc > 3)) {
+        fmt::println(stderr, "usage: {} [samples_per_symbol] [num_items]", argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default samples per symbol is 4");
+        fmt::println(stderr, "the default num items is 100000000");
+        std::exit(1);
+    }
+    const size_t samples_per_symbol = argc >= 2 ? std::stoul(argv[1]) : 4;
+    const uint64_t num_items = argc >= 3 ? std::stoull(argv[2]) : 100'000'000;
+
+    fmt::println("separate front-end blocks: {:.2f} ns/sample",
+                 benchmark_front_end(false, samples_per_symbol, num_items));
+    fmt::println("Fused Front End: {:.2f} ns/sample",
+                 benchmark_front_end(true, samples_per_symbol, num_items));
+    const uint64_t num_symbols = num_items / samples_per_symbol;
+    fmt::println("separate symbol decoder blocks: {:.2f} ns/symbol",
+                 benchmark_symbol_decoder(false, num_symbols));
+    fmt::println("Fused Symbol Decoder: {:.2f} ns/symbol",
+                 benchmark_symbol_decoder(true, num_symbols));
+
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include <gnuradio-4.0/Graph.hpp>
 #include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
 #include <gnuradio-4.0/packet-modem/message_debug.hpp>
+#include <gnuradio-4.0/packet-modem/noise_source.hpp>
 #include <gnuradio-4.0/packet-modem/null_sink.hpp>
 #include <gnuradio-4.0/packet-modem/null_source.hpp>
 #include <gnuradio-4.0/packet-modem/packet_receiver.hpp>
@@ -8,26 +10,112 @@
 #include <complex>
 #include <cstdint>
 #include <cstdlib>
+#include <string>
+#include <string_view>
+#include <variant>
+
+using c64 = std::complex<float>;
+
+// Connects the source to the packet receiver and to the Probe Rate, going
+// through a Head block if num_items is non-zero.
+template <typename Source>
+void connect_source(gr::Graph& fg,
+                    Source& source,
+                    uint64_t num_items,
+                    gr::packet_modem::PacketReceiver& packet_receiver,
+                    gr::packet_modem::ProbeRate<c64>& probe_rate)
+{
+    const char* connection_error = "connection_error";
+
+    if (num_items == 0) {
+        if (packet_receiver.connect_input(fg, source) != gr::ConnectionResult::SUCCESS) {
+            throw gr::exception(connection_error);
+        }
+        if (fg.connect<"out">(source).template to<"in">(probe_rate) !=
+            gr::ConnectionResult::SUCCESS) {
+            throw gr::exception(connection_error);
+        }
+        return;
+    }
+
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    if (fg.connect<"out">(source).template to<"in">(head) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (packet_receiver.connect_input(fg, head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(probe_rate) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+}
+
+[[noreturn]] void usage(const char* program)
+{
+    fmt::println(stderr,
+                 "usage: {} [--syncword-freq-bins N] [--syncword-threshold X] "
+                 "[--detection-mode MODE] [--noise-amplitude X] [--num-items N] "
+                 "[--load-shedding] [--feedforward-phase-estimation] "
+                 "[--fused-front-end]",
+                 program);
+    fmt::println(stderr, "");
+    fmt::println(stderr, "the default syncword freq bins is 4");
+    fmt::println(stderr, "the default syncword threshold is 9.5");
+    fmt::println(stderr, "the default detection mode is MEDIAN");
+    fmt::println(stderr, "the default noise amplitude is 0 (zeros input)");
+    fmt::println(stderr, "the default num items is 0 (run forever)");
+    fmt::println(stderr, "load shedding, feedforward phase estimation and fused");
+    fmt::println(stderr, "front end are disabled unless their flag is given");
+    std::exit(1);
+}
 
 int main(int argc, char** argv)
 {
-    using c64 = std::complex<float>;
+    int syncword_freq_bins = 4;
+    float syncword_threshold = 9.5f;
+    float noise_amplitude = 0.0f;
+    uint64_t num_items = 0;
+    gr::packet_modem::PacketReceiverOptions receiver_options;
 
-    if ((argc < 1) || (argc > 3)) {
-        fmt::println(
-            stderr, "usage: {} [syncword_freq_bins] [syncword_threshold]", argv[0]);
-        fmt::println(stderr, "");
-        fmt::println(stderr, "the default syncword freq bins is 4");
-        fmt::println(stderr, "the default syncword threshold is 9.5");
-        std::exit(1);
+    for (int j = 1; j < argc; ++j) {
+        const std::string_view flag = argv[j];
+        if (flag == "--load-shedding") {
+            receiver_options.load_shedding = true;
+            continue;
+        }
+        if (flag == "--feedforward-phase-estimation") {
+            receiver_options.feedforward_phase_estimation = true;
+            continue;
+        }
+        if (flag == "--fused-front-end") {
+            receiver_options.fused_front_end = true;
+            continue;
+        }
+        // the remaining flags take a value
+        if (j + 1 == argc) {
+            usage(argv[0]);
+        }
+        const char* value = argv[++j];
+        if (flag == "--syncword-freq-bins") {
+            syncword_freq_bins = std::stoi(value);
+        } else if (flag == "--syncword-threshold") {
+            syncword_threshold = std::stof(value);
+        } else if (flag == "--detection-mode") {
+            receiver_options.syncword_detection_mode = value;
+        } else if (flag == "--noise-amplitude") {
+            noise_amplitude = std::stof(value);
+        } else if (flag == "--num-items") {
+            num_items = std::stoull(value);
+        } else {
+            usage(argv[0]);
+        }
     }
-    const int syncword_freq_bins = argc >= 2 ? std::stoi(argv[1]) : 4;
-    const float syncword_threshold = argc >= 3 ? std::stof(argv[2]) : 9.5f;
 
     const size_t samples_per_symbol = 4U;
 
     gr::Graph fg;
-    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
     auto& probe_rate = fg.emplaceBlock<gr::packet_modem::ProbeRate<c64>>();
     auto& message_debug = fg.emplaceBlock<gr::packet_modem::MessageDebug>();
     const bool header_debug = false;
@@ -40,18 +128,21 @@ int main(int argc, char** argv)
                                                             zmq_output,
                                                             log,
                                                             syncword_freq_bins,
-                                                            syncword_threshold);
+                                                            syncword_threshold,
+                                                            receiver_options);
     auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<uint8_t>>();
 
+    if (noise_amplitude > 0.0f) {
+        auto& source = fg.emplaceBlock<gr::packet_modem::NoiseSource<c64>>(
+            { { "noise_type", "gaussian" }, { "amplitude", noise_amplitude } });
+        connect_source(fg, source, num_items, packet_receiver, probe_rate);
+    } else {
+        auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+        connect_source(fg, source, num_items, packet_receiver, probe_rate);
+    }
+
     const char* connection_error = "connection_error";
 
-    if (fg.connect<"out">(source).to<"in">(*packet_receiver.syncword_detection) !=
-        gr::ConnectionResult::SUCCESS) {
-        throw gr::exception(connection_error);
-    }
-    if (fg.connect<"out">(source).to<"in">(probe_rate) != gr::ConnectionResult::SUCCESS) {
-        throw gr::exception(connection_error);
-    }
     if (fg.connect<"rate">(probe_rate).to<"print">(message_debug) !=
         gr::ConnectionResult::SUCCESS) {
         throw gr::exception(connection_error);
@@ -69,5 +160,32 @@ int main(int argc, char** argv)
         std::exit(1);
     }
 
+    // Since the input does not contain any packets, all the syncword
+    // detections are false alarms. The latency saved by the CAUSAL detection
+    // mode is the difference between its output delay and the output delay of
+    // the MEDIAN detection mode.
+    std::visit(
+        [&](auto* syncword_detection) {
+            const uint64_t median_delay = 2 * syncword_detection->time_threshold + 1;
+            const uint64_t delay = syncword_detection->_output_delay;
+            fmt::println("detection mode: {}",
+                         receiver_options.syncword_detection_mode);
+            fmt::println("syncword false alarms: {} in {} samples",
+                          syncword_detection->_num_detections,
+                          num_items);
+            fmt::println("syncword detection delay: {} samples ({} samples saved "
+                         "with respect to MEDIAN)",
+                         delay,
+                         median_delay - delay);
+        },
+        packet_receiver.syncword_detection);
+    if (packet_receiver.load_governor != nullptr) {
+        const auto& governor = *packet_receiver.load_governor;
+        fmt::println("load governor: level {}, {} level changes, {} dropped samples",
+                     governor._level,
+                     governor._level_changes,
+                     governor._dropped_samples);
+    }
+
     return 0;
 }
@@ -15,21 +15,25 @@ int main(int argc, char** argv)
 {
     using c64 = std::complex<float>;
 
-    if ((argc < 2) || (argc > 5)) {
-        fmt::println(
-            stderr,
-            "usage: {} stream_mode [syncword_freq_bins] [syncword_threshold] [log]",
-            argv[0]);
+    if ((argc < 2) || (argc > 7)) {
+        fmt::println(stderr,
+                     "usage: {} stream_mode [syncword_freq_bins] [syncword_threshold] "
+                     "[log] [prediction_window] [cfo_tracking]",
+                     argv[0]);
         fmt::println(stderr, "");
         fmt::println(stderr, "the default syncword freq bins is 4");
         fmt::println(stderr, "the default syncword threshold is 9.5");
         fmt::println(stderr, "the default is log = 0");
+        fmt::println(stderr, "the default prediction window is 0 (disabled)");
+        fmt::println(stderr, "the default is cfo_tracking = 0");
         std::exit(1);
     }
     const bool stream_mode = std::stoi(argv[1]) != 0;
     const int syncword_freq_bins = argc >= 3 ? std::stoi(argv[2]) : 4;
     const float syncword_threshold = argc >= 4 ? std::stof(argv[3]) : 9.5f;
     const bool log = argc >= 5 ? std::stoi(argv[4]) : 0;
+    const uint64_t prediction_window = argc >= 6 ? std::stoull(argv[5]) : 0;
+    const bool cfo_tracking = argc >= 7 ? std::stoi(argv[6]) : 0;
 
     const size_t samples_per_symbol = 4U;
     const size_t packet_size = 1500UZ;
@@ -52,6 +56,10 @@ int main(int argc, char** argv)
     auto& message_debug = fg.emplaceBlock<gr::packet_modem::MessageDebug>();
     const bool header_debug = false;
     const bool zmq_output = false;
+    const gr::packet_modem::PacketReceiverOptions receiver_options = {
+        .syncword_prediction_window = prediction_window,
+        .syncword_cfo_tracking = cfo_tracking,
+    };
     auto packet_receiver = gr::packet_modem::PacketReceiver(fg,
                                                             samples_per_symbol,
                                                             "packet_len",
@@ -59,14 +67,14 @@ int main(int argc, char** argv)
                                                             zmq_output,
                                                             log,
                                                             syncword_freq_bins,
-                                                            syncword_threshold);
+                                                            syncword_threshold,
+                                                            receiver_options);
     auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<uint8_t>>();
 
     const char* connection_error = "connection_error";
 
     if (stream_mode) {
-        if (fg.connect<"out">(*packet_transmitter_pdu.rrc_interp)
-                .to<"in">(*packet_receiver.syncword_detection) !=
+        if (packet_receiver.connect_input(fg, *packet_transmitter_pdu.rrc_interp) !=
             gr::ConnectionResult::SUCCESS) {
             throw gr::exception(connection_error);
         }
@@ -85,8 +93,7 @@ int main(int argc, char** argv)
                 .to<"in">(packet_to_stream) != gr::ConnectionResult::SUCCESS) {
             throw gr::exception(connection_error);
         }
-        if (fg.connect<"out">(packet_to_stream)
-                .to<"in">(*packet_receiver.syncword_detection) !=
+        if (packet_receiver.connect_input(fg, packet_to_stream) !=
             gr::ConnectionResult::SUCCESS) {
             throw gr::exception(connection_error);
         }
@@ -0,0 +1,90 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/pfb_arb_resampler.hpp>
+#include <gnuradio-4.0/packet-modem/pfb_arb_taps.hpp>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+using c64 = std::complex<float>;
+
+// Runs num_items samples through a PFB Arbitrary Resampler block in a flowgraph
+// and reports the time per output sample. If rational is false, the resampler
+// is forced to use the arbitrary path even though the ratio is rational.
+void benchmark_flowgraph(size_t interpolation,
+                         size_t decimation,
+                         bool rational,
+                         uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    const double rate =
+        static_cast<double>(interpolation) / static_cast<double>(decimation);
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    using Resampler = gr::packet_modem::PfbArbResampler<c64, c64, float, double>;
+    gr::property_map settings = { { "taps", gr::packet_modem::pfb_arb_taps },
+                                  { "rate", rate },
+                                  { "detect_rational", false } };
+    if (rational) {
+        settings["interpolation"] = interpolation;
+        settings["decimation"] = decimation;
+    }
+    auto& resampler = fg.emplaceBlock<Resampler>(settings);
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(resampler) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(resampler).to<"in">(sink) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+
+    gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{ std::move(
+        fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    const double num_outputs = static_cast<double>(num_items) * rate;
+    fmt::println("{} path: {:.2f} ns/output, {:.2f} Msps input",
+                 rational ? "rational" : "arbitrary",
+                 ns / num_outputs,
+                 1e3 * static_cast<double>(num_items) / ns);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 1) || (argc > 4)) {
+        fmt::println(
+            stderr, "usage: {} [interpolation] [decimation] [num_items]", argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default interpolation is 3");
+        fmt::println(stderr, "the default decimation is 4");
+        fmt::println(stderr, "the default num items is 100000000");
+        std::exit(1);
+    }
+    const size_t interpolation = argc >= 2 ? std::stoul(argv[1]) : 3;
+    const size_t decimation = argc >= 3 ? std::stoul(argv[2]) : 4;
+    const uint64_t num_items = argc >= 4 ? std::stoull(argv[3]) : 100'000'000;
+
+    benchmark_flowgraph(interpolation, decimation, false, num_items);
+    benchmark_flowgraph(interpolation, decimation, true, num_items);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/costas_loop.hpp>
+#include <gnuradio-4.0/packet-modem/feedforward_phase_estimator.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/vector_sink.hpp>
+#include <gnuradio-4.0/packet-modem/vector_source.hpp>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using c64 = std::complex<float>;
+
+constexpr size_t syncword_size = 64;
+constexpr size_t header_size = 128;
+
+// Stream of packets as seen at the output of the Payload Metadata Insert block
+// in the packet receiver
+struct PacketStream {
+    std::vector<c64> symbols;
+    std::vector<c64> transmitted;
+    std::vector<gr::Tag> tags;
+    // start and size of the payload of each packet
+    std::vector<std::pair<size_t, size_t>> payloads;
+};
+
+// Generates num_packets packets with random QPSK headers and payloads of random
+// size, each of them with a random phase, the carrier frequency offset freq
+// (in radians per symbol), and AWGN for the given Es/N0. The syncword phase
+// estimate given to the Costas loop has a small error, as obtained from the
+// Syncword Detection block.
+PacketStream generate_packets(double esn0_db, size_t num_packets, double freq)
+{
+    PacketStream s;
+    std::default_random_engine e(0);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::uniform_real_distribution<double> phase_dist(-std::numbers::pi,
+                                                      std::numbers::pi);
+    std::uniform_int_distribution<size_t> payload_dist(100, 6000);
+    std::uniform_int_distribution<int> bits(0, 3);
+    const auto sigma =
+        static_cast<float>(std::sqrt(0.5 * std::pow(10.0, -esn0_db / 10.0)));
+    const float a = 1.0f / std::numbers::sqrt2_v<float>;
+    for (size_t p = 0; p < num_packets; ++p) {
+        double phase = phase_dist(e);
+        const size_t start = s.symbols.size();
+        const size_t payload_size = payload_dist(e);
+        s.tags.push_back({ static_cast<ssize_t>(start),
+                           { { "syncword_amplitude", 1.0f },
+                             { "syncword_phase", static_cast<float>(phase + 0.05) },
+                             { "constellation", std::string("PILOT") },
+                             { "loop_bandwidth", 0.02 } } });
+        s.tags.push_back({ static_cast<ssize_t>(start + syncword_size),
+                           { { "constellation", std::string("QPSK") },
+                             { "header_start", pmtv::pmt_null() },
+                             { "loop_bandwidth", 0.01 } } });
+        s.tags.push_back({ static_cast<ssize_t>(start + syncword_size + header_size),
+                           { { "payload_symbols", static_cast<uint64_t>(payload_size) },
+                             { "loop_bandwidth", 0.005 } } });
+        s.payloads.emplace_back(start + syncword_size + header_size, payload_size);
+        for (size_t j = 0; j < syncword_size + header_size + payload_size; ++j) {
+            c64 z{ 1.0f, 0.0f };
+            if (j >= syncword_size) {
+                const int n = bits(e);
+                z = c64{ n % 2 == 0 ? a : -a, n / 2 == 0 ? a : -a };
+            }
+            s.transmitted.push_back(z);
+            s.symbols.push_back(z * std::polar(1.0f, static_cast<float>(phase)) +
+                                sigma * c64{ noise(e), noise(e) });
+            phase += freq;
+        }
+    }
+    return s;
+}
+
+template <typename Block>
+std::vector<c64> run_stream(const PacketStream& s)
+{
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::VectorSource<c64>>();
+    source.data = s.symbols;
+    source.tags = s.tags;
+    auto& block = fg.emplaceBlock<Block>();
+    auto& sink = fg.emplaceBlock<gr::packet_modem::VectorSink<c64>>();
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(block) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(block).to<"in">(sink) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    gr::scheduler::Simple sched{ std::move(fg) };
+    const auto ret = sched.runAndWait();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    return sink.data();
+}
+
+// Counts the QPSK symbol errors and the packets with at least one payload
+// symbol error. The FEC of the payload is not taken into account, so this
+// packet error rate is an upper bound.
+std::pair<double, double> error_rates(const PacketStream& s, const std::vector<c64>& out)
+{
+    if (out.size() != s.symbols.size()) {
+        fmt::println("output size mismatch");
+        std::exit(1);
+    }
+    const auto same_quadrant = [](c64 a, c64 b) {
+        return (a.real() > 0) == (b.real() > 0) && (a.imag() > 0) == (b.imag() > 0);
+    };
+    size_t symbol_errors = 0;
+    size_t num_symbols = 0;
+    size_t packet_errors = 0;
+    for (const auto& [start, size] : s.payloads) {
+        size_t errors = 0;
+        for (size_t j = start; j < start + size; ++j) {
+            errors += !same_quadrant(out[j], s.transmitted[j]);
+        }
+        symbol_errors += errors;
+        num_symbols += size;
+        packet_errors += errors > 0;
+    }
+    return { static_cast<double>(symbol_errors) / static_cast<double>(num_symbols),
+             static_cast<double>(packet_errors) /
+                 static_cast<double>(s.payloads.size()) };
+}
+
+// Measures the throughput of a phase recovery block with a QPSK input without
+// tags
+template <typename Block>
+double throughput(uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    auto& block = fg.emplaceBlock<Block>({ { "constellation", std::string("QPSK") } });
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(block) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(block).to<"in">(sink) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{ std::move(
+        fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+           static_cast<double>(num_items);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 1) || (argc > 6)) {
+        fmt::println(stderr,
+                     "usage: {} [esn0_min] [esn0_max] [freq] [num_packets] [num_items]",
+                     argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default Es/N0 range is 2 to 12 dB");
+        fmt::println(stderr, "the default frequency offset is 1e-4 rad/symbol");
+        fmt::println(stderr, "the default num packets is 1000");
+        fmt::println(stderr, "the default num items is 100000000");
+        std::exit(1);
+    }
+    const double esn0_min = argc >= 2 ? std::stod(argv[1]) : 2.0;
+    const double esn0_max = argc >= 3 ? std::stod(argv[2]) : 12.0;
+    const double freq = argc >= 4 ? std::stod(argv[3]) : 1e-4;
+    const size_t num_packets = argc >= 5 ? std::stoul(argv[4]) : 1000;
+    const uint64_t num_items = argc >= 6 ? std::stoull(argv[5]) : 100'000'000;
+
+    using Costas = gr::packet_modem::CostasLoop<>;
+    using Feedforward = gr::packet_modem::FeedforwardPhaseEstimator<>;
+    fmt::println("Es/N0 (dB) | Costas SER  PER   | feedforward SER  PER");
+    for (double esn0 = esn0_min; esn0 <= esn0_max; esn0 += 1.0) {
+        const auto s = generate_packets(esn0, num_packets, freq);
+        const auto [ser_costas, per_costas] = error_rates(s, run_stream<Costas>(s));
+        const auto [ser_ff, per_ff] = error_rates(s, run_stream<Feedforward>(s));
+        fmt::println("{:10.1f} | {:10.2e} {:5.3f} | {:15.2e} {:5.3f}",
+                     esn0,
+                     ser_costas,
+                     per_costas,
+                     ser_ff,
+                     per_ff);
+    }
+
+    fmt::println("Costas loop: {:.2f} ns/symbol", throughput<Costas>(num_items));
+    fmt::println("feedforward phase estimator: {:.2f} ns/symbol",
+                 throughput<Feedforward>(num_items));
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/coarse_frequency_correction.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
+#include <gnuradio-4.0/packet-modem/nco.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/rotator.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using c64 = std::complex<float>;
+
+// Measures the time per sample of the rotation loop, using the implementation
+// that the Rotator and Coarse Frequency Correction blocks used to have, which
+// multiplied a single phasor by the phase increment for each sample, and the
+// NCO kernel.
+void benchmark_kernel(float phase_incr, uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    const size_t chunk_size = 1UZ << 16;
+    std::vector<c64> input(chunk_size);
+    std::default_random_engine e(0);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (auto& x : input) {
+        x = c64{ dist(e), dist(e) };
+    }
+    std::vector<c64> output(chunk_size);
+    const uint64_t num_chunks = std::max(uint64_t{ 1 }, num_items / chunk_size);
+
+    const auto report = [&](const char* name, clock::duration elapsed, c64 check) {
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        fmt::println("{}: {:.2f} ns/sample (checksum {})",
+                     name,
+                     ns / static_cast<double>(num_chunks * chunk_size),
+                     std::abs(check));
+    };
+
+    c64 exp = { 1.0f, 0.0f };
+    const c64 exp_incr = { std::cos(phase_incr), std::sin(phase_incr) };
+    unsigned counter = 0;
+    c64 check{};
+    auto t0 = clock::now();
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        for (size_t j = 0; j < chunk_size; ++j) {
+            output[j] = input[j] * exp;
+            exp *= exp_incr;
+            if ((++counter % 512) == 0) {
+                exp /= std::abs(exp);
+            }
+        }
+        check += output[0];
+    }
+    report("single phasor, sample by sample (before)", clock::now() - t0, check);
+
+    gr::packet_modem::Nco<float> nco(0.0, static_cast<double>(phase_incr));
+    check = c64{};
+    t0 = clock::now();
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        nco.rotate(input.data(), output.data(), chunk_size);
+        check += output[0];
+    }
+    report("NCO, blocks of phasors (after)", clock::now() - t0, check);
+}
+
+// Runs num_items samples through a Rotator or a Coarse Frequency Correction
+// block in a flowgraph and reports the time per sample
+template <typename Block>
+void benchmark_flowgraph(const char* name, float phase_incr, uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    gr::property_map settings;
+    if constexpr (std::is_same_v<Block, gr::packet_modem::Rotator<>>) {
+        settings["phase_incr"] = phase_incr;
+    }
+    auto& block = fg.emplaceBlock<Block>(settings);
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(block) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(block).to<"in">(sink) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+
+    gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{ std::move(
+        fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    fmt::println("{} flowgraph: {:.2f} ns/sample, {:.2f} Msps",
+                 name,
+                 ns / static_cast<double>(num_items),
+                 1e3 * static_cast<double>(num_items) / ns);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 1) || (argc > 3)) {
+        fmt::println(stderr, "usage: {} [phase_incr] [num_items]", argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default phase increment is 0.1 rad/sample");
+        fmt::println(stderr, "the default num items is 100000000");
+        std::exit(1);
+    }
+    const float phase_incr = argc >= 2 ? std::stof(argv[1]) : 0.1f;
+    const uint64_t num_items = argc >= 3 ? std::stoull(argv[2]) : 100'000'000;
+
+    benchmark_kernel(phase_incr, num_items);
+    benchmark_flowgraph<gr::packet_modem::Rotator<>>("Rotator", phase_incr, num_items);
+    benchmark_flowgraph<gr::packet_modem::CoarseFrequencyCorrection<>>(
+        "Coarse Frequency Correction", phase_incr, num_items);
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/HistoryBuffer.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/dot_product.hpp>
+#include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/symbol_filter.hpp>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+
+using c64 = std::complex<float>;
+
+// PFB RRC taps with the same parameters as in the packet receiver
+std::vector<float> symbol_filter_taps(size_t samples_per_symbol, size_t num_arms)
+{
+    auto taps = gr::packet_modem::firdes::root_raised_cosine(
+        static_cast<double>(num_arms),
+        static_cast<double>(num_arms * samples_per_symbol),
+        1.0,
+        0.35,
+        num_arms * samples_per_symbol * 11U);
+    taps.pop_back();
+    return taps;
+}
+
+// Measures the time per output symbol of the filtering loop of the Symbol
+// Filter, using the implementation that the block used to have, which pushed
+// each input sample to a HistoryBuffer and computed std::inner_product over its
+// circular iterators, and the current implementation, which keeps a linear
+// history and only computes the dot product for the samples that produce an
+// output.
+void benchmark_kernel(size_t samples_per_symbol, uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    const size_t num_arms = 32;
+    const auto taps = symbol_filter_taps(samples_per_symbol, num_arms);
+    const size_t arm = num_arms / 2;
+    std::vector<float> arm_taps;
+    for (size_t k = arm; k < taps.size(); k += num_arms) {
+        arm_taps.push_back(taps[k]);
+    }
+    const size_t arm_size = arm_taps.size();
+
+    const size_t chunk_size = 1UZ << 16;
+    std::vector<c64> input(chunk_size);
+    std::default_random_engine e(0);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (auto& x : input) {
+        x = c64{ dist(e), dist(e) };
+    }
+    std::vector<c64> output(chunk_size / samples_per_symbol + 1);
+    const uint64_t num_chunks = std::max(uint64_t{ 1 }, num_items / chunk_size);
+    const uint64_t num_symbols = num_chunks * (chunk_size / samples_per_symbol);
+
+    const auto report = [&](const char* name, clock::duration elapsed, c64 check) {
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        fmt::println("{}: {:.2f} ns/symbol (checksum {})",
+                     name,
+                     ns / static_cast<double>(num_symbols),
+                     std::abs(check));
+    };
+
+    gr::HistoryBuffer<c64> history(std::bit_ceil(arm_size));
+    size_t clock_phase = 0;
+    c64 check{};
+    auto t0 = clock::now();
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        auto out_item = output.begin();
+        for (const c64 x : input) {
+            history.push_back(x);
+            if (clock_phase == 0) {
+                *out_item++ = std::inner_product(
+                    arm_taps.cbegin(), arm_taps.cend(), history.cbegin(), c64{});
+            }
+            if (++clock_phase >= samples_per_symbol) {
+                clock_phase = 0;
+            }
+        }
+        check += output[0];
+    }
+    report("HistoryBuffer, sample by sample (before)", clock::now() - t0, check);
+
+    // the taps are reversed, so that the dot product goes forward in time
+    const std::vector<float> reversed_taps(arm_taps.rbegin(), arm_taps.rend());
+    std::vector<c64> linear_history(arm_size - 1);
+    check = c64{};
+    t0 = clock::now();
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t history_size = linear_history.size();
+        linear_history.insert(linear_history.end(), input.cbegin(), input.cend());
+        auto out_item = output.begin();
+        for (size_t k = 0; k < chunk_size; k += samples_per_symbol) {
+            *out_item++ = gr::packet_modem::dot_product<c64>(
+                &linear_history[history_size + k + 1 - arm_size],
+                reversed_taps.data(),
+                arm_size);
+        }
+        linear_history.erase(linear_history.begin(),
+                             linear_history.end() - static_cast<ssize_t>(history_size));
+        check += output[0];
+    }
+    report("linear history, decimated outputs (after)", clock::now() - t0, check);
+}
+
+// Runs num_items samples through a Symbol Filter block in a flowgraph and
+// reports the time per output symbol
+void benchmark_flowgraph(size_t samples_per_symbol, uint64_t num_items)
+{
+    using clock = std::chrono::steady_clock;
+
+    const size_t num_arms = 32;
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    using SymbolFilter = gr::packet_modem::SymbolFilter<c64, c64, float>;
+    auto& symbol_filter = fg.emplaceBlock<SymbolFilter>(
+        { { "taps", symbol_filter_taps(samples_per_symbol, num_arms) },
+          { "num_arms", num_arms },
+          { "samples_per_symbol", samples_per_symbol } });
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(symbol_filter) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(symbol_filter).to<"in">(sink) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+
+    gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{ std::move(
+        fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    const double num_symbols =
+        static_cast<double>(num_items) / static_cast<double>(samples_per_symbol);
+    fmt::println("flowgraph: {:.2f} ns/symbol, {:.2f} Msps input",
+                 ns / num_symbols,
+                 1e3 * static_cast<double>(num_items) / ns);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 1) || (argc > 3)) {
+        fmt::println(stderr, "usage: {} [samples_per_symbol] [num_items]", argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default samples per symbol is 4");
+        fmt::println(stderr, "the default num items is 100000000");
+        std::exit(1);
+    }
+    const size_t samples_per_symbol = argc >= 2 ? std::stoul(argv[1]) : 4;
+    const uint64_t num_items = argc >= 3 ? std::stoull(argv[2]) : 100'000'000;
+
+    benchmark_kernel(samples_per_symbol, num_items);
+    benchmark_flowgraph(samples_per_symbol, num_items);
+
+    return 0;
+}
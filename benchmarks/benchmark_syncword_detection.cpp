@@ -1,35 +1,135 @@
 #include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/HistoryBuffer.hpp>
 #include <gnuradio-4.0/Scheduler.hpp>
 #include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/head.hpp>
 #include <gnuradio-4.0/packet-modem/message_debug.hpp>
 #include <gnuradio-4.0/packet-modem/null_sink.hpp>
 #include <gnuradio-4.0/packet-modem/null_source.hpp>
 #include <gnuradio-4.0/packet-modem/probe_rate.hpp>
 #include <gnuradio-4.0/packet-modem/syncword_detection.hpp>
+#include <chrono>
 #include <complex>
 #include <cstdint>
 #include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
 
-int main(int argc, char** argv)
-{
+// Items that SyncwordDetection used to keep in its history, one per input
+// sample
+struct HistoryItem {
     using c64 = std::complex<float>;
+    c64 sample;
+    float correlation_power;
+    float correlation_power_left;
+    float correlation_power_right;
+    c64 correlation;
+    int freq_bin;
+    float fft_noise_power;
+    bool detection = false;
+};
 
-    if ((argc < 1) || (argc > 3)) {
-        fmt::println(
-            stderr, "usage: {} [syncword_freq_bins] [syncword_threshold]", argv[0]);
-        fmt::println(stderr, "");
-        fmt::println(stderr, "the default syncword freq bins is 4");
-        fmt::println(stderr, "the default syncword threshold is 9.5");
-        std::exit(1);
+// Replays the peak search done by SyncwordDetection over exponentially
+// distributed correlation powers (which is the distribution of the correlation
+// power of noise) and measures the time spent in the check of the median
+// threshold. The check is done both by scanning the HistoryItem's in a
+// HistoryBuffer, which is how the block used to do it, and with the
+// PowerHistory used by the block.
+void benchmark_threshold(float syncword_threshold)
+{
+    using clock = std::chrono::steady_clock;
+    using gr::packet_modem::syncword_detection::PowerHistory;
+
+    const uint64_t time_threshold = 768;
+    const size_t history_size = 2 * time_threshold + 1;
+    const size_t num_samples = 1UZ << 24;
+    std::vector<float> powers(num_samples);
+    std::default_random_engine e(0);
+    std::exponential_distribution<float> dist(1.0f);
+    for (auto& x : powers) {
+        x = dist(e);
     }
-    const int syncword_freq_bins = argc >= 2 ? std::stoi(argv[1]) : 4;
-    const float syncword_threshold = argc >= 3 ? std::stof(argv[2]) : 9.5f;
 
-    const size_t samples_per_symbol = 4U;
+    const auto run = [&](auto&& count_below, auto&& push_back) {
+        float best = 0.0f;
+        uint64_t best_idx = 0;
+        size_t checks = 0;
+        size_t detections = 0;
+        clock::duration elapsed{};
+        for (const uint64_t curr_idx : std::views::iota(0UZ, num_samples)) {
+            if (curr_idx - best_idx > time_threshold) {
+                const auto t0 = clock::now();
+                const size_t below_threshold = count_below(best / syncword_threshold);
+                elapsed += clock::now() - t0;
+                ++checks;
+                if (2 * below_threshold >= history_size) {
+                    ++detections;
+                }
+                best = 0.0f;
+                best_idx = curr_idx;
+            }
+            const float power = powers[curr_idx];
+            if (power > best) {
+                best = power;
+                best_idx = curr_idx;
+            }
+            push_back(power);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        fmt::println("  checks = {}, detections = {}, {:.1f} ns/check, {:.3f} ns/sample",
+                     checks,
+                     detections,
+                     ns / static_cast<double>(checks),
+                     ns / static_cast<double>(num_samples));
+    };
 
-    gr::Graph fg;
-    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    fmt::println("HistoryBuffer<HistoryItem> scan:");
+    gr::HistoryBuffer<HistoryItem> history(std::bit_ceil(history_size + 1));
+    run(
+        [&](float threshold) {
+            size_t below_threshold = 0;
+            for (const size_t u : std::views::iota(0UZ, history_size)) {
+                if (history[u].correlation_power < threshold) {
+                    ++below_threshold;
+                }
+            }
+            return below_threshold;
+        },
+        [&](float power) {
+            HistoryItem item;
+            item.correlation_power = power;
+            history.push_back(item);
+        });
 
+    fmt::println("PowerHistory:");
+    PowerHistory power_history;
+    power_history.reset(history_size);
+    run([&](float threshold) { return power_history.count_below(threshold); },
+        [&](float power) { power_history.push_back(power); });
+}
+
+// Command line arguments
+struct Options {
+    int syncword_freq_bins = 4;
+    float syncword_threshold = 9.5f;
+    std::string mode = "flowgraph";
+    std::string search_mode = "FULL";
+    size_t decimation = 1;
+    size_t num_threads = 1;
+    std::string fft_backend = "FFTW";
+    std::string fftw_planner = "ESTIMATE";
+    std::string fftw_wisdom_file;
+    size_t num_syncwords = 1;
+    float energy_gate_threshold = 0.0f;
+};
+
+// Settings of the Syncword Detection block used in the benchmarks
+gr::property_map syncword_detection_settings(const Options& options)
+{
+    using c64 = std::complex<float>;
+
+    const size_t samples_per_symbol = 4U;
     const std::vector<uint8_t> syncword = {
         uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 },
         uint8_t{ 0 }, uint8_t{ 1 }, uint8_t{ 1 }, uint8_t{ 0 }, uint8_t{ 1 },
@@ -61,13 +161,241 @@ int main(int argc, char** argv)
         x /= rrc_taps_norm;
     }
     const std::vector<c64> bpsk_constellation = { { 1.0f, 0.0f }, { -1.0f, 0.0f } };
-    auto& syncword_detection = fg.emplaceBlock<gr::packet_modem::SyncwordDetection>(
-        { { "rrc_taps", rrc_taps },
-          { "syncword", syncword },
-          { "constellation", bpsk_constellation },
-          { "min_freq_bin", -syncword_freq_bins },
-          { "max_freq_bin", syncword_freq_bins },
-          { "power_threshold", syncword_threshold } });
+    // the same syncword is repeated to obtain the computational cost of
+    // detecting several syncwords
+    std::vector<uint8_t> syncwords;
+    for (size_t j = 0; j < options.num_syncwords; ++j) {
+        syncwords.insert(syncwords.end(), syncword.begin(), syncword.end());
+    }
+    return { { "rrc_taps", rrc_taps },
+             { "syncword", syncwords },
+             { "num_syncwords", options.num_syncwords },
+             { "constellation", bpsk_constellation },
+             { "min_freq_bin", -options.syncword_freq_bins },
+             { "max_freq_bin", options.syncword_freq_bins },
+             { "power_threshold", options.syncword_threshold },
+             { "search_mode", options.search_mode },
+             { "decimation", options.decimation },
+             // keep the same FFT duration regardless of decimation
+             { "fft_size", 2048UZ / options.decimation },
+             { "num_threads", options.num_threads },
+             { "fft_backend", options.fft_backend },
+             { "fftw_planner", options.fftw_planner },
+             { "fftw_wisdom_file", options.fftw_wisdom_file },
+             { "energy_gate_threshold", options.energy_gate_threshold } };
+}
+
+// Runs a short flowgraph several times and reports the time spent by the
+// Syncword Detection block in start(). Only the first run has to compute the
+// FFTs of the syncword templates, and only the first run ever with a given
+// wisdom file needs to measure the FFTW plans.
+void benchmark_startup(const Options& options)
+{
+    using c64 = std::complex<float>;
+
+    const int num_runs = 5;
+    for (const int run : std::views::iota(0, num_runs)) {
+        gr::Graph fg;
+        auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+        auto& head = fg.emplaceBlock<gr::packet_modem::Head<c64>>(
+            { { "num_items", uint64_t{ 1'000'000 } } });
+        auto& syncword_detection = fg.emplaceBlock<gr::packet_modem::SyncwordDetection<>>(
+            syncword_detection_settings(options));
+        auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+
+        const char* connection_error = "connection_error";
+        if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+            throw gr::exception(connection_error);
+        }
+        if (fg.connect<"out">(head).to<"in">(syncword_detection) !=
+            gr::ConnectionResult::SUCCESS) {
+            throw gr::exception(connection_error);
+        }
+        if (fg.connect<"out">(syncword_detection).to<"in">(sink) !=
+            gr::ConnectionResult::SUCCESS) {
+            throw gr::exception(connection_error);
+        }
+
+        gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{
+            std::move(fg)
+        };
+        const auto ret = sched.runAndWait();
+        if (!ret.has_value()) {
+            fmt::println("scheduler error: {}", ret.error());
+            std::exit(1);
+        }
+        fmt::println("run {}: startup time = {:.3f} ms",
+                     run,
+                     1e3 * syncword_detection._startup_time_secs);
+    }
+}
+
+// Runs num_items samples through a Syncword Detection block and returns the
+// sample rate in samples per second
+template <typename SyncwordDetection>
+double measure_rate(const Options& options, uint64_t num_items)
+{
+    using c64 = std::complex<float>;
+    using clock = std::chrono::steady_clock;
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& head =
+        fg.emplaceBlock<gr::packet_modem::Head<c64>>({ { "num_items", num_items } });
+    auto& syncword_detection =
+        fg.emplaceBlock<SyncwordDetection>(syncword_detection_settings(options));
+    auto& sink = fg.emplaceBlock<gr::packet_modem::NullSink<c64>>();
+
+    const char* connection_error = "connection_error";
+    if (fg.connect<"out">(source).to<"in">(head) != gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(head).to<"in">(syncword_detection) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+    if (fg.connect<"out">(syncword_detection).to<"in">(sink) !=
+        gr::ConnectionResult::SUCCESS) {
+        throw gr::exception(connection_error);
+    }
+
+    gr::scheduler::Simple<gr::scheduler::ExecutionPolicy::multiThreaded> sched{ std::move(
+        fg) };
+    const auto t0 = clock::now();
+    const auto ret = sched.runAndWait();
+    const auto t1 = clock::now();
+    if (!ret.has_value()) {
+        fmt::println("scheduler error: {}", ret.error());
+        std::exit(1);
+    }
+    const double elapsed = std::chrono::duration<double>(t1 - t0).count();
+    return static_cast<double>(num_items) / elapsed;
+}
+
+// Runs a fixed number of samples through the Syncword Detection block with an
+// increasing number of threads and reports the sample rate for each of them.
+void benchmark_threads(Options options)
+{
+    const uint64_t num_items = 100'000'000;
+    const size_t max_threads = std::max(1U, std::thread::hardware_concurrency());
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        options.num_threads = num_threads;
+        const double rate =
+            measure_rate<gr::packet_modem::SyncwordDetection<>>(options, num_items);
+        fmt::println("num_threads = {}: {:.2f} Msps", num_threads, 1e-6 * rate);
+    }
+}
+
+// Compares the sample rate of the runtime version of the Syncword Detection
+// block with the variant specialised at compile time for the default
+// parameters, which is the one used by the packet receiver.
+void benchmark_fixed(const Options& options)
+{
+    if (options.syncword_freq_bins != 4 || options.decimation != 1) {
+        fmt::println(stderr,
+                     "the fixed mode requires 4 syncword freq bins and no decimation");
+        std::exit(1);
+    }
+    const uint64_t num_items = 100'000'000;
+    const double runtime_rate =
+        measure_rate<gr::packet_modem::SyncwordDetection<>>(options, num_items);
+    fmt::println("runtime: {:.2f} Msps", 1e-6 * runtime_rate);
+    const double fixed_rate =
+        measure_rate<gr::packet_modem::SyncwordDetection<2048, 9, 4>>(options, num_items);
+    fmt::println("fixed: {:.2f} Msps", 1e-6 * fixed_rate);
+}
+
+int main(int argc, char** argv)
+{
+    using c64 = std::complex<float>;
+
+    if ((argc < 1) || (argc > 12)) {
+        fmt::println(stderr,
+                     "usage: {} [syncword_freq_bins] [syncword_threshold] [mode] "
+                     "[search_mode] [decimation] [num_threads] [fft_backend] "
+                     "[fftw_planner] [fftw_wisdom_file] [num_syncwords] "
+                     "[energy_gate_threshold]",
+                     argv[0]);
+        fmt::println(stderr, "");
+        fmt::println(stderr, "the default syncword freq bins is 4");
+        fmt::println(stderr, "the default syncword threshold is 9.5");
+        fmt::println(stderr,
+                     "mode can be \"flowgraph\" (default), \"threshold\", which "
+                     "measures only the median threshold check, \"threads\", "
+                     "which measures the scaling with the number of threads, "
+                     "\"startup\", which measures the startup time, or \"fixed\", "
+                     "which compares the runtime and the specialised variants");
+        fmt::println(stderr,
+                     "search_mode can be \"FULL\" (default) or \"TWO_STAGE\"");
+        fmt::println(stderr, "the default decimation is 1");
+        fmt::println(stderr, "the default num_threads is 1");
+        fmt::println(stderr,
+                     "fft_backend can be \"FFTW\" (default) or \"MIXED_RADIX\"");
+        fmt::println(stderr,
+                     "fftw_planner can be \"ESTIMATE\" (default), \"MEASURE\" or "
+                     "\"PATIENT\"");
+        fmt::println(stderr, "by default no FFTW wisdom file is used");
+        fmt::println(stderr, "the default num_syncwords is 1");
+        fmt::println(stderr,
+                     "the default energy_gate_threshold is 0 (energy gate disabled)");
+        std::exit(1);
+    }
+    Options options;
+    if (argc >= 2) {
+        options.syncword_freq_bins = std::stoi(argv[1]);
+    }
+    if (argc >= 3) {
+        options.syncword_threshold = std::stof(argv[2]);
+    }
+    if (argc >= 4) {
+        options.mode = argv[3];
+    }
+    if (argc >= 5) {
+        options.search_mode = argv[4];
+    }
+    if (argc >= 6) {
+        options.decimation = std::stoul(argv[5]);
+    }
+    if (argc >= 7) {
+        options.num_threads = std::stoul(argv[6]);
+    }
+    if (argc >= 8) {
+        options.fft_backend = argv[7];
+    }
+    if (argc >= 9) {
+        options.fftw_planner = argv[8];
+    }
+    if (argc >= 10) {
+        options.fftw_wisdom_file = argv[9];
+    }
+    if (argc >= 11) {
+        options.num_syncwords = std::stoul(argv[10]);
+    }
+    if (argc >= 12) {
+        options.energy_gate_threshold = std::stof(argv[11]);
+    }
+
+    if (options.mode == "threshold") {
+        benchmark_threshold(options.syncword_threshold);
+        return 0;
+    } else if (options.mode == "threads") {
+        benchmark_threads(options);
+        return 0;
+    } else if (options.mode == "startup") {
+        benchmark_startup(options);
+        return 0;
+    } else if (options.mode == "fixed") {
+        benchmark_fixed(options);
+        return 0;
+    } else if (options.mode != "flowgraph") {
+        fmt::println(stderr, "unknown mode {}", options.mode);
+        std::exit(1);
+    }
+
+    gr::Graph fg;
+    auto& source = fg.emplaceBlock<gr::packet_modem::NullSource<c64>>();
+    auto& syncword_detection = fg.emplaceBlock<gr::packet_modem::SyncwordDetection<>>(
+        syncword_detection_settings(options));
 
     auto& probe_rate = fg.emplaceBlock<gr::packet_modem::ProbeRate<c64>>();
     auto& message_debug = fg.emplaceBlock<gr::packet_modem::MessageDebug>();
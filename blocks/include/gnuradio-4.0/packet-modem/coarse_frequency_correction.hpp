@@ -12,7 +12,9 @@
 #define _GR4_PACKET_MODEM_COARSE_FREQUENCY_CORRECTION
 
 #include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/nco.hpp>
 #include <gnuradio-4.0/reflection.hpp>
+#include <algorithm>
 #include <complex>
 
 namespace gr::packet_modem {
@@ -37,9 +39,7 @@ phase is not reset to zero, but rather to the new frequency times the delay.
 )"">;
 
 public:
-    std::complex<T> _exp = { T{ 1 }, T{ 0 } };
-    std::complex<T> _exp_incr = { T{ 1 }, T{ 0 } };
-    unsigned _counter = 0;
+    Nco<T> _nco;
     size_t delay = 0;
     float _next_freq = 0.0f;
     ssize_t _next_freq_delay = 0;
@@ -52,10 +52,8 @@ private:
 #ifdef TRACE
         fmt::println("{}::set_freq({})", this->name, freq);
 #endif
-        _exp = { static_cast<T>(std::cos(freq * static_cast<float>(delay))),
-                 static_cast<T>(-std::sin(freq * static_cast<float>(delay))) };
-        _exp_incr = { static_cast<T>(std::cos(freq)), static_cast<T>(-std::sin(freq)) };
-        _counter = 0;
+        _nco.set(-static_cast<double>(freq) * static_cast<double>(delay),
+                 -static_cast<double>(freq));
     }
 
 public:
@@ -80,19 +78,22 @@ public:
                 _next_freq_delay = static_cast<ssize_t>(delay);
             }
         }
-        for (size_t j = 0; j < inSpan.size(); ++j) {
+        // The span is split at the sample where the new frequency is applied,
+        // so that the NCO rotates each part with a constant frequency
+        const size_t n = inSpan.size();
+        size_t j = 0;
+        while (j < n) {
             if (_next_freq_delay == 0) {
                 set_freq(_next_freq);
+                _next_freq_delay = -1;
             }
-            outSpan[j] = inSpan[j] * _exp;
-            _exp *= _exp_incr;
-            if ((++_counter % 512) == 0) {
-                // normalize to unit amplitude
-                _exp /= std::abs(_exp);
-            }
-            if (_next_freq_delay >= 0) {
-                --_next_freq_delay;
+            size_t m = n - j;
+            if (_next_freq_delay > 0) {
+                m = std::min(m, static_cast<size_t>(_next_freq_delay));
+                _next_freq_delay -= static_cast<ssize_t>(m);
             }
+            _nco.rotate(inSpan.data() + j, outSpan.data() + j, m);
+            j += m;
         }
         return gr::work::Status::OK;
     }
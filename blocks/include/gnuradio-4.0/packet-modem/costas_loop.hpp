@@ -3,24 +3,23 @@
 
 #include <gnuradio-4.0/Block.hpp>
 #include <gnuradio-4.0/packet-modem/constellation.hpp>
+#include <gnuradio-4.0/packet-modem/sincos.hpp>
 #include <gnuradio-4.0/reflection.hpp>
 #include <magic_enum.hpp>
 #include <cmath>
 #include <complex>
+#include <cstdlib>
 #include <numbers>
 #include <ranges>
 
 namespace gr::packet_modem {
 
+// Second-order Costas loop. This contains the state and the per-symbol
+// processing of the loop, so that it can be used both by the Costas Loop block
+// and by the Fused Symbol Decoder block.
 template <typename T = float, typename TPhase = float>
-class CostasLoop : public gr::Block<CostasLoop<T, TPhase>>
+class CostasLoopCore
 {
-public:
-    using Description = Doc<R""(
-@brief Costas Loop.
-
-)"">;
-
 public:
     TPhase _phase = 0;
     TPhase _freq = 0;
@@ -28,39 +27,17 @@ public:
     T _k1 = 0;
     T _k2 = 0;
 
-private:
-    static constexpr char syncword_phase_key[] = "syncword_phase";
-    static constexpr char constellation_key[] = "constellation";
-
     void set_phase(TPhase phase)
     {
-#ifdef TRACE
-        fmt::println("{}::set_phase({})", this->name, phase);
-#endif
         _phase = phase;
         _freq = 0;
     }
 
-public:
-    gr::PortIn<std::complex<T>> in;
-    gr::PortOut<std::complex<T>> out;
-    // B_L * T loop bandwidth parameter
-    double loop_bandwidth = 0.01;
-    Constellation _constellation = Constellation::BPSK;
-    std::string constellation{ magic_enum::enum_name(_constellation) };
-
-    void settingsChanged(const gr::property_map& /* old_settings */,
-                         const gr::property_map& /* new_settings */)
+    // Computes the loop coefficients for a B_L * T loop bandwidth
+    void set_loop_bandwidth(double loop_bandwidth, Constellation constellation)
     {
-#ifdef TRACE
-        fmt::println(
-            "{}::settingsChanged() constellation = {}", this->name, constellation);
-#endif
-        _constellation = magic_enum::enum_cast<Constellation>(
-                             constellation, magic_enum::case_insensitive)
-                             .value();
         double discriminant_gain = 1.0;
-        if (_constellation == Constellation::QPSK) {
+        if (constellation == Constellation::QPSK) {
             discriminant_gain = std::numbers::sqrt2;
         }
 
@@ -80,13 +57,126 @@ public:
             (std::cbrt(2.0) * s) / (std::cbrt(9.0) * (2.0 * loop_bandwidth + 1.0)) - 1.0;
         const double k1 = 1.0 - z * z;
         const double k2 = (1.0 - z) * (1.0 - z);
-#ifdef TRACE
-        fmt::println("{} k1 = {}, k2 = {}", this->name, k1, k2);
-#endif
         _k1 = static_cast<T>(k1 / discriminant_gain);
         _k2 = static_cast<T>(k2 / discriminant_gain);
     }
 
+    // Corrects the phase of n symbols. The constellation can only change
+    // between calls, so the loop is specialized for each constellation.
+    void process(Constellation constellation,
+                 const std::complex<T>* in,
+                 std::complex<T>* out,
+                 size_t n)
+    {
+        switch (constellation) {
+        case Constellation::PILOT:
+            process<Constellation::PILOT>(in, out, n);
+            break;
+        case Constellation::BPSK:
+            process<Constellation::BPSK>(in, out, n);
+            break;
+        case Constellation::QPSK:
+            process<Constellation::QPSK>(in, out, n);
+            break;
+        default:
+            // should not be reached
+            abort();
+        }
+    }
+
+private:
+    template <Constellation constellation_type>
+    void process(const std::complex<T>* in, std::complex<T>* out, size_t n)
+    {
+        TPhase phase = _phase;
+        TPhase freq = _freq;
+        for (const auto j : std::views::iota(0UZ, n)) {
+            // multiply by conj(lo), avoiding the checks for infinities and
+            // NaNs of the std::complex product
+            const std::complex<T> lo = fast_expj(static_cast<T>(phase));
+            const std::complex<T> z_in = in[j];
+            const std::complex<T> z_out = {
+                z_in.real() * lo.real() + z_in.imag() * lo.imag(),
+                z_in.imag() * lo.real() - z_in.real() * lo.imag()
+            };
+            out[j] = z_out;
+            T error;
+            if constexpr (constellation_type == Constellation::PILOT) {
+                // phase discriminant for pure pilot is Q
+                error = z_out.imag();
+            } else if constexpr (constellation_type == Constellation::BPSK) {
+                // phase discriminant for BPSK is I*Q
+                error = z_out.real() * z_out.imag();
+            } else {
+                // Phase discriminant for QPSK is (Q - I))/sqrt(2) assuming the
+                // signal is in the first quadrant. The /sqrt(2) term is taken
+                // into account in the calculation of _k1 and _k2.
+                error = (z_out.real() > 0 ? z_out.imag() : -z_out.imag()) +
+                        (z_out.imag() > 0 ? -z_out.real() : z_out.real());
+            }
+            freq += static_cast<TPhase>(_k2 * error);
+            phase += static_cast<TPhase>(_k1 * error) + freq;
+            if (phase >= std::numbers::pi_v<TPhase>) {
+                phase -= TPhase{ 2 } * std::numbers::pi_v<TPhase>;
+            } else if (phase < -std::numbers::pi_v<TPhase>) {
+                phase += TPhase{ 2 } * std::numbers::pi_v<TPhase>;
+            }
+        }
+        _phase = phase;
+        _freq = freq;
+    }
+};
+
+template <typename T = float, typename TPhase = float>
+class CostasLoop : public gr::Block<CostasLoop<T, TPhase>>
+{
+public:
+    using Description = Doc<R""(
+@brief Costas Loop.
+
+This block corrects the carrier phase of a PILOT, BPSK or QPSK signal with a
+second-order Costas loop. The `loop_bandwidth` parameter gives the B_L * T loop
+bandwidth. The phase of the loop is set from the `syncword_phase` tags.
+
+The loop is specialized at compile time for each constellation, which can only
+change between calls to the work function. The local oscillator is computed
+with a polynomial approximation of sine and cosine (see sincos.hpp), so that the
+results are reproducible and the loop does not call std::cos() and std::sin()
+for each symbol.
+
+)"">;
+
+public:
+    CostasLoopCore<T, TPhase> _loop;
+
+private:
+    static constexpr char syncword_phase_key[] = "syncword_phase";
+    static constexpr char constellation_key[] = "constellation";
+
+public:
+    gr::PortIn<std::complex<T>> in;
+    gr::PortOut<std::complex<T>> out;
+    // B_L * T loop bandwidth parameter
+    double loop_bandwidth = 0.01;
+    Constellation _constellation = Constellation::BPSK;
+    std::string constellation{ magic_enum::enum_name(_constellation) };
+
+    void settingsChanged(const gr::property_map& /* old_settings */,
+                         const gr::property_map& /* new_settings */)
+    {
+#ifdef TRACE
+        fmt::println(
+            "{}::settingsChanged() constellation = {}", this->name, constellation);
+#endif
+        _constellation = magic_enum::enum_cast<Constellation>(
+                             constellation, magic_enum::case_insensitive)
+                             .value();
+        _loop.set_loop_bandwidth(loop_bandwidth, _constellation);
+#ifdef TRACE
+        fmt::println("{} k1 = {}, k2 = {}", this->name, _loop._k1, _loop._k2);
+#endif
+    }
+
     // processBulk() used instead of processOne() for the same reason as in
     // AdditiveScrambler
     gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
@@ -101,49 +191,21 @@ public:
         if (this->input_tags_present()) {
             const auto tag = this->mergedInputTag();
             if (tag.map.contains(syncword_phase_key)) {
-                set_phase(pmtv::cast<TPhase>(tag.map.at(syncword_phase_key)));
+#ifdef TRACE
+                fmt::println("{} set_phase({})",
+                             this->name,
+                             pmtv::cast<TPhase>(tag.map.at(syncword_phase_key)));
+#endif
+                _loop.set_phase(pmtv::cast<TPhase>(tag.map.at(syncword_phase_key)));
             }
         }
 #ifdef TRACE
         fmt::println("{}::processBulk() constellation = {}, _phase = {}",
                      this->name,
                      constellation,
-                     _phase);
+                     _loop._phase);
 #endif
-        for (const auto j : std::views::iota(0UZ, inSpan.size())) {
-            const std::complex<T> lo = { std::cos(static_cast<T>(_phase)),
-                                         -std::sin(static_cast<T>(_phase)) };
-            const std::complex<T> z_out = inSpan[j] * lo;
-            outSpan[j] = z_out;
-            T error = 0;
-            switch (_constellation) {
-            case Constellation::PILOT:
-                // phase discriminant for pure pilot is Q
-                error = z_out.imag();
-                break;
-            case Constellation::BPSK:
-                // phase discriminant for BPSK is I*Q
-                error = z_out.real() * z_out.imag();
-                break;
-            case Constellation::QPSK:
-                // Phase discriminant for QPSK is (Q - I))/sqrt(2) assuming the
-                // signal is in the first quadrant. The /sqrt(2) term is taken
-                // into account in the calculation of _k1 and _k2.
-                error = (z_out.real() > 0 ? z_out.imag() : -z_out.imag()) +
-                        (z_out.imag() > 0 ? -z_out.real() : z_out.real());
-                break;
-            default:
-                // should not be reached
-                abort();
-            }
-            _freq += static_cast<TPhase>(_k2 * error);
-            _phase += static_cast<TPhase>(_k1 * error) + _freq;
-            if (_phase >= std::numbers::pi_v<TPhase>) {
-                _phase -= TPhase{ 2 } * std::numbers::pi_v<TPhase>;
-            } else if (_phase < -std::numbers::pi_v<TPhase>) {
-                _phase += TPhase{ 2 } * std::numbers::pi_v<TPhase>;
-            }
-        }
+        _loop.process(_constellation, inSpan.data(), outSpan.data(), inSpan.size());
         return gr::work::Status::OK;
     }
 };
@@ -0,0 +1,186 @@
+#ifndef _GR4_PACKET_MODEM_DELAY_LINE
+#define _GR4_PACKET_MODEM_DELAY_LINE
+
+#include <gnuradio-4.0/packet-modem/dot_product.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <ranges>
+#include <vector>
+
+namespace gr::packet_modem {
+
+// Delay line for FIR filters.
+//
+// The delay line stores the last size() items pushed to it (initially zeros),
+// so that they are always a contiguous range in memory, ordered from the
+// oldest to the most recent. The items are written to a linear buffer that is
+// longer than size(). When the buffer is full, the last size() items are moved
+// to its beginning. Since the buffer has room for at least size() new items
+// after this move, each item is written and moved once on average.
+//
+// A push_back_bulk() of at most block_size items is written contiguously after
+// the window that was current before it, so the windows that end at any of
+// the items of the bulk (or at the item before them) can be obtained with
+// window(delay) until the next push.
+//
+// Since the window of items is in order of arrival, the filter taps given to
+// dot_product() must be in reverse order (the first tap multiplies the oldest
+// item).
+template <typename T>
+class DelayLine
+{
+public:
+    static constexpr size_t block_size = 1024;
+
+private:
+    std::vector<T> _buffer;
+    // number of items in the window
+    size_t _size;
+    // one past the most recent item in _buffer
+    size_t _end;
+
+public:
+    explicit DelayLine(size_t size = 1)
+        : _buffer(buffer_size(std::max(size, 1UZ)), T{}),
+          _size(std::max(size, 1UZ)),
+          _end(_size)
+    {
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    // Changes the size of the window. The most recent items are kept, and the
+    // window is filled with zeros if it grows.
+    void resize(size_t size)
+    {
+        size = std::max(size, 1UZ);
+        std::vector<T> buffer(buffer_size(size), T{});
+        const size_t num_old = std::min(size, _size);
+        std::copy(_buffer.begin() + static_cast<ssize_t>(_end - num_old),
+                  _buffer.begin() + static_cast<ssize_t>(_end),
+                  buffer.begin() + static_cast<ssize_t>(size - num_old));
+        _buffer = std::move(buffer);
+        _size = size;
+        _end = size;
+    }
+
+    // Fills the window with zeros
+    void reset()
+    {
+        std::fill(_buffer.begin(), _buffer.end(), T{});
+        _end = _size;
+    }
+
+    void push_back(const T& item)
+    {
+        if (_end == _buffer.size()) {
+            compact();
+        }
+        _buffer[_end++] = item;
+    }
+
+    template <std::ranges::input_range Range>
+    void push_back_bulk(const Range& items)
+    {
+        if constexpr (std::ranges::sized_range<Range>) {
+            const auto n = static_cast<size_t>(std::ranges::size(items));
+            if (n <= block_size && _end + n > _buffer.size()) {
+                compact();
+            }
+        }
+        auto it = std::ranges::begin(items);
+        const auto end = std::ranges::end(items);
+        while (it != end) {
+            if (_end == _buffer.size()) {
+                compact();
+            }
+            auto out = _buffer.begin() + static_cast<ssize_t>(_end);
+            for (; it != end && out != _buffer.end(); ++it, ++out) {
+                *out = *it;
+            }
+            _end = static_cast<size_t>(out - _buffer.begin());
+        }
+    }
+
+    // Makes room for n <= block_size new items after the most recent item and
+    // returns a pointer to them. The items must be written before the delay
+    // line is used again. This allows computing the items directly into the
+    // delay line. The windows that end at any of the new items can be obtained
+    // with window(delay), as for push_back_bulk().
+    T* append(size_t n)
+    {
+        if (_end + n > _buffer.size()) {
+            compact();
+        }
+        T* items = &_buffer[_end];
+        _end += n;
+        return items;
+    }
+
+    // Returns a pointer to the size() items that end delay items before the
+    // most recent item, ordered from the oldest to the most recent. A delay
+    // different from zero can only be used as indicated above.
+    const T* window(size_t delay = 0) const noexcept
+    {
+        return &_buffer[_end - delay - _size];
+    }
+
+    // Returns the item with the given delay (0 is the most recent item)
+    const T& operator[](size_t delay) const noexcept { return _buffer[_end - 1 - delay]; }
+
+    // Computes the dot product of window(delay) with size() taps given in
+    // reverse order (see dot_product.hpp)
+    template <typename TOut, typename TTaps>
+    TOut dot_product(const TTaps* reversed_taps, size_t delay = 0) const
+    {
+        return gr::packet_modem::dot_product<TOut>(window(delay), reversed_taps, _size);
+    }
+
+    // Computes the dot products of window(delay) with the filter taps and the
+    // derivative filter taps given interleaved in reverse order (see
+    // dual_dot_product() in dot_product.hpp)
+    template <typename TOut, typename TTaps>
+    std::array<TOut, 2> dual_dot_product(const TTaps* reversed_taps2,
+                                         size_t delay = 0) const
+    {
+        return gr::packet_modem::dual_dot_product<TOut>(
+            window(delay), reversed_taps2, _size);
+    }
+
+private:
+    static size_t buffer_size(size_t size) noexcept
+    {
+        return size + std::max(size, block_size);
+    }
+
+    void compact()
+    {
+        std::copy(_buffer.begin() + static_cast<ssize_t>(_end - _size),
+                  _buffer.begin() + static_cast<ssize_t>(_end),
+                  _buffer.begin());
+        _end = _size;
+    }
+};
+
+// Organizes the taps in a polyphase structure for use with
+// DelayLine::dot_product(). The arm j contains the taps taps[j], taps[j +
+// num_arms], taps[j + 2 * num_arms], ..., in reverse order and padded with zeros
+// at the beginning to arm_size taps. The arms are stored contiguously, so that
+// the arm j begins at index j * arm_size.
+template <typename TTaps>
+std::vector<TTaps>
+reversed_polyphase_arms(const std::vector<TTaps>& taps, size_t num_arms, size_t arm_size)
+{
+    std::vector<TTaps> arms(num_arms * arm_size, TTaps{ 0 });
+    for (size_t j = 0; j < num_arms; ++j) {
+        for (size_t k = j, m = 0; k < taps.size() && m < arm_size; k += num_arms, ++m) {
+            arms[j * arm_size + arm_size - 1 - m] = taps[k];
+        }
+    }
+    return arms;
+}
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_DELAY_LINE
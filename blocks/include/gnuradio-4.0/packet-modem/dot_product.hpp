@@ -0,0 +1,244 @@
+#ifndef _GR4_PACKET_MODEM_DOT_PRODUCT
+#define _GR4_PACKET_MODEM_DOT_PRODUCT
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <numeric>
+#include <type_traits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace gr::packet_modem {
+
+namespace dot_product_detail {
+
+// Computes the dot product of the float arrays x and taps, of length n (in
+// floats), accumulating separately the elements whose index has each value
+// modulo Interleave. With Interleave = 2 and x containing complex samples, this
+// gives the real and imaginary parts of the dot product. If DuplicateTaps is
+// true, taps has n / 2 elements and each of them multiplies a complex sample
+// (two consecutive floats) of x.
+template <size_t Interleave, bool DuplicateTaps>
+std::array<float, Interleave>
+dot_product_floats(const float* x, const float* taps, size_t n)
+{
+    static_assert(Interleave == 1 || Interleave == 2);
+    static_assert(!DuplicateTaps || Interleave == 2);
+    constexpr size_t lanes = 16;
+    std::array<float, lanes> acc{};
+    size_t k = 0;
+#if defined(__AVX512F__)
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    const auto load_taps = [&](size_t j) {
+        if constexpr (DuplicateTaps) {
+            const __m512i duplicate =
+                _mm512_set_epi32(7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0);
+            return _mm512_permutexvar_ps(
+                duplicate, _mm512_castps256_ps512(_mm256_loadu_ps(&taps[j / 2])));
+        } else {
+            return _mm512_loadu_ps(&taps[j]);
+        }
+    };
+    for (; k + 2 * lanes <= n; k += 2 * lanes) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k]), load_taps(k), acc0);
+        acc1 = _mm512_fmadd_ps(
+            _mm512_loadu_ps(&x[k + lanes]), load_taps(k + lanes), acc1);
+    }
+    for (; k + lanes <= n; k += lanes) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k]), load_taps(k), acc0);
+    }
+    _mm512_storeu_ps(acc.data(), _mm512_add_ps(acc0, acc1));
+#elif defined(__AVX2__) && defined(__FMA__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    const auto load_taps = [&](size_t j) {
+        if constexpr (DuplicateTaps) {
+            const __m256i duplicate = _mm256_set_epi32(3, 3, 2, 2, 1, 1, 0, 0);
+            return _mm256_permutevar8x32_ps(
+                _mm256_castps128_ps256(_mm_loadu_ps(&taps[j / 2])), duplicate);
+        } else {
+            return _mm256_loadu_ps(&taps[j]);
+        }
+    };
+    for (; k + lanes <= n; k += lanes) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]), load_taps(k), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k + 8]), load_taps(k + 8), acc1);
+    }
+    if (k + 8 <= n) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]), load_taps(k), acc0);
+        k += 8;
+    }
+    _mm256_storeu_ps(acc.data(), _mm256_add_ps(acc0, acc1));
+#endif
+    // Portable version, also used for the remaining elements. The independent
+    // accumulators let the compiler vectorize the loop without reordering the
+    // floating point additions of each accumulator.
+    const auto tap = [&](size_t j) { return DuplicateTaps ? taps[j / 2] : taps[j]; };
+    for (; k + lanes <= n; k += lanes) {
+        for (size_t l = 0; l < lanes; ++l) {
+            acc[l] += x[k + l] * tap(k + l);
+        }
+    }
+    for (size_t l = 0; k < n; ++k, ++l) {
+        acc[l] += x[k] * tap(k);
+    }
+    std::array<float, Interleave> sum{};
+    for (size_t l = 0; l < lanes; ++l) {
+        sum[l % Interleave] += acc[l];
+    }
+    return sum;
+}
+
+// Computes the dot products of the float array x, of length n (in floats),
+// with two sets of taps that are given interleaved in taps2 (taps2[2 * j] is
+// the tap j of the first set and taps2[2 * j + 1] is the tap j of the second
+// set). The meaning of Interleave and DuplicateTaps is the same as in
+// dot_product_floats(). Both dot products are computed in a single pass, so
+// that x is only loaded once.
+template <size_t Interleave, bool DuplicateTaps>
+std::array<std::array<float, Interleave>, 2>
+dual_dot_product_floats(const float* x, const float* taps2, size_t n)
+{
+    static_assert(Interleave == 1 || Interleave == 2);
+    static_assert(!DuplicateTaps || Interleave == 2);
+    constexpr size_t lanes = 16;
+    std::array<float, lanes> acc0{};
+    std::array<float, lanes> acc1{};
+    size_t k = 0;
+#if defined(__AVX512F__)
+    __m512 vacc0 = _mm512_setzero_ps();
+    __m512 vacc1 = _mm512_setzero_ps();
+    for (; k + lanes <= n; k += lanes) {
+        const __m512 xv = _mm512_loadu_ps(&x[k]);
+        __m512 t0, t1;
+        if constexpr (DuplicateTaps) {
+            // the 8 tap pairs for the 8 complex samples in xv
+            const __m512 t = _mm512_loadu_ps(&taps2[k]);
+            t0 = _mm512_permutexvar_ps(
+                _mm512_set_epi32(14, 14, 12, 12, 10, 10, 8, 8, 6, 6, 4, 4, 2, 2, 0, 0),
+                t);
+            t1 = _mm512_permutexvar_ps(
+                _mm512_set_epi32(15, 15, 13, 13, 11, 11, 9, 9, 7, 7, 5, 5, 3, 3, 1, 1),
+                t);
+        } else {
+            const __m512i even = _mm512_set_epi32(
+                30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+            const __m512i odd = _mm512_set_epi32(
+                31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+            const __m512 a = _mm512_loadu_ps(&taps2[2 * k]);
+            const __m512 b = _mm512_loadu_ps(&taps2[2 * k + lanes]);
+            t0 = _mm512_permutex2var_ps(a, even, b);
+            t1 = _mm512_permutex2var_ps(a, odd, b);
+        }
+        vacc0 = _mm512_fmadd_ps(xv, t0, vacc0);
+        vacc1 = _mm512_fmadd_ps(xv, t1, vacc1);
+    }
+    _mm512_storeu_ps(acc0.data(), vacc0);
+    _mm512_storeu_ps(acc1.data(), vacc1);
+#elif defined(__AVX2__) && defined(__FMA__)
+    __m256 vacc0 = _mm256_setzero_ps();
+    __m256 vacc1 = _mm256_setzero_ps();
+    for (; k + 8 <= n; k += 8) {
+        const __m256 xv = _mm256_loadu_ps(&x[k]);
+        __m256 t0, t1;
+        if constexpr (DuplicateTaps) {
+            // the 4 tap pairs for the 4 complex samples in xv
+            const __m256 t = _mm256_loadu_ps(&taps2[k]);
+            t0 = _mm256_permutevar8x32_ps(t, _mm256_set_epi32(6, 6, 4, 4, 2, 2, 0, 0));
+            t1 = _mm256_permutevar8x32_ps(t, _mm256_set_epi32(7, 7, 5, 5, 3, 3, 1, 1));
+        } else {
+            const __m256i deinterleave = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
+            // a = (t0 t1 t2 t3 d0 d1 d2 d3), b = (t4 t5 t6 t7 d4 d5 d6 d7)
+            const __m256 a = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&taps2[2 * k]),
+                                                      deinterleave);
+            const __m256 b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&taps2[2 * k + 8]),
+                                                      deinterleave);
+            t0 = _mm256_permute2f128_ps(a, b, 0x20);
+            t1 = _mm256_permute2f128_ps(a, b, 0x31);
+        }
+        vacc0 = _mm256_fmadd_ps(xv, t0, vacc0);
+        vacc1 = _mm256_fmadd_ps(xv, t1, vacc1);
+    }
+    _mm256_storeu_ps(acc0.data(), vacc0);
+    _mm256_storeu_ps(acc1.data(), vacc1);
+#endif
+    // Portable version, also used for the remaining elements
+    const auto tap = [&](size_t j, size_t set) {
+        return taps2[2 * (DuplicateTaps ? j / 2 : j) + set];
+    };
+    for (; k + lanes <= n; k += lanes) {
+        for (size_t l = 0; l < lanes; ++l) {
+            acc0[l] += x[k + l] * tap(k + l, 0);
+            acc1[l] += x[k + l] * tap(k + l, 1);
+        }
+    }
+    for (size_t l = 0; k < n; ++k, ++l) {
+        acc0[l] += x[k] * tap(k, 0);
+        acc1[l] += x[k] * tap(k, 1);
+    }
+    std::array<std::array<float, Interleave>, 2> sum{};
+    for (size_t l = 0; l < lanes; ++l) {
+        sum[0][l % Interleave] += acc0[l];
+        sum[1][l % Interleave] += acc1[l];
+    }
+    return sum;
+}
+
+} // namespace dot_product_detail
+
+// Computes the dot product sum_k x[k] * taps[k] for k = 0, ..., n - 1. The
+// combinations of complex<float> or float samples with float taps, which are
+// the ones used by the filters of the receiver, use a vectorized kernel (with
+// AVX2 or AVX-512 when the compiler targets them). Other types fall back to
+// std::inner_product.
+template <typename TOut, typename TIn, typename TTaps>
+TOut dot_product(const TIn* x, const TTaps* taps, size_t n)
+{
+    if constexpr (std::is_same_v<TIn, std::complex<float>> &&
+                  std::is_same_v<TTaps, float>) {
+        const auto sum = dot_product_detail::dot_product_floats<2, true>(
+            reinterpret_cast<const float*>(x), taps, 2 * n);
+        return static_cast<TOut>(std::complex<float>{ sum[0], sum[1] });
+    } else if constexpr (std::is_same_v<TIn, float> && std::is_same_v<TTaps, float>) {
+        const auto sum = dot_product_detail::dot_product_floats<1, false>(x, taps, n);
+        return static_cast<TOut>(sum[0]);
+    } else {
+        return std::inner_product(taps, taps + n, x, TOut{});
+    }
+}
+
+// Computes the dot products of x with two sets of n taps given interleaved in
+// taps2 (taps2[2 * k] is the tap k of the first set and taps2[2 * k + 1] is the
+// tap k of the second set) in a single pass over x. This is used for a filter
+// and its derivative filter, which are applied to the same samples. The same
+// types as in dot_product() use a vectorized kernel.
+template <typename TOut, typename TIn, typename TTaps>
+std::array<TOut, 2> dual_dot_product(const TIn* x, const TTaps* taps2, size_t n)
+{
+    if constexpr (std::is_same_v<TIn, std::complex<float>> &&
+                  std::is_same_v<TTaps, float>) {
+        const auto sum = dot_product_detail::dual_dot_product_floats<2, true>(
+            reinterpret_cast<const float*>(x), taps2, 2 * n);
+        return { static_cast<TOut>(std::complex<float>{ sum[0][0], sum[0][1] }),
+                 static_cast<TOut>(std::complex<float>{ sum[1][0], sum[1][1] }) };
+    } else if constexpr (std::is_same_v<TIn, float> && std::is_same_v<TTaps, float>) {
+        const auto sum =
+            dot_product_detail::dual_dot_product_floats<1, false>(x, taps2, n);
+        return { static_cast<TOut>(sum[0][0]), static_cast<TOut>(sum[1][0]) };
+    } else {
+        std::array<TOut, 2> sum{};
+        for (size_t k = 0; k < n; ++k) {
+            sum[0] += taps2[2 * k] * x[k];
+            sum[1] += taps2[2 * k + 1] * x[k];
+        }
+        return sum;
+    }
+}
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_DOT_PRODUCT
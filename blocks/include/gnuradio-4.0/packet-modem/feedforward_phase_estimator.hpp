@@ -0,0 +1,251 @@
+#ifndef _GR4_PACKET_MODEM_FEEDFORWARD_PHASE_ESTIMATOR
+#define _GR4_PACKET_MODEM_FEEDFORWARD_PHASE_ESTIMATOR
+
+#include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/constellation.hpp>
+#include <gnuradio-4.0/reflection.hpp>
+#include <magic_enum.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <numbers>
+#include <numeric>
+#include <string>
+#include <utility>
+
+namespace gr::packet_modem {
+
+template <typename T = float>
+class FeedforwardPhaseEstimator : public gr::Block<FeedforwardPhaseEstimator<T>>
+{
+public:
+    using Description = Doc<R""(
+@brief Feedforward Phase Estimator.
+
+This block corrects the carrier phase of a stream of packets, as an alternative
+to the Costas Loop. It is used with the same input as the Costas Loop (the
+output of the Payload Metadata Insert block), and it produces the same output
+stream and tags.
+
+The input is divided in windows of `window_size` symbols, and the phase of each
+window is estimated independently from its symbols and removed from them. The
+windows do not straddle the segments of a packet (syncword, header and
+payload), whose beginnings are marked by the `"syncword_amplitude"`,
+`"header_start"` and `"payload_symbols"` tags, and whose sizes are given by the
+`syncword_size` and `header_size` parameters and the value of the
+`"payload_symbols"` tag. Since a window is only processed when all its symbols
+are available, the block never waits for symbols past the end of a segment.
+
+The estimator depends on the `constellation`, which is updated by the tags in
+the same way as in the Costas Loop. The syncword, which is a pure pilot after
+the syncword wipe-off, gives a data-aided estimate (the argument of the sum of
+the symbols). For BPSK and QPSK symbols, the block uses the Viterbi & Viterbi
+estimator, which removes the modulation by raising the symbols to the second or
+fourth power. The ambiguity of pi or pi/2 radians of this estimate is resolved
+by choosing the value closest to the estimate of the previous window, so that
+the phase is unwrapped starting from the data-aided estimate of the syncword.
+
+Each window is processed independently, with loops that the compiler can
+vectorize, instead of the symbol by symbol feedback of a Costas Loop.
+
+)"">;
+
+public:
+    Constellation _constellation = Constellation::BPSK;
+    // phase estimate of the last window
+    T _phase = 0;
+    // symbols remaining in the current segment, or 0 if the segment size is not
+    // known
+    uint64_t _remaining = 0;
+
+private:
+    static constexpr char syncword_amplitude_key[] = "syncword_amplitude";
+    static constexpr char header_start_key[] = "header_start";
+    static constexpr char payload_symbols_key[] = "payload_symbols";
+
+public:
+    gr::PortIn<std::complex<T>> in;
+    gr::PortOut<std::complex<T>> out;
+    size_t window_size = 64;
+    size_t syncword_size = 64;
+    size_t header_size = 128;
+    std::string constellation{ magic_enum::enum_name(_constellation) };
+
+    void settingsChanged(const gr::property_map& /* old_settings */,
+                         const gr::property_map& /* new_settings */)
+    {
+#ifdef TRACE
+        fmt::println(
+            "{}::settingsChanged() constellation = {}", this->name, constellation);
+#endif
+        if (window_size == 0) {
+            throw gr::exception("window_size cannot be 0");
+        }
+        _constellation = magic_enum::enum_cast<Constellation>(
+                             constellation, magic_enum::case_insensitive)
+                             .value();
+    }
+
+    void start()
+    {
+        _phase = 0;
+        _remaining = 0;
+    }
+
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan)
+    {
+#ifdef TRACE
+        fmt::println("{}::processBulk(inSpan.size() = {}, outSpan.size() = {}), "
+                     "_remaining = {}",
+                     this->name,
+                     inSpan.size(),
+                     outSpan.size(),
+                     _remaining);
+#endif
+        if (this->input_tags_present()) {
+            // If the previous call did not consume any input because a window
+            // was incomplete, the tag is seen again, and setting _remaining
+            // again has no effect.
+            const auto tag = this->mergedInputTag();
+            if (tag.map.contains(syncword_amplitude_key)) {
+                _remaining = syncword_size;
+            } else if (tag.map.contains(header_start_key)) {
+                _remaining = header_size;
+            } else if (tag.map.contains(payload_symbols_key)) {
+                _remaining = pmtv::cast<uint64_t>(tag.map.at(payload_symbols_key));
+            }
+        }
+
+        const size_t n = std::min(inSpan.size(), outSpan.size());
+        size_t processed = 0;
+        while (processed < n) {
+            size_t window = window_size;
+            if (_remaining != 0) {
+                window = static_cast<size_t>(
+                    std::min(static_cast<uint64_t>(window), _remaining));
+            }
+            if (processed + window > n) {
+                if (_remaining != 0) {
+                    // wait until the whole window is available
+                    break;
+                }
+                window = n - processed;
+            }
+            switch (_constellation) {
+            case Constellation::PILOT:
+                process_window<1>(&inSpan[processed], &outSpan[processed], window);
+                break;
+            case Constellation::BPSK:
+                process_window<2>(&inSpan[processed], &outSpan[processed], window);
+                break;
+            case Constellation::QPSK:
+                process_window<4>(&inSpan[processed], &outSpan[processed], window);
+                break;
+            default:
+                // should not be reached
+                abort();
+            }
+            processed += window;
+            if (_remaining != 0) {
+                _remaining -= window;
+            }
+        }
+
+        if (!inSpan.consume(processed)) {
+            throw gr::exception("consume failed");
+        }
+        outSpan.publish(processed);
+        if (processed == 0) {
+            return inSpan.size() <= outSpan.size()
+                       ? gr::work::Status::INSUFFICIENT_INPUT_ITEMS
+                       : gr::work::Status::INSUFFICIENT_OUTPUT_ITEMS;
+        }
+        return gr::work::Status::OK;
+    }
+
+private:
+    // Estimates the phase of a window of symbols of a constellation whose
+    // points are invariant under rotations by 2 * pi / Power, and removes it
+    // from the symbols.
+    template <size_t Power>
+    void process_window(const std::complex<T>* x, std::complex<T>* y, size_t window)
+    {
+        // Sum of x^Power. The products are written explicitly to avoid the
+        // checks for infinities and NaNs of the std::complex product, and the
+        // sum is split in several accumulators, so that the loop can be
+        // vectorized.
+        constexpr size_t lanes = 8;
+        std::array<T, lanes> lanes_re{};
+        std::array<T, lanes> lanes_im{};
+        const auto power = [](std::complex<T> z) {
+            T re = z.real();
+            T im = z.imag();
+            for (size_t k = 1; k < Power; k *= 2) {
+                const T re2 = re * re - im * im;
+                im = T{ 2 } * re * im;
+                re = re2;
+            }
+            return std::pair<T, T>{ re, im };
+        };
+        size_t j = 0;
+        for (; j + lanes <= window; j += lanes) {
+            for (size_t l = 0; l < lanes; ++l) {
+                const auto [re, im] = power(x[j + l]);
+                lanes_re[l] += re;
+                lanes_im[l] += im;
+            }
+        }
+        for (; j < window; ++j) {
+            const auto [re, im] = power(x[j]);
+            lanes_re[0] += re;
+            lanes_im[0] += im;
+        }
+        T acc_re = std::accumulate(lanes_re.cbegin(), lanes_re.cend(), T{ 0 });
+        T acc_im = std::accumulate(lanes_im.cbegin(), lanes_im.cend(), T{ 0 });
+        if constexpr (Power == 4) {
+            // The QPSK constellation points are at odd multiples of pi/4, so
+            // their fourth power is -1
+            acc_re = -acc_re;
+            acc_im = -acc_im;
+        }
+
+        if (acc_re != T{ 0 } || acc_im != T{ 0 }) {
+            constexpr T ambiguity =
+                T{ 2 } * std::numbers::pi_v<T> / static_cast<T>(Power);
+            const T estimate = std::atan2(acc_im, acc_re) / static_cast<T>(Power);
+            // choose the estimate closest to the previous one
+            T diff = estimate - _phase;
+            diff -= ambiguity * std::round(diff / ambiguity);
+            _phase += diff;
+            if (_phase >= std::numbers::pi_v<T>) {
+                _phase -= T{ 2 } * std::numbers::pi_v<T>;
+            } else if (_phase < -std::numbers::pi_v<T>) {
+                _phase += T{ 2 } * std::numbers::pi_v<T>;
+            }
+        }
+
+        const T c = std::cos(_phase);
+        const T s = std::sin(_phase);
+        for (size_t j = 0; j < window; ++j) {
+            // multiply by exp(-1j * _phase)
+            y[j] = { x[j].real() * c + x[j].imag() * s,
+                     x[j].imag() * c - x[j].real() * s };
+        }
+    }
+};
+
+} // namespace gr::packet_modem
+
+ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::FeedforwardPhaseEstimator,
+                               in,
+                               out,
+                               window_size,
+                               syncword_size,
+                               header_size,
+                               constellation);
+
+#endif // _GR4_PACKET_MODEM_FEEDFORWARD_PHASE_ESTIMATOR
@@ -0,0 +1,372 @@
+#ifndef _GR4_PACKET_MODEM_FFT
+#define _GR4_PACKET_MODEM_FFT
+
+#include <gnuradio-4.0/Block.hpp>
+#include <fftw3.h>
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <random>
+#include <ranges>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gr::packet_modem {
+
+// Implementation used to compute the FFTs.
+//
+// FFTW is the fastest for all sizes, but it needs to create plans, which can
+// take a long time if the plans are measured. MIXED_RADIX is an in-tree FFT
+// that does not need planning. It supports any size, but it is only efficient
+// for sizes whose prime factors are 2, 3 and 5.
+enum class FftBackend { FFTW, MIXED_RADIX };
+
+// Effort used by the FFTW planner. These correspond to the FFTW_ESTIMATE,
+// FFTW_MEASURE and FFTW_PATIENT planner flags.
+enum class FftPlanner { ESTIMATE, MEASURE, PATIENT };
+
+struct FftConfig {
+    FftBackend backend = FftBackend::FFTW;
+    FftPlanner planner = FftPlanner::ESTIMATE;
+
+    bool operator==(const FftConfig&) const = default;
+};
+
+namespace fftw {
+
+// The FFTW planner is not thread-safe. All the plan creation and destruction
+// done by packet-modem code goes through this mutex.
+inline std::mutex& planner_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+struct free_deleter {
+    void operator()(void* p) const noexcept { fftwf_free(p); }
+};
+
+struct plan_deleter {
+    void operator()(fftwf_plan p) const noexcept
+    {
+        std::lock_guard lock(planner_mutex());
+        fftwf_destroy_plan(p);
+    }
+};
+
+// Buffer allocated with fftwf_malloc(), which guarantees the alignment required
+// by FFTW to use SIMD code.
+template <typename T>
+using buffer = std::unique_ptr<T[], free_deleter>;
+
+using plan = std::unique_ptr<std::remove_pointer_t<fftwf_plan>, plan_deleter>;
+
+template <typename T>
+buffer<T> allocate(size_t size)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    T* p = static_cast<T*>(fftwf_malloc(size * sizeof(T)));
+    if (p == nullptr) {
+        throw gr::exception("fftwf_malloc failed");
+    }
+    std::uninitialized_value_construct_n(p, size);
+    return buffer<T>(p);
+}
+
+inline fftwf_complex* cast(std::complex<float>* p)
+{
+    return reinterpret_cast<fftwf_complex*>(p);
+}
+
+inline unsigned planner_flags(FftPlanner planner)
+{
+    switch (planner) {
+    case FftPlanner::MEASURE:
+        return FFTW_MEASURE;
+    case FftPlanner::PATIENT:
+        return FFTW_PATIENT;
+    default:
+        return FFTW_ESTIMATE;
+    }
+}
+
+// Merges the wisdom stored in a file into the FFTW wisdom. Returns false if the
+// file cannot be read (which happens the first time that a wisdom file is
+// used).
+inline bool import_wisdom(const std::string& filename)
+{
+    std::lock_guard lock(planner_mutex());
+    return fftwf_import_wisdom_from_filename(filename.c_str()) != 0;
+}
+
+// Writes the FFTW wisdom to a file. The wisdom is written to a temporary file
+// that then replaces the wisdom file, so that processes that read the wisdom
+// file concurrently never see it partially written.
+inline void export_wisdom(const std::string& filename)
+{
+    const std::string tmp_filename =
+        fmt::format("{}.{:08x}", filename, std::random_device{}());
+    {
+        std::lock_guard lock(planner_mutex());
+        if (fftwf_export_wisdom_to_filename(tmp_filename.c_str()) == 0) {
+            throw gr::exception(
+                fmt::format("could not write FFTW wisdom to {}", tmp_filename));
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_filename, filename, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_filename, ec);
+        throw gr::exception(fmt::format("could not write FFTW wisdom file {}", filename));
+    }
+}
+
+} // namespace fftw
+
+// In-tree forward FFT of arbitrary size.
+//
+// This uses the Stockham autosort algorithm, which does not need a bit-reversal
+// permutation. The size is factored into radix-4, 2, 3 and 5 stages, and any
+// remaining prime factor p is done as a stage with a direct DFT of size p,
+// which costs O(p^2).
+class MixedRadixFft
+{
+public:
+    using c64 = std::complex<float>;
+
+private:
+    struct Stage {
+        size_t radix;
+        // size of the DFTs computed by the following stages
+        size_t m;
+        // number of interleaved DFTs
+        size_t s;
+        // offset of the stage in _twiddles and _roots
+        size_t twiddle_offset;
+        size_t root_offset;
+    };
+
+    size_t _size = 0;
+    std::vector<Stage> _stages;
+    // exp(-2 pi i q j / (radix * m)) for q in [0, m) and j in [1, radix),
+    // stored with j as the fastest index
+    std::vector<c64> _twiddles;
+    // exp(-2 pi i k / radix) for k in [0, radix)
+    std::vector<c64> _roots;
+
+    static c64 root_of_unity(size_t k, size_t n)
+    {
+        const double phase =
+            -2.0 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(n);
+        return { static_cast<float>(std::cos(phase)),
+                 static_cast<float>(std::sin(phase)) };
+    }
+
+    // written explicitly rather than with operator* so that the compiler does
+    // not need to handle the inf/nan corner cases of complex multiplication
+    static c64 mul(c64 a, c64 b)
+    {
+        return { a.real() * b.real() - a.imag() * b.imag(),
+                 a.real() * b.imag() + a.imag() * b.real() };
+    }
+
+    void run_stage(const Stage& stage, const c64* x, c64* y) const
+    {
+        const size_t p = stage.radix;
+        const size_t m = stage.m;
+        const size_t s = stage.s;
+        const c64* roots = &_roots[stage.root_offset];
+        for (const size_t q : std::views::iota(0UZ, m)) {
+            const c64* w = &_twiddles[stage.twiddle_offset + q * (p - 1)];
+            const c64* xq = x + s * q;
+            c64* yq = y + s * p * q;
+            if (p == 2) {
+                for (const size_t k : std::views::iota(0UZ, s)) {
+                    const c64 a0 = xq[k];
+                    const c64 a1 = xq[k + s * m];
+                    yq[k] = a0 + a1;
+                    yq[k + s] = mul(a0 - a1, w[0]);
+                }
+            } else if (p == 4) {
+                for (const size_t k : std::views::iota(0UZ, s)) {
+                    const c64 a0 = xq[k];
+                    const c64 a1 = xq[k + s * m];
+                    const c64 a2 = xq[k + 2 * s * m];
+                    const c64 a3 = xq[k + 3 * s * m];
+                    const c64 t0 = a0 + a2;
+                    const c64 t1 = a0 - a2;
+                    const c64 t2 = a1 + a3;
+                    // (a1 - a3) * -i
+                    const c64 t3 = { a1.imag() - a3.imag(), a3.real() - a1.real() };
+                    yq[k] = t0 + t2;
+                    yq[k + s] = mul(t1 + t3, w[0]);
+                    yq[k + 2 * s] = mul(t0 - t2, w[1]);
+                    yq[k + 3 * s] = mul(t1 - t3, w[2]);
+                }
+            } else {
+                for (const size_t k : std::views::iota(0UZ, s)) {
+                    for (const size_t j : std::views::iota(0UZ, p)) {
+                        c64 acc{};
+                        for (const size_t r : std::views::iota(0UZ, p)) {
+                            acc += mul(xq[k + r * s * m], roots[(r * j) % p]);
+                        }
+                        yq[k + j * s] = j == 0 ? acc : mul(acc, w[j - 1]);
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    void init(size_t size)
+    {
+        if (size == 0) {
+            throw gr::exception("FFT size cannot be zero");
+        }
+        _size = size;
+        std::vector<size_t> factors;
+        size_t n = size;
+        for (const size_t radix : { 4UZ, 2UZ, 3UZ, 5UZ }) {
+            while (n % radix == 0) {
+                factors.push_back(radix);
+                n /= radix;
+            }
+        }
+        for (size_t radix = 7; n > 1; radix += 2) {
+            while (n % radix == 0) {
+                factors.push_back(radix);
+                n /= radix;
+            }
+        }
+
+        _stages.clear();
+        _twiddles.clear();
+        _roots.clear();
+        n = size;
+        size_t s = 1;
+        for (const size_t p : factors) {
+            const size_t m = n / p;
+            _stages.push_back({ p, m, s, _twiddles.size(), _roots.size() });
+            for (const size_t q : std::views::iota(0UZ, m)) {
+                for (const size_t j : std::views::iota(1UZ, p)) {
+                    _twiddles.push_back(root_of_unity(q * j, n));
+                }
+            }
+            for (const size_t k : std::views::iota(0UZ, p)) {
+                _roots.push_back(root_of_unity(k, p));
+            }
+            n = m;
+            s *= p;
+        }
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    // Computes the FFT of size() items. The input and output can be the same
+    // buffer. This can be called concurrently from several threads.
+    void execute(const c64* in, c64* out) const
+    {
+        thread_local std::vector<c64> work;
+        if (work.size() < 2 * _size) {
+            work.resize(2 * _size);
+        }
+        c64* const buffers[2] = { work.data(), work.data() + _size };
+        const c64* src = in;
+        for (const size_t j : std::views::iota(0UZ, _stages.size())) {
+            c64* dst = buffers[j % 2];
+            run_stage(_stages[j], src, dst);
+            src = dst;
+        }
+        if (src != out) {
+            std::copy_n(src, _size, out);
+        }
+    }
+};
+
+// Batched forward FFT with a selectable backend.
+//
+// The FFT is computed for howmany rows of size items whose starts are spaced by
+// dist items.
+class Fft
+{
+public:
+    using c64 = std::complex<float>;
+
+private:
+    FftBackend _backend = FftBackend::FFTW;
+    size_t _size = 0;
+    size_t _howmany = 0;
+    size_t _dist = 0;
+    fftw::plan _plan;
+    MixedRadixFft _mixed_radix;
+
+public:
+    // The in and out buffers are only used by the FFTW planner, which might
+    // overwrite them. Afterwards, execute() can be called with other buffers
+    // that have the same alignment as these. The in and out buffers can be the
+    // same, in which case the FFT is computed in-place.
+    void init(const FftConfig& config,
+              size_t size,
+              size_t howmany,
+              size_t dist,
+              c64* in,
+              c64* out)
+    {
+        _backend = config.backend;
+        _size = size;
+        _howmany = howmany;
+        _dist = dist;
+        // the plan is destroyed before locking the planner mutex, because the
+        // plan deleter also locks it
+        _plan.reset();
+        if (_backend == FftBackend::FFTW) {
+            const int n = static_cast<int>(size);
+            const int row_dist = static_cast<int>(dist);
+            std::lock_guard lock(fftw::planner_mutex());
+            _plan.reset(fftwf_plan_many_dft(1,
+                                            &n,
+                                            static_cast<int>(howmany),
+                                            fftw::cast(in),
+                                            nullptr,
+                                            1,
+                                            row_dist,
+                                            fftw::cast(out),
+                                            nullptr,
+                                            1,
+                                            row_dist,
+                                            FFTW_FORWARD,
+                                            fftw::planner_flags(config.planner)));
+            if (!_plan) {
+                throw gr::exception("FFTW planning failed");
+            }
+        } else {
+            _mixed_radix.init(size);
+        }
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    // Computes the FFT. This can be called concurrently from several threads
+    // as long as they use different buffers.
+    void execute(c64* in, c64* out) const
+    {
+        if (_backend == FftBackend::FFTW) {
+            fftwf_execute_dft(_plan.get(), fftw::cast(in), fftw::cast(out));
+            return;
+        }
+        for (const size_t row : std::views::iota(0UZ, _howmany)) {
+            _mixed_radix.execute(in + row * _dist, out + row * _dist);
+        }
+    }
+};
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_FFT
@@ -75,6 +75,41 @@ inline constexpr std::vector<T> root_raised_cosine(
     return taps_T;
 }
 
+// Calculates the taps for a low-pass filter using the windowed-sinc method with
+// a Hamming window.
+//
+// This is similar to the GR3 `gr::filter::firdes::low_pass()` function, but the
+// number of taps is given explicitly instead of being computed from a
+// transition width. The taps are normalized to have a DC gain equal to gain.
+template <typename T = float>
+inline constexpr std::vector<T>
+low_pass(double gain, double sampling_freq, double cutoff_freq, size_t ntaps)
+{
+    ntaps |= 1; // ensure that ntaps is odd
+
+    const double fwT0 = 2.0 * std::numbers::pi * cutoff_freq / sampling_freq;
+    const ssize_t M = static_cast<ssize_t>(ntaps) / 2;
+    std::vector<double> taps(ntaps);
+    std::ranges::transform(std::views::iota(0UZ, ntaps), taps.begin(), [&](size_t i) {
+        const ssize_t n = static_cast<ssize_t>(i) - M;
+        const double window =
+            0.54 - 0.46 * std::cos(2.0 * std::numbers::pi * static_cast<double>(i) /
+                                   static_cast<double>(ntaps - 1));
+        const double sinc = n == 0 ? fwT0 / std::numbers::pi
+                                   : std::sin(static_cast<double>(n) * fwT0) /
+                                         (static_cast<double>(n) * std::numbers::pi);
+        return sinc * window;
+    });
+
+    const double scale = std::accumulate(taps.cbegin(), taps.cend(), 0.0);
+
+    std::vector<T> taps_T(ntaps);
+    std::ranges::transform(taps, taps_T.begin(), [&](double tap) {
+        return static_cast<T>(tap * gain / scale);
+    });
+    return taps_T;
+}
+
 } // namespace gr::packet_modem::firdes
 
 #endif // _GR4_PACKET_MODEM_INTERPOLATING_FIRDES
@@ -0,0 +1,392 @@
+#ifndef _GR4_PACKET_MODEM_FUSED_FRONT_END
+#define _GR4_PACKET_MODEM_FUSED_FRONT_END
+
+#include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/delay_line.hpp>
+#include <gnuradio-4.0/packet-modem/nco.hpp>
+#include <gnuradio-4.0/reflection.hpp>
+#include <algorithm>
+#include <complex>
+#include <deque>
+#include <vector>
+
+namespace gr::packet_modem {
+
+template <typename T = float>
+class FusedFrontEnd : public gr::Block<FusedFrontEnd<T>, gr::Resampling<>>
+{
+public:
+    using Description = Doc<R""(
+@brief Fused receiver front-end.
+
+This block performs the same processing as a Coarse Frequency Correction block,
+followed by a Symbol Filter block and a Syncword Wipe-off block, in a single
+block. The input samples are frequency corrected in chunks that fit in the L1
+cache, writing them directly to the history of the matched filter, and then the
+filter is evaluated for the samples of the chunk that produce an output symbol.
+The syncword symbols are wiped off as they are produced. This avoids writing the
+frequency corrected samples to a buffer between blocks and reading them again,
+and the scheduling of two blocks.
+
+The `syncword_freq` tags are applied `freq_correction_delay` samples after
+their index, as with the `delay` parameter of the Coarse Frequency Correction
+block. The `samples_per_symbol`, `taps`, `num_arms` and `delay` parameters have
+the same meaning as in the Symbol Filter block, and `syncword` is the syncword
+in bipolar format, as in the Syncword Wipe-off block. The output tags are the
+same as those of the three separate blocks.
+
+)"">;
+
+    // number of input samples that are frequency corrected at once
+    static constexpr size_t chunk_size = DelayLine<std::complex<T>>::block_size;
+
+private:
+    static constexpr char syncword_amplitude_key[] = "syncword_amplitude";
+    static constexpr char syncword_time_est_key[] = "syncword_time_est";
+    static constexpr char syncword_freq_key[] = "syncword_freq";
+
+    // Computes the output for the _arm_size samples in the history that end
+    // delay samples before the most recent one, using the current polyphase
+    // arm
+    std::complex<T> filter(size_t delay) const
+    {
+        const T* arm = &_arm_taps[_pfb_arm * _arm_size];
+        return _scale * _history.template dot_product<std::complex<T>>(arm, delay);
+    }
+
+public:
+    // frequency correction
+    Nco<T> _nco;
+    float _next_freq = 0.0f;
+    // input sample position at which _next_freq is applied, or -1 if there
+    // is no pending frequency change
+    ssize_t _freq_change_position = -1;
+
+    // matched filter (see SymbolFilter)
+    std::vector<T> _arm_taps;
+    size_t _arm_size = 1;
+    DelayLine<std::complex<T>> _history{ 1 };
+    size_t _clock_phase = 0;
+    size_t _reset_clock_phase = 0;
+    size_t _pfb_arm = 0;
+    std::deque<gr::Tag> _tags{};
+    T _scale = 1.0;
+
+    // syncword wipe-off
+    bool _in_syncword = false;
+    size_t _syncword_position = 0;
+
+public:
+    gr::PortIn<std::complex<T>> in;
+    gr::PortOut<std::complex<T>> out;
+    size_t samples_per_symbol;
+    std::vector<T> taps;
+    // number of polyphase arms
+    size_t num_arms;
+    size_t delay;
+    size_t freq_correction_delay = 0;
+    std::vector<T> syncword;
+
+    constexpr static gr::TagPropagationPolicy tag_policy =
+        gr::TagPropagationPolicy::TPP_CUSTOM;
+
+    void settingsChanged(const gr::property_map& /* old_settings */,
+                         const gr::property_map& /* new_settings */)
+    {
+        if (samples_per_symbol == 0) {
+            throw gr::exception("samples_per_symbol cannot be zero");
+        }
+
+        if (num_arms == 0) {
+            throw gr::exception("num_arms cannot be zero");
+        }
+
+        // set resampling for the scheduler (see SymbolFilter)
+        this->output_chunk_size = 1;
+        this->input_chunk_size = samples_per_symbol;
+
+        _arm_size = std::max(1UZ, (taps.size() + num_arms - 1) / num_arms);
+        _arm_taps = reversed_polyphase_arms(taps, num_arms, _arm_size);
+        _history.resize(_arm_size);
+        _reset_clock_phase =
+            (samples_per_symbol - (delay % samples_per_symbol)) % samples_per_symbol;
+    }
+
+    void start()
+    {
+        _clock_phase = 0;
+        _tags.clear();
+        _freq_change_position = -1;
+        _in_syncword = false;
+    }
+
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan)
+    {
+#ifdef TRACE
+        fmt::println("{}::processBulk(inSpan.size() = {}, outSpan.size = {}), "
+                     "_clock_phase = {}, _scale = {}, _pfb_arm = {}",
+                     this->name,
+                     inSpan.size(),
+                     outSpan.size(),
+                     _clock_phase,
+                     _scale,
+                     _pfb_arm);
+#endif
+        // The input span is processed in segments that end at each input tag,
+        // as in SymbolFilter
+        const auto read_position = static_cast<ssize_t>(in.streamReader().position());
+        const auto input_tags = get_input_tags(read_position, inSpan.size());
+        auto next_tag = input_tags.cbegin();
+        auto out_item = outSpan.begin();
+        auto in_item = inSpan.begin();
+        while (true) {
+            if (next_tag != input_tags.cend() &&
+                next_tag->index == read_position + (in_item - inSpan.begin())) {
+                if (out_item == outSpan.end()) {
+                    // the tag is handled in the next call, because it can
+                    // require producing an output
+                    break;
+                }
+                process_tag(*next_tag, in_item, out_item, outSpan.begin());
+                ++next_tag;
+            }
+            const auto segment_end =
+                next_tag != input_tags.cend()
+                    ? inSpan.begin() + (next_tag->index - read_position)
+                    : inSpan.end();
+            filter_segment(in_item,
+                           segment_end,
+                           read_position + (in_item - inSpan.begin()),
+                           out_item,
+                           outSpan.begin(),
+                           outSpan.end());
+            if (in_item != segment_end || in_item == inSpan.end()) {
+                break;
+            }
+        }
+
+        if (!inSpan.consume(static_cast<size_t>(in_item - inSpan.begin()))) {
+            throw gr::exception("consume failed");
+        }
+        outSpan.publish(static_cast<size_t>(out_item - outSpan.begin()));
+#ifdef TRACE
+        fmt::println("{} consumed = {}, published = {}",
+                     this->name,
+                     in_item - inSpan.begin(),
+                     out_item - outSpan.begin());
+#endif
+
+        return gr::work::Status::OK;
+    }
+
+private:
+    // Returns the input tags with index in [read_position, read_position +
+    // num_items), merging the tags that have the same index (see
+    // SymbolFilter)
+    std::vector<gr::Tag> get_input_tags(ssize_t read_position, size_t num_items)
+    {
+        std::vector<gr::Tag> span_tags;
+        const ssize_t end = read_position + static_cast<ssize_t>(num_items);
+        const gr::ConsumableSpan auto tag_data = in.tagReader().get();
+        for (const auto& tag : tag_data) {
+            if (tag.index >= read_position && tag.index < end) {
+                span_tags.push_back(tag);
+            }
+        }
+        std::ranges::stable_sort(span_tags, {}, &gr::Tag::index);
+        std::vector<gr::Tag> tags;
+        for (auto& tag : span_tags) {
+            if (tags.empty() || tags.back().index != tag.index) {
+                tags.push_back(std::move(tag));
+            } else {
+                for (const auto& [key, value] : tag.map) {
+                    tags.back().map.insert_or_assign(key, value);
+                }
+            }
+        }
+        return tags;
+    }
+
+    // Computes out[j] = in[j] * exp(-1j * phase) for the n input samples
+    // starting at position, changing the frequency of the NCO at the sample
+    // given by _freq_change_position
+    void frequency_correct(const std::complex<T>* in_samples,
+                           std::complex<T>* out_samples,
+                           size_t n,
+                           ssize_t position)
+    {
+        size_t j = 0;
+        while (j < n) {
+            const ssize_t current = position + static_cast<ssize_t>(j);
+            if (_freq_change_position == current) {
+#ifdef TRACE
+                fmt::println("{} set frequency {}", this->name, _next_freq);
+#endif
+                _nco.set(-static_cast<double>(_next_freq) *
+                             static_cast<double>(freq_correction_delay),
+                         -static_cast<double>(_next_freq));
+                _freq_change_position = -1;
+            }
+            size_t m = n - j;
+            if (_freq_change_position > current) {
+                m = std::min(m, static_cast<size_t>(_freq_change_position - current));
+            }
+            _nco.rotate(in_samples + j, out_samples + j, m);
+            j += m;
+        }
+    }
+
+    // Produces an output symbol using the samples in the history that end
+    // delay samples before the most recent one, publishing the tags that go on
+    // it and wiping off the syncword. The input sample at position is the
+    // last one of the filter window.
+    void output_symbol(size_t delay, ssize_t position, auto& out_item, auto out_begin)
+    {
+        std::complex<T> y = filter(delay);
+        publish_tags(position, out_item - out_begin);
+        if (_in_syncword) {
+            y *= syncword[_syncword_position++];
+            if (_syncword_position == syncword.size()) {
+                _in_syncword = false;
+            }
+        }
+        *out_item++ = y;
+    }
+
+    // Handles an input tag whose index is the sample at in_item (see
+    // SymbolFilter). The syncword_freq tags schedule a change of the
+    // frequency correction.
+    void process_tag(gr::Tag tag, auto& in_item, auto& out_item, auto out_begin)
+    {
+        const ssize_t tag_position = tag.index;
+        const auto in_tag_item = in_item;
+        ssize_t tag_index_adjust = 0;
+        if (tag.map.contains(syncword_freq_key)) {
+            _next_freq = pmtv::cast<float>(tag.map[syncword_freq_key]);
+            _freq_change_position =
+                tag_position + static_cast<ssize_t>(freq_correction_delay);
+        }
+        if (tag.map.contains(syncword_amplitude_key)) {
+#ifdef TRACE
+            fmt::println("{} got {} tag", this->name, syncword_amplitude_key);
+#endif
+            size_t new_clock_phase = _reset_clock_phase;
+            _scale = static_cast<T>(
+                1.0f / pmtv::cast<float>(tag.map[syncword_amplitude_key]));
+
+            // time_est is in the range [-0.5, 0.5]
+            float time_est = pmtv::cast<float>(tag.map[syncword_time_est_key]);
+            if (time_est < 0.0f) {
+                new_clock_phase = (new_clock_phase + 1UZ) % samples_per_symbol;
+                time_est += 1.0f;
+                // adjust phase by one sample
+                float syncword_phase = pmtv::cast<float>(tag.map["syncword_phase"]);
+                double syncword_freq = pmtv::cast<double>(tag.map["syncword_freq"]);
+                tag.map["syncword_phase"] = pmtv::pmt(static_cast<float>(
+                    static_cast<double>(syncword_phase) - syncword_freq));
+            }
+
+            // Special cases to avoid skipping or duplicating one output symbol
+            // (see SymbolFilter)
+            if (_clock_phase == 0 && new_clock_phase == 1) {
+                frequency_correct(
+                    std::to_address(in_item++), _history.append(1), 1, tag_position);
+                output_symbol(0, tag_position, out_item, out_begin);
+                ++new_clock_phase;
+                tag_index_adjust = -1;
+            } else if (_clock_phase == 1 && new_clock_phase == 0) {
+                frequency_correct(
+                    std::to_address(in_item++), _history.append(1), 1, tag_position);
+                ++new_clock_phase;
+            }
+
+            _clock_phase = new_clock_phase;
+            // time_est is now in the range [0.0, 1.0]
+            _pfb_arm = std::clamp(
+                static_cast<size_t>(std::round(static_cast<float>(num_arms) * time_est)),
+                0UZ,
+                num_arms - 1UZ);
+        }
+        tag.index = tag_position + static_cast<ssize_t>(delay) + tag_index_adjust +
+                    (in_item - in_tag_item);
+        _tags.push_back(std::move(tag));
+    }
+
+    // Filters the input samples in [in_item, in_end), where position is the
+    // index of the sample at in_item, advancing in_item and out_item (see
+    // SymbolFilter). The samples are frequency corrected into the history in
+    // chunks of chunk_size samples.
+    void filter_segment(auto& in_item,
+                        auto in_end,
+                        ssize_t position,
+                        auto& out_item,
+                        auto out_begin,
+                        auto out_end)
+    {
+        const size_t sps = samples_per_symbol;
+        const auto num_input = static_cast<size_t>(in_end - in_item);
+        const auto num_output = static_cast<size_t>(out_end - out_item);
+        const size_t first_output = (sps - _clock_phase) % sps;
+        size_t n = num_input;
+        if (num_output == 0) {
+            n = 0;
+        } else if (first_output + (num_output - 1) * sps < num_input) {
+            n = first_output + (num_output - 1) * sps + 1;
+        }
+        const std::complex<T>* samples = std::to_address(in_item);
+        size_t k = first_output;
+        for (size_t chunk_begin = 0; chunk_begin < n; chunk_begin += chunk_size) {
+            const size_t chunk_end = std::min(n, chunk_begin + chunk_size);
+            frequency_correct(samples + chunk_begin,
+                              _history.append(chunk_end - chunk_begin),
+                              chunk_end - chunk_begin,
+                              position + static_cast<ssize_t>(chunk_begin));
+            for (; k < chunk_end; k += sps) {
+                // the filter window ends at the input sample k
+                output_symbol(chunk_end - 1 - k,
+                              position + static_cast<ssize_t>(k),
+                              out_item,
+                              out_begin);
+            }
+        }
+        in_item += static_cast<ssize_t>(n);
+        _clock_phase = (_clock_phase + n) % sps;
+    }
+
+    // Publishes the queued tags that go on the output symbol produced by the
+    // input sample at position (see SymbolFilter). A syncword_amplitude tag
+    // begins the wipe-off of the syncword on this symbol.
+    void publish_tags(ssize_t position, ssize_t output_index)
+    {
+        while (!_tags.empty() && _tags.front().index - position <
+                                     static_cast<ssize_t>(samples_per_symbol / 2)) {
+#ifdef TRACE
+            fmt::println("{} publishTag() {} at index = {}",
+                         this->name,
+                         _tags.front().map,
+                         output_index);
+#endif
+            if (!_in_syncword && _tags.front().map.contains(syncword_amplitude_key)) {
+                _in_syncword = true;
+                _syncword_position = 0;
+            }
+            out.publishTag(_tags.front().map, output_index);
+            _tags.pop_front();
+        }
+    }
+};
+
+} // namespace gr::packet_modem
+
+ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::FusedFrontEnd,
+                               in,
+                               out,
+                               samples_per_symbol,
+                               taps,
+                               num_arms,
+                               delay,
+                               freq_correction_delay,
+                               syncword);
+
+#endif // _GR4_PACKET_MODEM_FUSED_FRONT_END
@@ -0,0 +1,237 @@
+#ifndef _GR4_PACKET_MODEM_FUSED_SYMBOL_DECODER
+#define _GR4_PACKET_MODEM_FUSED_SYMBOL_DECODER
+
+#include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/constellation.hpp>
+#include <gnuradio-4.0/packet-modem/costas_loop.hpp>
+#include <gnuradio-4.0/reflection.hpp>
+#include <magic_enum.hpp>
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace gr::packet_modem {
+
+template <typename T = float>
+class FusedSymbolDecoder : public gr::Block<FusedSymbolDecoder<T>, gr::Resampling<>>
+{
+public:
+    using Description = Doc<R""(
+@brief Fused symbol decoder.
+
+This block performs the same processing as a Costas Loop block, followed by a
+Syncword Remove block, a Constellation LLR Decoder block and a soft symbol
+Additive Scrambler block, in a single block. The input symbols are phase
+corrected in chunks that fit in the L1 cache, and the LLRs of the symbols that
+do not belong to a syncword are computed and descrambled in the same pass over
+the chunk.
+
+The `loop_bandwidth` and `constellation` parameters are used by the Costas loop
+and are updated by tags, as in the Costas Loop block. The `constellation` is
+also used to compute the LLRs, as in the Constellation LLR Decoder block
+(`PILOT` symbols are decoded as `BPSK`). The `syncword_size` and `noise_sigma`
+parameters have the same meaning as in the Syncword Remove and Constellation
+LLR Decoder blocks. The `scrambler_mask`, `scrambler_seed`,
+`scrambler_length` and `scrambler_reset_tag_key` parameters have the same
+meaning as the `mask`, `seed`, `length` and `reset_tag_key` parameters of the
+Additive Scrambler block. The output tags are the same as those of the four
+separate blocks.
+
+)"">;
+
+    // number of input symbols that are phase corrected at once
+    static constexpr size_t chunk_size = 1024;
+
+public:
+    CostasLoopCore<T> _loop;
+    Constellation _constellation = Constellation::QPSK;
+    T _scale = T{ 2 };
+    bool _in_syncword = false;
+    size_t _position = 0;
+    uint64_t _reg = 0;
+    // phase corrected symbols of the current chunk
+    std::unique_ptr<std::complex<T>[]> _corrected =
+        std::make_unique<std::complex<T>[]>(chunk_size);
+
+private:
+    static constexpr char syncword_amplitude_key[] = "syncword_amplitude";
+    static constexpr char syncword_phase_key[] = "syncword_phase";
+
+public:
+    gr::PortIn<std::complex<T>> in;
+    gr::PortOut<T> out;
+    // B_L * T loop bandwidth parameter
+    double loop_bandwidth = 0.01;
+    std::string constellation{ magic_enum::enum_name(_constellation) };
+    size_t syncword_size = 64;
+    // standard deviation of the noise in the real part (and also imaginary
+    // part) of the complex input AGWN
+    T noise_sigma = T{ 1 };
+    // The defaults for the scrambler are the same as in AdditiveScrambler
+    uint64_t scrambler_mask = 0x8a;
+    uint64_t scrambler_seed = 0x7f;
+    uint64_t scrambler_length = 7;
+    std::string scrambler_reset_tag_key = "";
+
+    constexpr static gr::TagPropagationPolicy tag_policy =
+        gr::TagPropagationPolicy::TPP_CUSTOM;
+
+    void settingsChanged(const gr::property_map& /* old_settings */,
+                         const gr::property_map& /* new_settings */)
+    {
+#ifdef TRACE
+        fmt::println(
+            "{}::settingsChanged() constellation = {}", this->name, constellation);
+#endif
+        _constellation = magic_enum::enum_cast<Constellation>(
+                             constellation, magic_enum::case_insensitive)
+                             .value();
+        // set resampling for the scheduler
+        this->input_chunk_size = 1;
+        switch (_constellation) {
+        case Constellation::PILOT:
+        case Constellation::BPSK:
+            this->output_chunk_size = 1;
+            break;
+        case Constellation::QPSK:
+            this->output_chunk_size = 2;
+            break;
+        default:
+            throw gr::exception(
+                fmt::format("constellation {} not supported", constellation));
+        }
+        _loop.set_loop_bandwidth(loop_bandwidth, _constellation);
+        _scale = T{ 2 } / (noise_sigma * noise_sigma);
+    }
+
+    void start()
+    {
+        reset_lfsr();
+        _in_syncword = false;
+    }
+
+    void reset_lfsr()
+    {
+#ifdef TRACE
+        fmt::println("{} resetting LFSR", this->name);
+#endif
+        _reg = scrambler_seed;
+    }
+
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan)
+    {
+#ifdef TRACE
+        fmt::println("{}::processBulk(inSpan.size() = {}, outSpan.size() = {}), "
+                     "constellation = {}, _in_syncword = {}, _position = {}",
+                     this->name,
+                     inSpan.size(),
+                     outSpan.size(),
+                     constellation,
+                     _in_syncword,
+                     _position);
+#endif
+        if (this->input_tags_present()) {
+            const auto tag = this->mergedInputTag();
+            if (tag.map.contains(syncword_phase_key)) {
+                _loop.set_phase(pmtv::cast<T>(tag.map.at(syncword_phase_key)));
+            }
+            // the tags are dropped together with the syncword, as in
+            // SyncwordRemove
+            if (!_in_syncword) {
+                if (tag.map.contains(syncword_amplitude_key)) {
+                    _in_syncword = syncword_size != 0;
+                    _position = 0;
+                } else {
+                    out.publishTag(tag.map, 0);
+                    if (!scrambler_reset_tag_key.empty() &&
+                        tag.map.contains(scrambler_reset_tag_key)) {
+                        reset_lfsr();
+                    }
+                }
+            }
+        }
+
+        const size_t llrs_per_symbol = this->output_chunk_size;
+        const std::complex<T>* input = inSpan.data();
+        T* output = outSpan.data();
+        size_t consumed = 0;
+        size_t produced = 0;
+        while (consumed < inSpan.size()) {
+            size_t n = std::min(chunk_size, inSpan.size() - consumed);
+            if (_in_syncword) {
+                // the syncword symbols only go through the Costas loop
+                n = std::min(n, syncword_size - _position);
+                _loop.process(_constellation, input + consumed, &_corrected[0], n);
+                consumed += n;
+                _position += n;
+                if (_position >= syncword_size) {
+                    _in_syncword = false;
+                }
+                continue;
+            }
+            n = std::min(n, (outSpan.size() - produced) / llrs_per_symbol);
+            if (n == 0) {
+                break;
+            }
+            _loop.process(_constellation, input + consumed, &_corrected[0], n);
+            if (llrs_per_symbol == 2) {
+                for (size_t j = 0; j < n; ++j) {
+                    output[produced++] = descramble(_scale * _corrected[j].real());
+                    output[produced++] = descramble(_scale * _corrected[j].imag());
+                }
+            } else {
+                for (size_t j = 0; j < n; ++j) {
+                    output[produced++] = descramble(_scale * _corrected[j].real());
+                }
+            }
+            consumed += n;
+        }
+
+        if (!inSpan.consume(consumed)) {
+            throw gr::exception("consume failed");
+        }
+        outSpan.publish(produced);
+#ifdef TRACE
+        fmt::println("{} consumed = {}, produced = {}", this->name, consumed, produced);
+#endif
+
+        // The input tags need to be cleared manually when no samples are
+        // published (see SyncwordRemove)
+        if (consumed != 0) {
+            this->_mergedInputTag.map.clear();
+        }
+
+        return gr::work::Status::OK;
+    }
+
+private:
+    // Inverts the sign of the LLR when the LFSR bit is 1 and advances the LFSR
+    // (see AdditiveScrambler)
+    T descramble(T llr) noexcept
+    {
+        const uint8_t lfsr_bit = _reg & 1;
+        const uint64_t shift_in =
+            static_cast<uint64_t>(__builtin_parityl(_reg & scrambler_mask));
+        _reg = (shift_in << scrambler_length) | (_reg >> 1);
+        return lfsr_bit ? -llr : llr;
+    }
+};
+
+} // namespace gr::packet_modem
+
+ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::FusedSymbolDecoder,
+                               in,
+                               out,
+                               loop_bandwidth,
+                               constellation,
+                               syncword_size,
+                               noise_sigma,
+                               scrambler_mask,
+                               scrambler_seed,
+                               scrambler_length,
+                               scrambler_reset_tag_key);
+
+#endif // _GR4_PACKET_MODEM_FUSED_SYMBOL_DECODER
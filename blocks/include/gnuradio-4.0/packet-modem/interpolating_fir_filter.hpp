@@ -2,11 +2,10 @@
 #define _GR4_PACKET_MODEM_INTERPOLATING_FIR_FILTER
 
 #include <gnuradio-4.0/Block.hpp>
-#include <gnuradio-4.0/HistoryBuffer.hpp>
+#include <gnuradio-4.0/packet-modem/delay_line.hpp>
 #include <gnuradio-4.0/packet-modem/pdu.hpp>
 #include <gnuradio-4.0/reflection.hpp>
-#include <numeric>
-#include <ranges>
+#include <algorithm>
 #include <vector>
 
 namespace gr::packet_modem {
@@ -27,11 +26,11 @@ defined by the `interpolation` parameter. The filter taps are given in the
 )"">;
 
 public:
-    // taps in a polyphase structure
-    std::vector<std::vector<TTaps>> _taps_polyphase;
-    // the history constructed here is a placeholder; an appropriate history is
-    // constructed in settingsChanged()
-    gr::HistoryBuffer<TIn> _history{ 1 };
+    // taps in a polyphase structure, with each branch in reverse order (see
+    // reversed_polyphase_arms())
+    std::vector<TTaps> _taps_polyphase;
+    size_t _branch_size = 1;
+    DelayLine<TIn> _history{ 1 };
 
 public:
     gr::PortIn<TIn> in;
@@ -51,26 +50,11 @@ public:
         this->output_chunk_size = interpolation;
 
         // organize the taps in a polyphase structure
-        _taps_polyphase.resize(interpolation);
-        for (size_t j = 0; j < interpolation; ++j) {
-            _taps_polyphase[j].clear();
-            for (size_t k = j; k < taps.size(); k += interpolation) {
-                _taps_polyphase[j].push_back(taps[k]);
-            }
-        }
+        _branch_size = std::max(1UZ, (taps.size() + interpolation - 1) / interpolation);
+        _taps_polyphase = reversed_polyphase_arms(taps, interpolation, _branch_size);
 
-        // create a history of the appropriate size
-        const auto capacity =
-            std::bit_ceil((taps.size() + interpolation - 1) / interpolation);
-        auto new_history = gr::HistoryBuffer<TIn>(capacity);
-        // fill history with zeros to avoid problems with undefined history contents
-        new_history.push_back_bulk(std::views::repeat(TIn{ 0 }, capacity));
-        // move old history items to the new history
-        for (const auto j :
-             std::views::iota(0UZ, _history.size()) | std::views::reverse) {
-            new_history.push_back(_history[j]);
-        }
-        _history = new_history;
+        // resize the history, keeping the most recent items
+        _history.resize(_branch_size);
     }
 
     gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
@@ -92,9 +76,9 @@ public:
         auto out_item = outSpan.begin();
         for (const auto& in_item : inSpan) {
             _history.push_back(in_item);
-            for (const auto& branch : _taps_polyphase) {
-                *out_item++ = std::inner_product(
-                    branch.cbegin(), branch.cend(), _history.cbegin(), TOut{ 0 });
+            for (size_t j = 0; j < interpolation; ++j) {
+                *out_item++ = _history.template dot_product<TOut>(
+                    &_taps_polyphase[j * _branch_size]);
             }
         }
 
@@ -110,11 +94,11 @@ public:
     using Description = InterpolatingFirFilter<TIn, TOut, TTaps>::Description;
 
 public:
-    // taps in a polyphase structure
-    std::vector<std::vector<TTaps>> _taps_polyphase;
-    // the history constructed here is a placeholder; an appropriate history is
-    // constructed in settingsChanged()
-    gr::HistoryBuffer<TIn> _history{ 1 };
+    // taps in a polyphase structure, with each branch in reverse order (see
+    // reversed_polyphase_arms())
+    std::vector<TTaps> _taps_polyphase;
+    size_t _branch_size = 1;
+    DelayLine<TIn> _history{ 1 };
 
 public:
     gr::PortIn<Pdu<TIn>> in;
@@ -130,26 +114,11 @@ public:
         }
 
         // organize the taps in a polyphase structure
-        _taps_polyphase.resize(interpolation);
-        for (size_t j = 0; j < interpolation; ++j) {
-            _taps_polyphase[j].clear();
-            for (size_t k = j; k < taps.size(); k += interpolation) {
-                _taps_polyphase[j].push_back(taps[k]);
-            }
-        }
+        _branch_size = std::max(1UZ, (taps.size() + interpolation - 1) / interpolation);
+        _taps_polyphase = reversed_polyphase_arms(taps, interpolation, _branch_size);
 
-        // create a history of the appropriate size
-        const auto capacity =
-            std::bit_ceil((taps.size() + interpolation - 1) / interpolation);
-        auto new_history = gr::HistoryBuffer<TIn>(capacity);
-        // fill history with zeros to avoid problems with undefined history contents
-        new_history.push_back_bulk(std::views::repeat(TIn{ 0 }, capacity));
-        // move old history items to the new history
-        for (const auto j :
-             std::views::iota(0UZ, _history.size()) | std::views::reverse) {
-            new_history.push_back(_history[j]);
-        }
-        _history = new_history;
+        // resize the history, keeping the most recent items
+        _history.resize(_branch_size);
     }
 
     [[nodiscard]] Pdu<TOut> processOne(const Pdu<TIn>& pdu)
@@ -159,9 +128,9 @@ public:
         pdu_out.data.reserve(pdu.data.size() * interpolation);
         for (const auto& in_item : pdu.data) {
             _history.push_back(in_item);
-            for (const auto& branch : _taps_polyphase) {
-                pdu_out.data.push_back(std::inner_product(
-                    branch.cbegin(), branch.cend(), _history.cbegin(), TOut{ 0 }));
+            for (size_t j = 0; j < interpolation; ++j) {
+                pdu_out.data.push_back(_history.template dot_product<TOut>(
+                    &_taps_polyphase[j * _branch_size]));
             }
         }
 
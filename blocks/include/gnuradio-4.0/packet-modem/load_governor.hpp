@@ -0,0 +1,275 @@
+#ifndef _GR4_PACKET_MODEM_LOAD_GOVERNOR
+#define _GR4_PACKET_MODEM_LOAD_GOVERNOR
+
+#include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/reflection.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace gr::packet_modem {
+
+template <typename T, typename ClockSourceType = std::chrono::steady_clock>
+class LoadGovernor : public gr::Block<LoadGovernor<T, ClockSourceType>>
+{
+public:
+    using Description = Doc<R""(
+@brief Load Governor. Sheds load when the blocks after it cannot keep up with the input.
+
+This block is placed at the input of a receiver. It passes its input to its
+output and watches the number of samples waiting in its input buffer, which
+grows when the blocks after it are slower than the source. Every
+`update_time_secs`, the backlog is compared with `overload_backlog` and
+`headroom_backlog`. When the backlog has stayed above `overload_backlog` for
+`hold_time_secs`, the block goes to the next shedding level. When it has stayed
+below `headroom_backlog` for `hold_time_secs`, the block goes back to the
+previous level.
+
+The levels from 1 to `num_levels` are applied by calling the `level_changed`
+function, which is set by the owner of the block (for instance, the Packet
+Receiver uses it to change the settings of the Syncword Detection block). If
+`drop_samples` is true, there is an additional last level in which this block
+forwards `drop_chunk` samples and drops the next `drop_chunk` samples, which
+halves the rate of the samples given to the receiver. The receiver keeps
+decoding the packets in the forwarded chunks, instead of losing all of them when
+the source overruns.
+
+The samples are only dropped between packets if the owner of the block sets the
+`packet_open` function, which returns whether the receiver is inside a
+packet. While it returns true, the cycle of forwarded and dropped chunks is
+paused and all the samples are forwarded. The state of the receiver is known
+with the delay of the blocks between this block and the block that tracks the
+packets, so a packet whose syncword has been forwarded but not yet detected when
+a dropped chunk begins can still be cut. If `packet_open` is not set, the chunks
+are dropped regardless of the packets, which is a blind decimation of the
+input.
+
+The block also measures the processing rate, which is the rate of the samples
+that it forwards. While the backlog is above `overload_backlog`, this is the
+rate that the receiver can process at the current level. The block only goes
+back to a level if the rate measured when that level was overloaded is greater
+than `restore_margin` times the input rate. This avoids oscillating between two
+levels. The measurement is ignored after the backlog has stayed below
+`headroom_backlog` for four times `hold_time_secs`, in case the load of the
+machine has changed.
+
+The current level, the number of level changes, the number of dropped samples,
+and the last backlog and processing rate are stored in `_level`,
+`_level_changes`, `_dropped_samples`, `_backlog` and `_rate`.
+
+)"">;
+
+public:
+    // called with the new level each time that it changes, excluding the
+    // sample dropping level
+    std::function<void(size_t)> level_changed;
+    // returns true while the receiver is inside a packet, which pauses the
+    // dropping of samples
+    std::function<bool()> packet_open;
+
+    size_t _level;
+    uint64_t _level_changes;
+    uint64_t _dropped_samples;
+    uint64_t _backlog;
+    double _rate;
+
+private:
+    typename ClockSourceType::time_point _last_update;
+    uint64_t _forwarded;
+    uint64_t _consumed;
+    uint64_t _forwarded_at_update;
+    uint64_t _consumed_at_update;
+    // number of consecutive updates with overload and with headroom
+    size_t _overload_count;
+    size_t _headroom_count;
+    // processing rate measured the last time that each level was overloaded,
+    // or zero if unknown
+    std::vector<double> _capacity;
+    // position in the cycle of forwarded and dropped chunks
+    uint64_t _drop_position;
+
+public:
+    gr::PortIn<T> in;
+    gr::PortOut<T> out;
+    uint64_t overload_backlog = 32768;
+    uint64_t headroom_backlog = 4096;
+    double update_time_secs = 0.1;
+    double hold_time_secs = 1.0;
+    size_t num_levels = 0;
+    bool drop_samples = true;
+    uint64_t drop_chunk = 1U << 20;
+    double restore_margin = 1.1;
+
+    void start()
+    {
+        if (headroom_backlog >= overload_backlog) {
+            throw gr::exception("headroom_backlog must be less than overload_backlog");
+        }
+        if (update_time_secs <= 0.0 || hold_time_secs < update_time_secs) {
+            throw gr::exception("update_time_secs must be positive and not greater "
+                                "than hold_time_secs");
+        }
+        if (drop_chunk == 0) {
+            throw gr::exception("drop_chunk cannot be zero");
+        }
+        _level = 0;
+        _level_changes = 0;
+        _dropped_samples = 0;
+        _backlog = 0;
+        _rate = 0.0;
+        _last_update = ClockSourceType::now();
+        _forwarded = 0;
+        _consumed = 0;
+        _forwarded_at_update = 0;
+        _consumed_at_update = 0;
+        _overload_count = 0;
+        _headroom_count = 0;
+        _capacity.assign(max_level() + 1, 0.0);
+        _drop_position = 0;
+    }
+
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan)
+    {
+#ifdef TRACE
+        fmt::println("{}::processBulk(inSpan.size() = {}, outSpan.size = {}), "
+                     "_level = {}",
+                     this->name,
+                     inSpan.size(),
+                     outSpan.size(),
+                     _level);
+#endif
+        const auto now = ClockSourceType::now();
+        if (now - _last_update >= std::chrono::duration<double>(update_time_secs)) {
+            update(now);
+        }
+
+        // the cycle of forwarded and dropped chunks is paused while the
+        // receiver is inside a packet
+        const bool dropping = drop_samples && _level == max_level() &&
+                              !(packet_open && packet_open());
+        size_t consumed = 0;
+        size_t published = 0;
+        while (consumed < inSpan.size()) {
+            const bool forward = !dropping || _drop_position < drop_chunk;
+            size_t n = inSpan.size() - consumed;
+            if (dropping) {
+                const uint64_t chunk_end = forward ? drop_chunk : 2 * drop_chunk;
+                n = static_cast<size_t>(
+                    std::min(static_cast<uint64_t>(n), chunk_end - _drop_position));
+            }
+            if (forward) {
+                n = std::min(n, outSpan.size() - published);
+                if (n == 0) {
+                    break;
+                }
+                std::ranges::copy_n(inSpan.begin() + static_cast<ssize_t>(consumed),
+                                    static_cast<ssize_t>(n),
+                                    outSpan.begin() + static_cast<ssize_t>(published));
+                published += n;
+            } else {
+                _dropped_samples += n;
+            }
+            consumed += n;
+            if (dropping) {
+                _drop_position += n;
+                if (_drop_position == 2 * drop_chunk) {
+                    _drop_position = 0;
+                }
+            }
+        }
+        _consumed += consumed;
+        _forwarded += published;
+
+        if (!inSpan.consume(consumed)) {
+            throw gr::exception("consume failed");
+        }
+        outSpan.publish(published);
+        // _mergedInputTag.map.clear() only gets called automatically by the
+        // block forwardTags() when the block produces some samples. Here it
+        // needs to be called manually, because the block might have dropped
+        // all the samples.
+        if (published == 0 && consumed != 0) {
+            this->_mergedInputTag.map.clear();
+        }
+
+        return gr::work::Status::OK;
+    }
+
+private:
+    size_t max_level() const noexcept { return num_levels + (drop_samples ? 1 : 0); }
+
+    void update(typename ClockSourceType::time_point now)
+    {
+        const double elapsed = std::chrono::duration<double>(now - _last_update).count();
+        const uint64_t backlog = in.streamReader().available();
+        _rate = static_cast<double>(_forwarded - _forwarded_at_update) / elapsed;
+        // the input rate includes the samples that have been added to the
+        // backlog and the dropped samples
+        const double input_rate =
+            (static_cast<double>(_consumed - _consumed_at_update) +
+             static_cast<double>(backlog) - static_cast<double>(_backlog)) /
+            elapsed;
+        _last_update = now;
+        _forwarded_at_update = _forwarded;
+        _consumed_at_update = _consumed;
+        _backlog = backlog;
+
+        if (backlog > overload_backlog) {
+            ++_overload_count;
+            _headroom_count = 0;
+            _capacity[_level] = _rate;
+        } else if (backlog < headroom_backlog) {
+            ++_headroom_count;
+            _overload_count = 0;
+        } else {
+            _overload_count = 0;
+            _headroom_count = 0;
+        }
+
+        const size_t hold = std::max(
+            1UZ, static_cast<size_t>(std::lround(hold_time_secs / update_time_secs)));
+        if (_overload_count >= hold && _level < max_level()) {
+            set_level(_level + 1);
+        } else if (_headroom_count >= hold && _level > 0) {
+            const double capacity = _capacity[_level - 1];
+            if (capacity == 0.0 || capacity > restore_margin * input_rate ||
+                _headroom_count >= 4 * hold) {
+                set_level(_level - 1);
+            }
+        }
+    }
+
+    void set_level(size_t level)
+    {
+#ifdef TRACE
+        fmt::println("{} changing level from {} to {}", this->name, _level, level);
+#endif
+        _level = level;
+        ++_level_changes;
+        _overload_count = 0;
+        _headroom_count = 0;
+        _drop_position = 0;
+        if (level <= num_levels && level_changed) {
+            level_changed(level);
+        }
+    }
+};
+
+} // namespace gr::packet_modem
+
+ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::LoadGovernor,
+                               in,
+                               out,
+                               overload_backlog,
+                               headroom_backlog,
+                               update_time_secs,
+                               hold_time_secs,
+                               num_levels,
+                               drop_samples,
+                               drop_chunk,
+                               restore_margin);
+
+#endif // _GR4_PACKET_MODEM_LOAD_GOVERNOR
@@ -0,0 +1,136 @@
+#ifndef _GR4_PACKET_MODEM_NCO
+#define _GR4_PACKET_MODEM_NCO
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+
+namespace gr::packet_modem {
+
+// Numerically controlled oscillator used to rotate a signal by a complex
+// exponential whose phase increases by a constant phase_incr with each sample.
+//
+// Instead of a single phasor that is multiplied by exp(1j * phase_incr) for
+// each sample, which makes each sample depend on the previous one, the NCO
+// keeps lanes phasors with phases phase + k * phase_incr, k = 0, ..., lanes -
+// 1. A block of lanes samples is rotated by these phasors, and then all of them
+// are multiplied by exp(1j * lanes * phase_incr), so the loops over the lanes
+// can be vectorized. The phasors are renormalized to unit amplitude every
+// renormalize_blocks * lanes samples, counting the samples of incomplete blocks
+// as well, with a first order approximation of 1 / abs(z), which does not need
+// a square root or a division.
+//
+// A rotation of a number of samples that is not a multiple of lanes leaves the
+// phasors rotated by the remaining samples, so consecutive calls to rotate()
+// give the same result as a single call with all the samples.
+template <typename T>
+class Nco
+{
+public:
+    static constexpr size_t lanes = 8;
+    static constexpr size_t renormalize_blocks = 64;
+
+private:
+    std::array<T, lanes> _re;
+    std::array<T, lanes> _im;
+    // exp(1j * lanes * phase_incr)
+    std::complex<T> _step;
+    // samples rotated since the last renormalization
+    size_t _samples = 0;
+
+public:
+    explicit Nco(double phase = 0.0, double phase_incr = 0.0) { set(phase, phase_incr); }
+
+    // Sets the phase of the next sample and the phase increment
+    void set(double phase, double phase_incr)
+    {
+        for (size_t k = 0; k < lanes; ++k) {
+            const double x = phase + static_cast<double>(k) * phase_incr;
+            _re[k] = static_cast<T>(std::cos(x));
+            _im[k] = static_cast<T>(std::sin(x));
+        }
+        const double x = static_cast<double>(lanes) * phase_incr;
+        _step = { static_cast<T>(std::cos(x)), static_cast<T>(std::sin(x)) };
+        _samples = 0;
+    }
+
+    // Changes the phase increment, keeping the phase of the next sample
+    void set_phase_incr(double phase_incr) { set(std::arg(phasor()), phase_incr); }
+
+    // Phasor that rotates the next sample
+    std::complex<T> phasor() const noexcept { return { _re[0], _im[0] }; }
+
+    // Computes out[j] = in[j] * exp(1j * (phase + j * phase_incr)) for j = 0,
+    // ..., n - 1, and advances the phase by n * phase_incr. The input and
+    // output can be the same array.
+    void rotate(const std::complex<T>* in, std::complex<T>* out, size_t n) noexcept
+    {
+        std::array<T, lanes> re = _re;
+        std::array<T, lanes> im = _im;
+        const T step_re = _step.real();
+        const T step_im = _step.imag();
+        size_t j = 0;
+        for (; j + lanes <= n; j += lanes) {
+            // the products are written explicitly to avoid the checks for
+            // infinities and NaNs of the std::complex product
+            for (size_t k = 0; k < lanes; ++k) {
+                const T x_re = in[j + k].real();
+                const T x_im = in[j + k].imag();
+                out[j + k] = { x_re * re[k] - x_im * im[k], x_re * im[k] + x_im * re[k] };
+            }
+            for (size_t k = 0; k < lanes; ++k) {
+                const T r = re[k] * step_re - im[k] * step_im;
+                im[k] = re[k] * step_im + im[k] * step_re;
+                re[k] = r;
+            }
+            _samples += lanes;
+            if (_samples >= renormalize_blocks * lanes) {
+                _samples = 0;
+                renormalize(re, im);
+            }
+        }
+
+        const size_t tail = n - j;
+        for (size_t k = 0; k < tail; ++k) {
+            const T x_re = in[j + k].real();
+            const T x_im = in[j + k].imag();
+            out[j + k] = { x_re * re[k] - x_im * im[k], x_re * im[k] + x_im * re[k] };
+        }
+        // Rotate the phasors by the tail samples. The lanes that have been used
+        // are advanced by a block and moved to the end.
+        for (size_t k = 0; k < lanes; ++k) {
+            const size_t src = k + tail;
+            if (src < lanes) {
+                _re[k] = re[src];
+                _im[k] = im[src];
+            } else {
+                const size_t m = src - lanes;
+                _re[k] = re[m] * step_re - im[m] * step_im;
+                _im[k] = re[m] * step_im + im[m] * step_re;
+            }
+        }
+        // A stream rotated in calls shorter than a block only advances the
+        // phasors here, so the tail also counts towards the renormalization.
+        _samples += tail;
+        if (_samples >= renormalize_blocks * lanes) {
+            _samples = 0;
+            renormalize(_re, _im);
+        }
+    }
+
+private:
+    static void renormalize(std::array<T, lanes>& re, std::array<T, lanes>& im) noexcept
+    {
+        for (size_t k = 0; k < lanes; ++k) {
+            // 1 / abs(z) ~= (3 - abs(z)^2) / 2 for abs(z) ~= 1
+            const T g = T{ 1.5 } - T{ 0.5 } * (re[k] * re[k] + im[k] * im[k]);
+            re[k] *= g;
+            im[k] *= g;
+        }
+    }
+};
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_NCO
@@ -8,10 +8,14 @@
 #include <gnuradio-4.0/packet-modem/constellation_llr_decoder.hpp>
 #include <gnuradio-4.0/packet-modem/costas_loop.hpp>
 #include <gnuradio-4.0/packet-modem/crc_check.hpp>
+#include <gnuradio-4.0/packet-modem/feedforward_phase_estimator.hpp>
 #include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/fused_front_end.hpp>
+#include <gnuradio-4.0/packet-modem/fused_symbol_decoder.hpp>
 #include <gnuradio-4.0/packet-modem/header_fec_decoder.hpp>
 #include <gnuradio-4.0/packet-modem/header_parser.hpp>
 #include <gnuradio-4.0/packet-modem/header_payload_split.hpp>
+#include <gnuradio-4.0/packet-modem/load_governor.hpp>
 #include <gnuradio-4.0/packet-modem/message_debug_stream.hpp>
 #include <gnuradio-4.0/packet-modem/pack_bits.hpp>
 #include <gnuradio-4.0/packet-modem/payload_metadata_insert.hpp>
@@ -22,13 +26,56 @@
 #include <gnuradio-4.0/packet-modem/syncword_wipeoff.hpp>
 #include <gnuradio-4.0/packet-modem/tagged_stream_to_pdu.hpp>
 #include <gnuradio-4.0/packet-modem/zmq_pdu_pub_sink.hpp>
+#include <string>
+#include <variant>
 
 namespace gr::packet_modem {
 
+// Optional features of the PacketReceiver. The defaults give the receiver
+// described in the README.
+struct PacketReceiverOptions {
+    // detection_mode of the Syncword Detection block (MEDIAN or CAUSAL)
+    std::string syncword_detection_mode = "MEDIAN";
+    // Search only in a window of this many samples around the predicted
+    // position of the next syncword (0 searches everywhere).
+    uint64_t syncword_prediction_window = 0;
+    // Track the frequency of the syncword of the decoded packets.
+    bool syncword_cfo_tracking = false;
+    // Insert a Load Governor that sheds load when the receiver falls behind.
+    bool load_shedding = false;
+    // Use the Feedforward Phase Estimator instead of the Costas Loop.
+    bool feedforward_phase_estimation = false;
+    // Use the Fused Front End and Fused Symbol Decoder blocks instead of the
+    // chains of separate blocks.
+    bool fused_front_end = false;
+
+    // Throws if the options cannot be used together, or together with the
+    // ZMQ output of the receiver.
+    void validate(bool zmq_output) const
+    {
+        if (fused_front_end && (feedforward_phase_estimation || zmq_output)) {
+            throw std::runtime_error("fused_front_end cannot be used together with "
+                                     "feedforward_phase_estimation or zmq_output");
+        }
+    }
+};
+
 class PacketReceiver
 {
 public:
-    SyncwordDetection* syncword_detection;
+    // The Syncword Detection block is specialised at compile time for these
+    // values of samples_per_symbol and syncword_freq_bins, which are the
+    // defaults. Other values use the runtime version of the block.
+    static constexpr size_t fixed_samples_per_symbol = 4U;
+    static constexpr int fixed_syncword_freq_bins = 4;
+    using FixedSyncwordDetection = SyncwordDetection<2048U,
+                                                     2 * fixed_syncword_freq_bins + 1,
+                                                     fixed_samples_per_symbol>;
+
+    // input block of the receiver, unless load_governor is not null; use
+    // connect_input() to connect to it
+    std::variant<SyncwordDetection<>*, FixedSyncwordDetection*> syncword_detection;
+    LoadGovernor<std::complex<float>>* load_governor = nullptr;
     CrcCheck<>* payload_crc_check;
 
     PacketReceiver(gr::Graph& fg,
@@ -38,10 +85,13 @@ public:
                    bool zmq_output = false,
                    bool log = false,
                    int syncword_freq_bins = 4,
-                   float syncword_threshold = 9.5)
+                   float syncword_threshold = 9.5,
+                   const PacketReceiverOptions& options = {})
     {
         using c64 = std::complex<float>;
 
+        options.validate(zmq_output);
+
         const std::vector<uint8_t> syncword = {
             uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 }, uint8_t{ 0 },
             uint8_t{ 0 }, uint8_t{ 1 }, uint8_t{ 1 }, uint8_t{ 0 }, uint8_t{ 1 },
@@ -73,14 +123,27 @@ public:
             x /= rrc_taps_norm;
         }
         const std::vector<c64> bpsk_constellation = { { 1.0f, 0.0f }, { -1.0f, 0.0f } };
-        auto& _syncword_detection = fg.emplaceBlock<SyncwordDetection>(
-            { { "rrc_taps", rrc_taps },
-              { "syncword", syncword },
-              { "constellation", bpsk_constellation },
-              { "min_freq_bin", -syncword_freq_bins },
-              { "max_freq_bin", syncword_freq_bins },
-              { "power_threshold", syncword_threshold } });
-        syncword_detection = &_syncword_detection;
+        const gr::property_map syncword_detection_settings = {
+            { "rrc_taps", rrc_taps },
+            { "syncword", syncword },
+            { "constellation", bpsk_constellation },
+            { "min_freq_bin", -syncword_freq_bins },
+            { "max_freq_bin", syncword_freq_bins },
+            { "power_threshold", syncword_threshold },
+            { "detection_mode", options.syncword_detection_mode },
+            { "prediction_time_window", options.syncword_prediction_window },
+            { "cfo_tracking", options.syncword_cfo_tracking },
+            // the load governor changes the search mode at runtime
+            { "runtime_search_mode", options.load_shedding }
+        };
+        if (samples_per_symbol == fixed_samples_per_symbol &&
+            syncword_freq_bins == fixed_syncword_freq_bins) {
+            syncword_detection =
+                &fg.emplaceBlock<FixedSyncwordDetection>(syncword_detection_settings);
+        } else {
+            syncword_detection =
+                &fg.emplaceBlock<SyncwordDetection<>>(syncword_detection_settings);
+        }
         auto& syncword_detection_filter = fg.emplaceBlock<SyncwordDetectionFilter<>>(
             { { "samples_per_symbol", samples_per_symbol } });
         // Set a delay for the coarse frequency correction to avoid a phase jump
@@ -91,8 +154,8 @@ public:
         // preferrable to put any imperfections caused by the the change in
         // frequency correction slightly after the beginning of the next
         // syncword (past the last data symbol of the packet).
-        auto& freq_correction = fg.emplaceBlock<CoarseFrequencyCorrection<>>(
-            { { "delay", (rrc_taps.size() - 1) / 2 + samples_per_symbol } });
+        const size_t freq_correction_delay =
+            (rrc_taps.size() - 1) / 2 + samples_per_symbol;
         const size_t symbol_filter_pfb_arms = 32UZ;
         // Build PFB RRC taps for symbol filter. The first arm of this PFB is
         // equal to rrc_taps. The gain of this filter is adjusted to achieve the
@@ -108,31 +171,78 @@ public:
         // firdes::root_raised_cosine always generates a filter of odd length,
         // adding one to the requested length if necessary.
         rrc_taps_pfb.pop_back();
-        auto& symbol_filter = fg.emplaceBlock<SymbolFilter<c64, c64, float>>(
-            { { "taps", rrc_taps_pfb },
-              { "num_arms", symbol_filter_pfb_arms },
-              { "samples_per_symbol", samples_per_symbol },
-              { "delay", rrc_taps.size() - 1 } });
-
         std::vector<float> syncword_bipolar;
         for (auto x : syncword) {
             syncword_bipolar.push_back(x ? -1.0f : 1.0f);
         }
-        auto& syncword_wipeoff =
-            fg.emplaceBlock<SyncwordWipeoff<>>({ { "syncword", syncword_bipolar } });
+
+        // The frequency correction, symbol filter and syncword wipe-off are
+        // done either by separate blocks or by a Fused Front End block
+        CoarseFrequencyCorrection<>* freq_correction = nullptr;
+        SymbolFilter<c64, c64, float>* symbol_filter = nullptr;
+        SyncwordWipeoff<>* syncword_wipeoff = nullptr;
+        FusedFrontEnd<>* front_end = nullptr;
+        if (options.fused_front_end) {
+            front_end = &fg.emplaceBlock<FusedFrontEnd<>>(
+                { { "taps", rrc_taps_pfb },
+                  { "num_arms", symbol_filter_pfb_arms },
+                  { "samples_per_symbol", samples_per_symbol },
+                  { "delay", rrc_taps.size() - 1 },
+                  { "freq_correction_delay", freq_correction_delay },
+                  { "syncword", syncword_bipolar } });
+        } else {
+            freq_correction = &fg.emplaceBlock<CoarseFrequencyCorrection<>>(
+                { { "delay", freq_correction_delay } });
+            symbol_filter = &fg.emplaceBlock<SymbolFilter<c64, c64, float>>(
+                { { "taps", rrc_taps_pfb },
+                  { "num_arms", symbol_filter_pfb_arms },
+                  { "samples_per_symbol", samples_per_symbol },
+                  { "delay", rrc_taps.size() - 1 } });
+            syncword_wipeoff =
+                &fg.emplaceBlock<SyncwordWipeoff<>>({ { "syncword", syncword_bipolar } });
+        }
         auto& payload_metadata_insert =
             fg.emplaceBlock<PayloadMetadataInsert<>>({ { "log", log } });
-        auto& costas_loop = fg.emplaceBlock<CostasLoop<>>();
-        auto& syncword_remove = fg.emplaceBlock<SyncwordRemove<>>();
+        // The carrier phase is tracked either by a Costas loop or by a
+        // feedforward phase estimator that processes windows of symbols
+        // independently. With fused_front_end, the Costas loop, syncword
+        // removal, LLR computation and descrambling are done by a Fused
+        // Symbol Decoder block.
+        CostasLoop<>* costas_loop = nullptr;
+        FeedforwardPhaseEstimator<>* phase_estimator = nullptr;
+        SyncwordRemove<>* syncword_remove = nullptr;
+        ConstellationLLRDecoder<>* constellation_decoder = nullptr;
+        AdditiveScrambler<float>* descrambler = nullptr;
+        FusedSymbolDecoder<>* symbol_decoder = nullptr;
         // noise_sigma set for an Es/N0 of 0 dB, which is the worst design case
         // for header decoding
-        auto& constellation_decoder = fg.emplaceBlock<ConstellationLLRDecoder<>>(
-            { { "noise_sigma", 0.7f }, { "constellation", "QPSK" } });
-        auto& descrambler = fg.emplaceBlock<AdditiveScrambler<float>>(
-            { { "mask", uint64_t{ 0x4001U } },
-              { "seed", uint64_t{ 0x18E38U } },
-              { "length", uint64_t{ 16U } },
-              { "reset_tag_key", "header_start" } });
+        const float noise_sigma = 0.7f;
+        const uint64_t scrambler_mask = 0x4001U;
+        const uint64_t scrambler_seed = 0x18E38U;
+        const uint64_t scrambler_length = 16U;
+        if (options.fused_front_end) {
+            symbol_decoder = &fg.emplaceBlock<FusedSymbolDecoder<>>(
+                { { "noise_sigma", noise_sigma },
+                  { "constellation", "QPSK" },
+                  { "scrambler_mask", scrambler_mask },
+                  { "scrambler_seed", scrambler_seed },
+                  { "scrambler_length", scrambler_length },
+                  { "scrambler_reset_tag_key", "header_start" } });
+        } else {
+            if (options.feedforward_phase_estimation) {
+                phase_estimator = &fg.emplaceBlock<FeedforwardPhaseEstimator<>>();
+            } else {
+                costas_loop = &fg.emplaceBlock<CostasLoop<>>();
+            }
+            syncword_remove = &fg.emplaceBlock<SyncwordRemove<>>();
+            constellation_decoder = &fg.emplaceBlock<ConstellationLLRDecoder<>>(
+                { { "noise_sigma", noise_sigma }, { "constellation", "QPSK" } });
+            descrambler = &fg.emplaceBlock<AdditiveScrambler<float>>(
+                { { "mask", scrambler_mask },
+                  { "seed", scrambler_seed },
+                  { "length", scrambler_length },
+                  { "reset_tag_key", "header_start" } });
+        }
         auto& header_payload_split = fg.emplaceBlock<HeaderPayloadSplit<>>(
             { { "packet_len_tag_key", packet_len_tag_key } });
         auto& header_fec_decoder = fg.emplaceBlock<HeaderFecDecoder>();
@@ -166,7 +276,7 @@ public:
                 fg.emplaceBlock<ZmqPduPubSink<c64>>({ { "endpoint", "tcp://*:5000" } });
             auto& zmq_payload_sink =
                 fg.emplaceBlock<ZmqPduPubSink<c64>>({ { "endpoint", "tcp://*:5001" } });
-            if (fg.connect<"out">(syncword_remove).to<"in">(symbols_split) !=
+            if (fg.connect<"out">(*syncword_remove).to<"in">(symbols_split) !=
                 ConnectionResult::SUCCESS) {
                 throw std::runtime_error(connection_error);
             }
@@ -188,45 +298,79 @@ public:
             }
         }
 
-        if (fg.connect<"out">(_syncword_detection).to<"in">(syncword_detection_filter) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(syncword_detection_filter).to<"in">(freq_correction) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(freq_correction).to<"in">(symbol_filter) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(symbol_filter).to<"in">(syncword_wipeoff) !=
-            ConnectionResult::SUCCESS) {
+        if (std::visit(
+                [&](auto* block) {
+                    return fg.connect<"out">(*block).template to<"in">(
+                        syncword_detection_filter);
+                },
+                syncword_detection) != ConnectionResult::SUCCESS) {
             throw std::runtime_error(connection_error);
         }
-        if (fg.connect<"out">(syncword_wipeoff).to<"in">(payload_metadata_insert) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(payload_metadata_insert).to<"in">(costas_loop) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(costas_loop).to<"in">(syncword_remove) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(syncword_remove).to<"in">(constellation_decoder) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(constellation_decoder).to<"in">(descrambler) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
-        }
-        if (fg.connect<"out">(descrambler).to<"in">(header_payload_split) !=
-            ConnectionResult::SUCCESS) {
-            throw std::runtime_error(connection_error);
+        if (options.fused_front_end) {
+            if (fg.connect<"out">(syncword_detection_filter).to<"in">(*front_end) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*front_end).to<"in">(payload_metadata_insert) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(payload_metadata_insert).to<"in">(*symbol_decoder) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*symbol_decoder).to<"in">(header_payload_split) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+        } else {
+            if (fg.connect<"out">(syncword_detection_filter)
+                    .to<"in">(*freq_correction) != ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*freq_correction).to<"in">(*symbol_filter) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*symbol_filter).to<"in">(*syncword_wipeoff) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*syncword_wipeoff).to<"in">(payload_metadata_insert) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (options.feedforward_phase_estimation) {
+                if (fg.connect<"out">(payload_metadata_insert)
+                        .to<"in">(*phase_estimator) != ConnectionResult::SUCCESS) {
+                    throw std::runtime_error(connection_error);
+                }
+                if (fg.connect<"out">(*phase_estimator).to<"in">(*syncword_remove) !=
+                    ConnectionResult::SUCCESS) {
+                    throw std::runtime_error(connection_error);
+                }
+            } else {
+                if (fg.connect<"out">(payload_metadata_insert).to<"in">(*costas_loop) !=
+                    ConnectionResult::SUCCESS) {
+                    throw std::runtime_error(connection_error);
+                }
+                if (fg.connect<"out">(*costas_loop).to<"in">(*syncword_remove) !=
+                    ConnectionResult::SUCCESS) {
+                    throw std::runtime_error(connection_error);
+                }
+            }
+            if (fg.connect<"out">(*syncword_remove).to<"in">(*constellation_decoder) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*constellation_decoder).to<"in">(*descrambler) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+            if (fg.connect<"out">(*descrambler).to<"in">(header_payload_split) !=
+                ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
         }
         if (fg.connect<"header">(header_payload_split).to<"in">(header_fec_decoder) !=
             ConnectionResult::SUCCESS) {
@@ -251,6 +395,57 @@ public:
             ConnectionResult::SUCCESS) {
             throw std::runtime_error(connection_error);
         }
+        if (options.load_shedding) {
+            // The load governor sheds load in steps when the receiver cannot
+            // keep up with the input: level 1 uses the two-stage syncword
+            // search, level 2 halves the frequency bins searched, level 3
+            // only searches the zero frequency bin, and the last level drops
+            // chunks of samples between packets. The levels are restored when
+            // the backlog clears.
+            load_governor =
+                &fg.emplaceBlock<LoadGovernor<c64>>({ { "num_levels", 3UZ } });
+            load_governor->level_changed = [detection = syncword_detection,
+                                            syncword_freq_bins](size_t level) {
+                const int bins = level == 0 || level == 1 ? syncword_freq_bins
+                                 : level == 2             ? syncword_freq_bins / 2
+                                                          : 0;
+                const gr::property_map settings = {
+                    { "search_mode", level == 0 ? "FULL" : "TWO_STAGE" },
+                    { "min_freq_bin", -bins },
+                    { "max_freq_bin", bins }
+                };
+                // the settings are staged and applied by the Syncword Detection
+                // block before its next call to processBulk()
+                std::visit(
+                    [&](auto* block) { std::ignore = block->settings().set(settings); },
+                    detection);
+            };
+            load_governor->packet_open = [filter = &syncword_detection_filter] {
+                return filter->_packet_open.load(std::memory_order::relaxed);
+            };
+            if (std::visit(
+                    [&](auto* block) {
+                        return fg.connect<"out">(*load_governor)
+                            .template to<"in">(*block);
+                    },
+                    syncword_detection) != ConnectionResult::SUCCESS) {
+                throw std::runtime_error(connection_error);
+            }
+        }
+        // In stream mode, the syncword of the next packet is expected right
+        // after the end of the current packet. The Syncword Detection only
+        // uses this prediction if options.syncword_prediction_window is
+        // non-zero. The messages also carry the frequency of the syncword of
+        // each decoded packet, which is used if options.syncword_cfo_tracking
+        // is true.
+        if (std::visit(
+                [&](auto* block) {
+                    return fg.connect<"next_syncword">(syncword_detection_filter)
+                        .template to<"next_syncword">(*block);
+                },
+                syncword_detection) != ConnectionResult::SUCCESS) {
+            throw std::runtime_error(connection_error);
+        }
         if (fg.connect<"payload">(header_payload_split).to<"in">(payload_slicer) !=
             ConnectionResult::SUCCESS) {
             throw std::runtime_error(connection_error);
@@ -264,6 +459,21 @@ public:
             throw std::runtime_error(connection_error);
         }
     }
+
+    // Connects the output port "out" of the source block to the input of the
+    // receiver
+    template <typename Source>
+    gr::ConnectionResult connect_input(gr::Graph& fg, Source& source)
+    {
+        if (load_governor != nullptr) {
+            return fg.connect<"out">(source).template to<"in">(*load_governor);
+        }
+        return std::visit(
+            [&](auto* block) {
+                return fg.connect<"out">(source).template to<"in">(*block);
+            },
+            syncword_detection);
+    }
 };
 
 } // namespace gr::packet_modem
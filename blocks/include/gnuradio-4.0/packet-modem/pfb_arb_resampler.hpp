@@ -13,8 +13,11 @@
 #define _GR4_PACKET_MODEM_PFB_ARB_RESAMPLER
 
 #include <gnuradio-4.0/Block.hpp>
-#include <gnuradio-4.0/HistoryBuffer.hpp>
+#include <gnuradio-4.0/packet-modem/delay_line.hpp>
 #include <gnuradio-4.0/reflection.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <type_traits>
 #include <vector>
 
@@ -39,23 +42,68 @@ variables used to control resampling. In many cases, `float` can be used as
 `TRate`, but for more precise results (for instance, for resampling ratios very
 close to one), `double` can be used.
 
+The taps of each polyphase arm and of the corresponding arm of the derivative
+filter are stored interleaved in a single table, so that both filters are
+evaluated with a single vectorized pass over the input samples. The outputs are
+computed in blocks: the polyphase arm, interpolation phase and input position
+of a block of outputs are computed first, and then the filters are evaluated
+for all of them.
+
+When the resampling ratio is rational, the block can use a precomputed polyphase
+schedule instead. The ratio can be given with the `interpolation` and
+`decimation` parameters, in which case `rate` is ignored. Otherwise, if
+`detect_rational` is `true`, the block checks if `rate` is exactly equal to a
+ratio `interpolation / decimation` with `interpolation` up to 1024. The
+resampler then produces `interpolation` outputs for each `decimation` inputs
+following a periodic pattern of input advances and filter phases. The filter of
+each phase, which combines a polyphase arm and its derivative, is computed in
+advance, so only a single dot product is evaluated per output, and the phase
+does not drift due to floating-point rounding. `detect_rational` is `false` by
+default, because the output of the rational path differs slightly from the
+output of the arbitrary path for the same `rate`.
+
 )"">;
 
+private:
+    struct ScheduledOutput {
+        // polyphase arm, or phase of the rational schedule
+        size_t arm;
+        TRate phase;
+        // number of input items of the block pushed to the history before
+        // computing this output
+        size_t num_inputs;
+    };
+
 public:
-    // taps in a polyphase structure
-    std::vector<std::vector<TTaps>> _taps;
-    // derivative filter taps in a polyphase structure
-    std::vector<std::vector<TTaps>> _diff_taps;
+    // filter and derivative filter taps in a polyphase structure, with each
+    // arm in reverse order (see reversed_polyphase_arms()); the taps of both
+    // filters are interleaved, so that the arm j occupies the 2 * _arm_size
+    // elements beginning at 2 * j * _arm_size
+    std::vector<TTaps> _taps;
     size_t _arm_size;
-    // the history constructed here is a placeholder; an appropriate history is
-    // constructed in settingsChanged()
-    gr::HistoryBuffer<TIn> _history{ 1 };
+    DelayLine<TIn> _history{ 1 };
+    std::vector<ScheduledOutput> _schedule;
     size_t _decim_rate;
     TRate _filt_rate;
     size_t _last_filter;
     TRate _phase_acc;
+    // rational resampling mode
+    bool _rational;
+    size_t _interpolation;
+    size_t _decimation;
+    // filter for each of the _interpolation phases of the rational schedule,
+    // in reverse order, with phase l beginning at l * _arm_size
+    std::vector<TTaps> _rational_taps;
+    // number of input items consumed after the output of each phase
+    std::vector<size_t> _rational_advance;
+    // phase of the next output
+    size_t _rational_index;
+    // number of input items to consume before the next output
+    size_t _rational_pending;
 
 public:
+    static constexpr size_t max_rational_interpolation = 1024;
+
     // Both input and output ports set to Async because this block doesn't have
     // a resampling ratio that can be expressed as a fraction.
     gr::PortIn<TIn, gr::Async> in;
@@ -63,6 +111,9 @@ public:
     TRate rate{ 1.0 };
     std::vector<TTaps> taps;
     size_t filter_size = 32UZ;
+    size_t interpolation = 0UZ;
+    size_t decimation = 0UZ;
+    bool detect_rational = false;
 
     void settingsChanged(const gr::property_map& /* old_settings */,
                          const gr::property_map& /* new_settings */)
@@ -71,52 +122,37 @@ public:
             throw gr::exception("filter_size cannot be 0");
         }
 
-        _arm_size = (taps.size() + filter_size - 1) / filter_size;
-
-        // Organize the taps in a polyphase structure
-        _taps.resize(filter_size);
-        for (size_t j = 0; j < filter_size; ++j) {
-            _taps[j].clear();
-            for (size_t k = j; k < taps.size(); k += filter_size) {
-                _taps[j].push_back(taps[k]);
-            }
-            while (_taps[j].size() < _arm_size) {
-                _taps[j].push_back(TTaps{ 0 });
-            }
-        }
+        _arm_size = std::max(1UZ, (taps.size() + filter_size - 1) / filter_size);
 
         //
         // The derivative filter is
         //   y[n] = x[n + 1] - x[n],  for n < x.size() - 1
         //   y[x.size() - 1] = 0
-        // Compute the filter on the fly as it is written into a polyphase structure
-        _diff_taps.resize(filter_size);
-        for (size_t j = 0; j < filter_size; ++j) {
-            _diff_taps[j].clear();
-            for (size_t k = j; k < taps.size() - 1; k += filter_size) {
-                _diff_taps[j].push_back(taps[k + 1] - taps[k]);
-            }
-            while (_diff_taps[j].size() < _arm_size) {
-                _diff_taps[j].push_back(TTaps{ 0 });
-            }
+        std::vector<TTaps> diff_taps(taps.size(), TTaps{ 0 });
+        for (size_t k = 0; k + 1 < taps.size(); ++k) {
+            diff_taps[k] = taps[k + 1] - taps[k];
         }
 
-        // create a history of the appropriate size
-        const auto capacity = std::bit_ceil(_arm_size);
-        auto new_history = gr::HistoryBuffer<TIn>(capacity);
-        // fill history with zeros to avoid problems with undefined history contents
-        new_history.push_back_bulk(std::views::repeat(TIn{ 0 }, capacity));
-        // move old history items to the new history
-        for (ssize_t j = static_cast<ssize_t>(_history.size()) - 1; j >= 0; --j) {
-            new_history.push_back(_history[static_cast<size_t>(j)]);
+        // Organize the taps in a polyphase structure, interleaving the filter
+        // and the derivative filter
+        const auto arms = reversed_polyphase_arms(taps, filter_size, _arm_size);
+        const auto diff_arms = reversed_polyphase_arms(diff_taps, filter_size, _arm_size);
+        _taps.resize(2 * arms.size());
+        for (size_t k = 0; k < arms.size(); ++k) {
+            _taps[2 * k] = arms[k];
+            _taps[2 * k + 1] = diff_arms[k];
         }
-        _history = new_history;
+
+        // resize the history, keeping the most recent items
+        _history.resize(_arm_size);
 
         const TRate float_rate = static_cast<TRate>(filter_size) / rate;
         _decim_rate = static_cast<size_t>(std::floor(float_rate));
         _filt_rate = float_rate - static_cast<TRate>(_decim_rate);
         _phase_acc = TRate{ 0 };
         _last_filter = (taps.size() / 2) % filter_size;
+
+        set_rational_schedule();
     }
 
     gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
@@ -130,40 +166,10 @@ public:
 #endif
         auto in_item = inSpan.begin();
         auto out_item = outSpan.begin();
-
-        while (in_item < inSpan.end() && out_item < outSpan.end()) {
-            while (_last_filter >= filter_size && in_item < inSpan.end()) {
-                _history.push_back(*in_item++);
-                _last_filter -= filter_size;
-            }
-            if (_last_filter >= filter_size) {
-                // not enough input items to continue
-                break;
-            }
-            const TOut filt_out = std::inner_product(_taps[_last_filter].cbegin(),
-                                                     _taps[_last_filter].cbegin() +
-                                                         static_cast<ssize_t>(_arm_size),
-                                                     _history.cbegin(),
-                                                     TOut{ 0 });
-            const TOut diff_out = std::inner_product(_diff_taps[_last_filter].cbegin(),
-                                                     _diff_taps[_last_filter].cbegin() +
-                                                         static_cast<ssize_t>(_arm_size),
-                                                     _history.cbegin(),
-                                                     TOut{ 0 });
-            TOut diff_out_scaled;
-            if constexpr (std::is_floating_point_v<TOut>) {
-                diff_out_scaled = static_cast<TOut>(_phase_acc) * diff_out;
-            } else {
-                // assume that TOut is a std::complex<> type
-                diff_out_scaled = static_cast<TOut::value_type>(_phase_acc) * diff_out;
-            }
-            *out_item++ = filt_out + diff_out_scaled;
-            _phase_acc += _filt_rate;
-            _last_filter += _decim_rate;
-            if (_phase_acc > TRate{ 1 }) {
-                _phase_acc -= TRate{ 1 };
-                ++_last_filter;
-            }
+        if (_rational) {
+            process_rational(in_item, inSpan.end(), out_item, outSpan.end());
+        } else {
+            process_arbitrary(in_item, inSpan.end(), out_item, outSpan.end());
         }
 
         if (!inSpan.consume(static_cast<size_t>(in_item - inSpan.begin()))) {
@@ -180,11 +186,186 @@ public:
 
         return gr::work::Status::OK;
     }
+
+private:
+    // Checks if the resampling ratio is rational, and in that case computes
+    // the filter and the input advance of each phase of the rational schedule
+    void set_rational_schedule()
+    {
+        _interpolation = interpolation;
+        _decimation = decimation;
+        if (_interpolation == 0 || _decimation == 0) {
+            _interpolation = 0;
+            _decimation = 0;
+            if (detect_rational) {
+                for (size_t m = 1; m <= max_rational_interpolation; ++m) {
+                    const auto l = static_cast<size_t>(
+                        std::max(0.0, std::round(static_cast<double>(rate) *
+                                                 static_cast<double>(m))));
+                    if (l > max_rational_interpolation) {
+                        break;
+                    }
+                    if (l != 0 &&
+                        static_cast<TRate>(l) / static_cast<TRate>(m) == rate) {
+                        _interpolation = l;
+                        _decimation = m;
+                        break;
+                    }
+                }
+            }
+        } else {
+            const size_t gcd = std::gcd(_interpolation, _decimation);
+            _interpolation /= gcd;
+            _decimation /= gcd;
+        }
+        _rational = _interpolation != 0 && _interpolation <= max_rational_interpolation;
+        if (!_rational) {
+            if (_interpolation != 0) {
+                // the ratio was given by the parameters, but it has too many
+                // phases
+                const TRate float_rate = static_cast<TRate>(filter_size) *
+                                         static_cast<TRate>(_decimation) /
+                                         static_cast<TRate>(_interpolation);
+                _decim_rate = static_cast<size_t>(std::floor(float_rate));
+                _filt_rate = float_rate - static_cast<TRate>(_decim_rate);
+            }
+            _rational_taps.clear();
+            _rational_advance.clear();
+            return;
+        }
+
+        // The position of the output n, in units of 1 / (filter_size *
+        // _interpolation) input items, is
+        //   q = _last_filter * _interpolation + n * filter_size * _decimation.
+        // The arm and interpolation phase used in the arbitrary path are
+        // given by q / _interpolation and q % _interpolation, and the number
+        // of input items consumed before the output is q / (filter_size *
+        // _interpolation). These are periodic in n with period _interpolation.
+        _rational_taps.assign(_interpolation * _arm_size, TTaps{ 0 });
+        _rational_advance.assign(_interpolation, 0UZ);
+        size_t consumed = 0;
+        for (size_t l = 0; l < _interpolation; ++l) {
+            const size_t q =
+                _last_filter * _interpolation + l * filter_size * _decimation;
+            const size_t arm = (q / _interpolation) % filter_size;
+            const TRate phase = static_cast<TRate>(q % _interpolation) /
+                                static_cast<TRate>(_interpolation);
+            for (size_t m = 0; m < _arm_size; ++m) {
+                const size_t k = 2 * (arm * _arm_size + m);
+                _rational_taps[l * _arm_size + m] =
+                    _taps[k] + static_cast<TTaps>(phase) * _taps[k + 1];
+            }
+            const size_t q_next = q + filter_size * _decimation;
+            const size_t next_consumed = q_next / (filter_size * _interpolation);
+            _rational_advance[l] = next_consumed - consumed;
+            consumed = next_consumed;
+        }
+        _rational_index = 0;
+        _rational_pending = 0;
+    }
+
+    void process_arbitrary(auto& in_item, auto in_end, auto& out_item, auto out_end)
+    {
+        constexpr size_t block_size = DelayLine<TIn>::block_size;
+        while (in_item < in_end && out_item < out_end) {
+            // Schedule a block of outputs. The input items are consumed in the
+            // same way as if each output was computed as soon as possible.
+            const auto remaining = static_cast<size_t>(in_end - in_item);
+            const size_t available = std::min(remaining, block_size);
+            const size_t max_outputs =
+                std::min(static_cast<size_t>(out_end - out_item), block_size);
+            size_t num_inputs = 0;
+            _schedule.clear();
+            while (_schedule.size() < max_outputs && num_inputs < remaining) {
+                while (_last_filter >= filter_size && num_inputs < available) {
+                    ++num_inputs;
+                    _last_filter -= filter_size;
+                }
+                if (_last_filter >= filter_size) {
+                    // not enough input items in this block to continue
+                    break;
+                }
+                _schedule.push_back({ _last_filter, _phase_acc, num_inputs });
+                _phase_acc += _filt_rate;
+                _last_filter += _decim_rate;
+                if (_phase_acc > TRate{ 1 }) {
+                    _phase_acc -= TRate{ 1 };
+                    ++_last_filter;
+                }
+            }
+
+            // Compute the outputs of the block
+            const auto block_end = in_item + static_cast<ssize_t>(num_inputs);
+            _history.push_back_bulk(std::ranges::subrange(in_item, block_end));
+            in_item = block_end;
+            for (const auto& output : _schedule) {
+                const auto [filt_out, diff_out] =
+                    _history.template dual_dot_product<TOut>(
+                        &_taps[2 * output.arm * _arm_size],
+                        num_inputs - output.num_inputs);
+                TOut diff_out_scaled;
+                if constexpr (std::is_floating_point_v<TOut>) {
+                    diff_out_scaled = static_cast<TOut>(output.phase) * diff_out;
+                } else {
+                    // assume that TOut is a std::complex<> type
+                    diff_out_scaled =
+                        static_cast<TOut::value_type>(output.phase) * diff_out;
+                }
+                *out_item++ = filt_out + diff_out_scaled;
+            }
+        }
+    }
+
+    void process_rational(auto& in_item, auto in_end, auto& out_item, auto out_end)
+    {
+        constexpr size_t block_size = DelayLine<TIn>::block_size;
+        while (in_item < in_end && out_item < out_end) {
+            // Schedule a block of outputs, consuming the input items as in
+            // process_arbitrary()
+            const auto remaining = static_cast<size_t>(in_end - in_item);
+            const size_t available = std::min(remaining, block_size);
+            const size_t max_outputs =
+                std::min(static_cast<size_t>(out_end - out_item), block_size);
+            size_t num_inputs = 0;
+            _schedule.clear();
+            while (_schedule.size() < max_outputs && num_inputs < remaining) {
+                const size_t n = std::min(_rational_pending, available - num_inputs);
+                num_inputs += n;
+                _rational_pending -= n;
+                if (_rational_pending != 0) {
+                    // not enough input items in this block to continue
+                    break;
+                }
+                _schedule.push_back({ _rational_index, TRate{ 0 }, num_inputs });
+                _rational_pending = _rational_advance[_rational_index];
+                if (++_rational_index == _interpolation) {
+                    _rational_index = 0;
+                }
+            }
+
+            // Compute the outputs of the block
+            const auto block_end = in_item + static_cast<ssize_t>(num_inputs);
+            _history.push_back_bulk(std::ranges::subrange(in_item, block_end));
+            in_item = block_end;
+            for (const auto& output : _schedule) {
+                *out_item++ = _history.template dot_product<TOut>(
+                    &_rational_taps[output.arm * _arm_size],
+                    num_inputs - output.num_inputs);
+            }
+        }
+    }
 };
 
 } // namespace gr::packet_modem
 
-ENABLE_REFLECTION_FOR_TEMPLATE(
-    gr::packet_modem::PfbArbResampler, in, out, rate, taps, filter_size);
+ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::PfbArbResampler,
+                               in,
+                               out,
+                               rate,
+                               taps,
+                               filter_size,
+                               interpolation,
+                               decimation,
+                               detect_rational);
 
 #endif // _GR4_PACKET_MODEM_PFB_ARB_RESAMPLER
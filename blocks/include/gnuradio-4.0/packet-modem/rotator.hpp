@@ -12,6 +12,7 @@
 #define _GR4_PACKET_MODEM_ROTATOR
 
 #include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/nco.hpp>
 #include <gnuradio-4.0/reflection.hpp>
 #include <complex>
 
@@ -31,9 +32,7 @@ each sample.
 )"">;
 
 public:
-    std::complex<T> _exp = { T{ 1 }, T{ 0 } };
-    std::complex<T> _exp_incr = { T{ 1 }, T{ 0 } };
-    unsigned _counter = 0;
+    Nco<T> _nco;
 
 public:
     gr::PortIn<std::complex<T>> in;
@@ -44,24 +43,18 @@ public:
     void settingsChanged(const gr::property_map& /* old_settings */,
                          const gr::property_map& /* new_settings */)
     {
-        _exp_incr = { std::cos(phase_incr), std::sin(phase_incr) };
+        _nco.set_phase_incr(static_cast<double>(phase_incr));
     }
 
-    void start()
-    {
-        _exp = { T{ 1 }, T{ 0 } };
-        _counter = 0;
-    }
+    void start() { _nco.set(0.0, static_cast<double>(phase_incr)); }
 
-    [[nodiscard]] constexpr std::complex<T> processOne(std::complex<T> a) noexcept
+    // processBulk() is used instead of processOne() so that the NCO can
+    // rotate blocks of samples
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan)
     {
-        const std::complex<T> z = a * _exp;
-        _exp *= _exp_incr;
-        if ((++_counter % 512) == 0) {
-            // normalize to unit amplitude
-            _exp /= std::abs(_exp);
-        }
-        return z;
+        _nco.rotate(inSpan.data(), outSpan.data(), inSpan.size());
+        return gr::work::Status::OK;
     }
 };
 
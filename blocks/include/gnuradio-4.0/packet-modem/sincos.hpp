@@ -0,0 +1,94 @@
+#ifndef _GR4_PACKET_MODEM_SINCOS
+#define _GR4_PACKET_MODEM_SINCOS
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <type_traits>
+
+namespace gr::packet_modem {
+
+namespace sincos_detail {
+
+inline constexpr size_t table_size = 1024;
+
+// exp(2j * pi * k / table_size), for k = 0, ..., table_size - 1
+template <std::floating_point T>
+const std::array<std::complex<T>, table_size>& expj_table()
+{
+    static const auto table = [] {
+        std::array<std::complex<T>, table_size> t;
+        for (size_t k = 0; k < table_size; ++k) {
+            const double x = 2.0 * std::numbers::pi * static_cast<double>(k) /
+                             static_cast<double>(table_size);
+            t[k] = { static_cast<T>(std::cos(x)), static_cast<T>(std::sin(x)) };
+        }
+        return t;
+    }();
+    return table;
+}
+
+} // namespace sincos_detail
+
+// Computes exp(1j * x) = {cos(x), sin(x)} without calling std::cos() and
+// std::sin(). It is intended for per-sample loops in which x depends on the
+// previous iteration (such as the NCO of a PLL), which are limited by the
+// latency of this calculation.
+//
+// The argument is written as x = 2 * pi * n / 1024 + r, with n an integer and
+// |r| <= pi / 1024. The value exp(2j * pi * n / 1024) is read from a table and
+// multiplied by exp(1j * r), which is computed with a short Taylor
+// polynomial. For |x| <= 8 * pi, the absolute error of each component is below
+// 2e-7 for float and below 2e-15 for double (for larger |x| the reduction of
+// the argument loses some accuracy). The table is computed once in double
+// precision, and there is no other state, so the result only depends on x and
+// is reproducible.
+template <std::floating_point T>
+inline std::complex<T> fast_expj(T x) noexcept
+{
+    constexpr auto table_size = sincos_detail::table_size;
+    // The table step 2 * pi / 1024 is split as step_hi + step_lo, with
+    // step_hi having 12 significant bits, so that n * step_hi is exact for
+    // |n| < 4096
+    constexpr double step = 2.0 * std::numbers::pi / static_cast<double>(table_size);
+    constexpr double step_hi_quantum = 0x1p-19;
+    constexpr auto step_hi = static_cast<T>(
+        static_cast<double>(static_cast<int64_t>(step / step_hi_quantum)) *
+        step_hi_quantum);
+    constexpr auto step_lo = static_cast<T>(step - static_cast<double>(step_hi));
+    constexpr auto inv_step = static_cast<T>(1.0 / step);
+
+    // Rounding to nearest by adding and subtracting 1.5 * 2^(digits - 1) has a
+    // shorter latency than converting to an integer and back. The table index
+    // n modulo 1024 is given by the low bits of the mantissa of the sum.
+    constexpr auto round_magic =
+        static_cast<T>(3ULL << (std::numeric_limits<T>::digits - 2));
+    const T shifted = x * inv_step + round_magic;
+    const T nf = shifted - round_magic;
+    using Bits = std::conditional_t<std::is_same_v<T, float>, uint32_t, uint64_t>;
+    const auto index =
+        static_cast<size_t>(std::bit_cast<Bits>(shifted)) & (table_size - 1);
+    const T r = (x - nf * step_hi) - nf * step_lo;
+    const T z = r * r;
+    T c;
+    T s;
+    if constexpr (std::is_same_v<T, float>) {
+        c = 1.0f - 0.5f * z;
+        s = r - r * z * (1.0f / 6.0f);
+    } else {
+        c = T{ 1 } - z * (T{ 0.5 } - z * (T{ 1.0 / 24.0 } - z * T{ 1.0 / 720.0 }));
+        s = r - r * z * (T{ 1.0 / 6.0 } - z * T{ 1.0 / 120.0 });
+    }
+    const std::complex<T> t = sincos_detail::expj_table<T>()[index];
+    return { t.real() * c - t.imag() * s, t.real() * s + t.imag() * c };
+}
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_SINCOS
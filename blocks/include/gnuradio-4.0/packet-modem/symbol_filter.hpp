@@ -2,10 +2,11 @@
 #define _GR4_PACKET_MODEM_SYMBOL_FILTER
 
 #include <gnuradio-4.0/Block.hpp>
-#include <gnuradio-4.0/HistoryBuffer.hpp>
+#include <gnuradio-4.0/packet-modem/delay_line.hpp>
 #include <gnuradio-4.0/packet-modem/pdu.hpp>
 #include <gnuradio-4.0/reflection.hpp>
-#include <numeric>
+#include <algorithm>
+#include <deque>
 #include <vector>
 
 namespace gr::packet_modem {
@@ -29,24 +30,49 @@ The filter taps are given in the `taps` parameter. The block is a template and
 has arguments `TIn`, `TOut`, and `TTaps` to define the types of the input items,
 output items and taps respectively.
 
+The filter is only evaluated for the input samples that produce an output
+symbol. The input samples are appended to a linear history, and each output is
+the dot product of a polyphase arm with a contiguous window of this history,
+which is vectorized for `float` taps and `float` or `std::complex<float>`
+samples.
+
+The block declares to the scheduler a resampling ratio of `samples_per_symbol`
+input items per output item, so that it can run in large chunks. The input
+tags are read with their exact sample index, even when they are in the middle
+of the input span, and the input span is processed in segments between tags.
+The tags waiting to be published are kept in a queue indexed by input sample
+position.
+
 )"">;
 
 private:
     static constexpr char syncword_amplitude_key[] = "syncword_amplitude";
     static constexpr char syncword_time_est_key[] = "syncword_time_est";
 
+    // Computes the output for the last _arm_size samples in the history,
+    // using the current polyphase arm
+    TOut filter() const
+    {
+        const TTaps* arm = &_arm_taps[_pfb_arm * _arm_size];
+        return _scale * _history.template dot_product<TOut>(arm);
+    }
+
 public:
-    // taps in polyphase structure
-    std::vector<std::vector<TTaps>> _taps;
-    // the history constructed here is a placeholder; an appropriate history is
-    // constructed in settingsChanged()
-    gr::HistoryBuffer<TIn> _history{ 1 };
+    // taps in polyphase structure; each arm is reversed and padded with zeros
+    // to _arm_size taps, so that the output is the dot product of the arm
+    // with the last _arm_size input samples in order of arrival
+    std::vector<TTaps> _arm_taps;
+    size_t _arm_size = 1;
+    DelayLine<TIn> _history{ 1 };
     size_t _clock_phase = 0;
     size_t _reset_clock_phase = 0;
     size_t _pfb_arm = 0;
     ssize_t _tag_delay0 = 0;
     ssize_t _tag_delay = 0;
-    std::vector<gr::Tag> _tags{};
+    // tags waiting to be published; their index is the input sample
+    // position (as given by the input stream reader) of the output symbol
+    // nearest to which they go
+    std::deque<gr::Tag> _tags{};
     float _scale = 1.0;
 
 public:
@@ -74,32 +100,19 @@ public:
 
         // set resampling for the scheduler
         //
-        // TODO: this is giving problems with tags (because input tags are not
-        // aligned to samples_per_symbol blocks)
-        //
-        // this->output_chunk_size = 1;
-        // this->input_chunk_size = samples_per_symbol;
+        // The input tags are not aligned to samples_per_symbol blocks, so the
+        // scheduler can give input spans that contain tags after their first
+        // sample. Because of this, the tags are read from the input tag
+        // reader with their exact sample index (see processBulk()).
+        this->output_chunk_size = 1;
+        this->input_chunk_size = samples_per_symbol;
 
         // Organize the taps in a polyphase structure
-        _taps.resize(num_arms);
-        for (size_t j = 0; j < num_arms; ++j) {
-            _taps[j].clear();
-            for (size_t k = j; k < taps.size(); k += num_arms) {
-                _taps[j].push_back(taps[k]);
-            }
-        }
+        _arm_size = std::max(1UZ, (taps.size() + num_arms - 1) / num_arms);
+        _arm_taps = reversed_polyphase_arms(taps, num_arms, _arm_size);
 
-        // create a history of the appropriate size
-        const auto arm_size = _taps[0].size();
-        const auto capacity = std::bit_ceil(arm_size);
-        auto new_history = gr::HistoryBuffer<TIn>(capacity);
-        // fill history with zeros to avoid problems with undefined history contents
-        new_history.push_back_bulk(std::views::repeat(TIn{}, capacity));
-        // move old history items to the new history
-        for (ssize_t j = static_cast<ssize_t>(_history.size()) - 1; j >= 0; --j) {
-            new_history.push_back(_history[static_cast<size_t>(j)]);
-        }
-        _history = new_history;
+        // resize the history, keeping the most recent samples
+        _history.resize(_arm_size);
 
         // _reset_clock_phase = -delay `mod` sps
         // (typically this will be zero)
@@ -107,7 +120,11 @@ public:
             (samples_per_symbol - (delay % samples_per_symbol)) % samples_per_symbol;
     }
 
-    void start() { _clock_phase = 0; }
+    void start()
+    {
+        _clock_phase = 0;
+        _tags.clear();
+    }
 
     gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
                                  gr::PublishableSpan auto& outSpan)
@@ -122,133 +139,210 @@ public:
                      _scale,
                      _pfb_arm);
 #endif
+        // The input span is processed in segments that end at each input tag,
+        // so that the tags are handled at their exact sample index, even if
+        // they are not at the beginning of the span.
+        const auto read_position = static_cast<ssize_t>(in.streamReader().position());
+        const auto input_tags = get_input_tags(read_position, inSpan.size());
+        auto next_tag = input_tags.cbegin();
         auto out_item = outSpan.begin();
         auto in_item = inSpan.begin();
-        if (this->input_tags_present()) {
-            auto tag = this->mergedInputTag();
-            ssize_t tag_index_adjust = 0;
-            if (tag.map.contains(syncword_amplitude_key)) {
-#ifdef TRACE
-                fmt::println("{} got {} tag", this->name, syncword_amplitude_key);
-#endif
-                // The first item is the beginning of the modulated
-                // syncword. After pushing back delay + 1 items to the history,
-                // the first syncword symbol should be output, which means that
-                // _clock_phase should be 0 at that point. Between now and that
-                // moment, _clock_phase is incremented delay times, so we adjust
-                // _clock_phase to account for this (see calculation for
-                // _reset_clock_phase above).
-                size_t new_clock_phase = _reset_clock_phase;
-                _scale = 1.0f / pmtv::cast<float>(tag.map[syncword_amplitude_key]);
-
-                // time_est is in the range [-0.5, 0.5]
-                float time_est = pmtv::cast<float>(tag.map[syncword_time_est_key]);
-                // The PFB can only go "forward" in time, so to go back we add 1
-                // to _clock_phase
-                if (time_est < 0.0f) {
-                    new_clock_phase = (new_clock_phase + 1UZ) % samples_per_symbol;
-                    time_est += 1.0f;
-                    // adjust phase by one sample
-                    float syncword_phase = pmtv::cast<float>(tag.map["syncword_phase"]);
-                    double syncword_freq = pmtv::cast<double>(tag.map["syncword_freq"]);
-                    tag.map["syncword_phase"] = pmtv::pmt(static_cast<float>(
-                        static_cast<double>(syncword_phase) - syncword_freq));
+        while (true) {
+            if (next_tag != input_tags.cend() &&
+                next_tag->index == read_position + (in_item - inSpan.begin())) {
+                if (out_item == outSpan.end()) {
+                    // the tag is handled in the next call, because it can
+                    // require producing an output
+                    break;
                 }
+                process_tag(*next_tag, in_item, out_item, outSpan.begin());
+                ++next_tag;
+            }
+            const auto segment_end =
+                next_tag != input_tags.cend()
+                    ? inSpan.begin() + (next_tag->index - read_position)
+                    : inSpan.end();
+            filter_segment(in_item,
+                           segment_end,
+                           read_position + (in_item - inSpan.begin()),
+                           out_item,
+                           outSpan.begin(),
+                           outSpan.end());
+            if (in_item != segment_end || in_item == inSpan.end()) {
+                break;
+            }
+        }
 
-                // Special case to avoid skipping one output symbol when
-                // _clock_phase == 0 and new_clock_phase == 1
-                if (_clock_phase == 0 && new_clock_phase == 1) {
-                    _history.push_back(*in_item++);
-                    *out_item = _scale * std::inner_product(_taps[_pfb_arm].cbegin(),
-                                                            _taps[_pfb_arm].cend(),
-                                                            _history.cbegin(),
-                                                            TOut{});
-                    // Check to see if we need to output a tag. Tags go on the
-                    // "nearest" possible output sample, which means when their
-                    // index is in the interval [sps/2, sps/2).
-                    while (!_tags.empty() &&
-                           _tags[0].index <
-                               static_cast<ssize_t>(samples_per_symbol / 2)) {
+        if (!inSpan.consume(static_cast<size_t>(in_item - inSpan.begin()))) {
+            throw gr::exception("consume failed");
+        }
+        outSpan.publish(static_cast<size_t>(out_item - outSpan.begin()));
 #ifdef TRACE
-                        fmt::println("{} publishTag() {} at index = {}",
-                                     this->name,
-                                     _tags[0].map,
-                                     out_item - outSpan.begin());
+        fmt::println("{} consumed = {}, published = {}",
+                     this->name,
+                     in_item - inSpan.begin(),
+                     out_item - outSpan.begin());
 #endif
-                        out.publishTag(_tags[0].map, out_item - outSpan.begin());
-                        _tags.erase(_tags.begin());
-                    }
-                    ++out_item;
-                    ++new_clock_phase;
-                    for (auto& t : _tags) {
-                        --t.index;
-                    }
-                    // account for the fact that the index of the current has
-                    // not been decreased in this loop
-                    tag_index_adjust = -1;
-                }
-                // Special case to avoid duplicating one output symbol when
-                // _clock_phase == 1 and new_clock_phase == 0
-                else if (_clock_phase == 1 && new_clock_phase == 0) {
-                    _history.push_back(*in_item++);
-                    ++new_clock_phase;
-                }
 
-                _clock_phase = new_clock_phase;
-                // time_est is now in the range [0.0, 1.0]
-                _pfb_arm = std::clamp(static_cast<size_t>(std::round(
-                                          static_cast<float>(num_arms) * time_est)),
-                                      0UZ,
-                                      num_arms - 1UZ);
+        return gr::work::Status::OK;
+    }
+
+private:
+    // Returns the input tags with index in [read_position, read_position +
+    // num_items), merging the tags that have the same index. The tags are
+    // read directly from the tag reader because the merged input tag given
+    // by the scheduler does not have the exact index of the tags when the
+    // input span is a multiple of input_chunk_size.
+    std::vector<gr::Tag> get_input_tags(ssize_t read_position, size_t num_items)
+    {
+        std::vector<gr::Tag> span_tags;
+        const ssize_t end = read_position + static_cast<ssize_t>(num_items);
+        const gr::ConsumableSpan auto tag_data = in.tagReader().get();
+        for (const auto& tag : tag_data) {
+            if (tag.index >= read_position && tag.index < end) {
+                span_tags.push_back(tag);
+            }
+        }
+        std::ranges::stable_sort(span_tags, {}, &gr::Tag::index);
+        std::vector<gr::Tag> tags;
+        for (auto& tag : span_tags) {
+            if (tags.empty() || tags.back().index != tag.index) {
+                tags.push_back(std::move(tag));
+            } else {
+                for (const auto& [key, value] : tag.map) {
+                    tags.back().map.insert_or_assign(key, value);
+                }
             }
-            tag.index = static_cast<ssize_t>(delay) + tag_index_adjust;
-            _tags.push_back(tag);
         }
+        return tags;
+    }
 
-        while (out_item < outSpan.end() && in_item < inSpan.end()) {
-            _history.push_back(*in_item++);
-            if (_clock_phase == 0) {
-                *out_item = _scale * std::inner_product(_taps[_pfb_arm].cbegin(),
-                                                        _taps[_pfb_arm].cend(),
-                                                        _history.cbegin(),
-                                                        TOut{});
-                // Check to see if we need to output a tag. Tags go on the
-                // "nearest" possible output sample, which means when their
-                // index is in the interval [sps/2, sps/2).
-                while (!_tags.empty() &&
-                       _tags[0].index < static_cast<ssize_t>(samples_per_symbol / 2)) {
+    // Handles an input tag whose index is the sample at in_item. The
+    // syncword_amplitude tags update the clock phase, the polyphase arm and
+    // the scale. All the tags are queued to be published on the output
+    // symbol nearest to their sample index plus the filter delay.
+    void process_tag(gr::Tag tag, auto& in_item, auto& out_item, auto out_begin)
+    {
+        const ssize_t tag_position = tag.index;
+        const auto in_tag_item = in_item;
+        ssize_t tag_index_adjust = 0;
+        if (tag.map.contains(syncword_amplitude_key)) {
 #ifdef TRACE
-                    fmt::println("{} publishTag() {} at index = {}",
-                                 this->name,
-                                 _tags[0].map,
-                                 out_item - outSpan.begin());
+            fmt::println("{} got {} tag", this->name, syncword_amplitude_key);
 #endif
-                    out.publishTag(_tags[0].map, out_item - outSpan.begin());
-                    _tags.erase(_tags.begin());
-                }
-                ++out_item;
+            // The first item is the beginning of the modulated
+            // syncword. After pushing back delay + 1 items to the history,
+            // the first syncword symbol should be output, which means that
+            // _clock_phase should be 0 at that point. Between now and that
+            // moment, _clock_phase is incremented delay times, so we adjust
+            // _clock_phase to account for this (see calculation for
+            // _reset_clock_phase above).
+            size_t new_clock_phase = _reset_clock_phase;
+            _scale = 1.0f / pmtv::cast<float>(tag.map[syncword_amplitude_key]);
+
+            // time_est is in the range [-0.5, 0.5]
+            float time_est = pmtv::cast<float>(tag.map[syncword_time_est_key]);
+            // The PFB can only go "forward" in time, so to go back we add 1
+            // to _clock_phase
+            if (time_est < 0.0f) {
+                new_clock_phase = (new_clock_phase + 1UZ) % samples_per_symbol;
+                time_est += 1.0f;
+                // adjust phase by one sample
+                float syncword_phase = pmtv::cast<float>(tag.map["syncword_phase"]);
+                double syncword_freq = pmtv::cast<double>(tag.map["syncword_freq"]);
+                tag.map["syncword_phase"] = pmtv::pmt(static_cast<float>(
+                    static_cast<double>(syncword_phase) - syncword_freq));
             }
-            ++_clock_phase;
-            if (_clock_phase >= samples_per_symbol) {
-                _clock_phase = 0;
+
+            // Special case to avoid skipping one output symbol when
+            // _clock_phase == 0 and new_clock_phase == 1
+            if (_clock_phase == 0 && new_clock_phase == 1) {
+                _history.push_back(*in_item++);
+                *out_item = filter();
+                publish_tags(tag_position, out_item - out_begin);
+                ++out_item;
+                ++new_clock_phase;
+                // account for the fact that the sample consumed here is not
+                // counted in the tag delay
+                tag_index_adjust = -1;
             }
-            for (auto& tag : _tags) {
-                --tag.index;
+            // Special case to avoid duplicating one output symbol when
+            // _clock_phase == 1 and new_clock_phase == 0
+            else if (_clock_phase == 1 && new_clock_phase == 0) {
+                _history.push_back(*in_item++);
+                ++new_clock_phase;
             }
+
+            _clock_phase = new_clock_phase;
+            // time_est is now in the range [0.0, 1.0]
+            _pfb_arm = std::clamp(
+                static_cast<size_t>(std::round(static_cast<float>(num_arms) * time_est)),
+                0UZ,
+                num_arms - 1UZ);
         }
+        // the tag index is the delay (plus adjustment) after the next input
+        // sample, which is the sample after the tag if it has been consumed
+        // by one of the special cases above
+        tag.index = tag_position + static_cast<ssize_t>(delay) + tag_index_adjust +
+                    (in_item - in_tag_item);
+        _tags.push_back(std::move(tag));
+    }
 
-        if (!inSpan.consume(static_cast<size_t>(in_item - inSpan.begin()))) {
-            throw gr::exception("consume failed");
+    // Filters the input samples in [in_item, in_end), where position is the
+    // index of the sample at in_item, advancing in_item and out_item. The
+    // input is consumed until the output is full. Only the input samples for
+    // which _clock_phase is zero produce an output.
+    void filter_segment(auto& in_item,
+                        auto in_end,
+                        ssize_t position,
+                        auto& out_item,
+                        auto out_begin,
+                        auto out_end)
+    {
+        const size_t sps = samples_per_symbol;
+        const auto num_input = static_cast<size_t>(in_end - in_item);
+        const auto num_output = static_cast<size_t>(out_end - out_item);
+        const size_t first_output = (sps - _clock_phase) % sps;
+        size_t n = num_input;
+        if (num_output == 0) {
+            n = 0;
+        } else if (first_output + (num_output - 1) * sps < num_input) {
+            n = first_output + (num_output - 1) * sps + 1;
         }
-        outSpan.publish(static_cast<size_t>(out_item - outSpan.begin()));
+        size_t pushed = 0;
+        for (size_t k = first_output; k < n; k += sps) {
+            // the filter window ends at the input sample k
+            _history.push_back_bulk(
+                std::ranges::subrange(in_item + static_cast<ssize_t>(pushed),
+                                      in_item + static_cast<ssize_t>(k + 1)));
+            pushed = k + 1;
+            *out_item = filter();
+            publish_tags(position + static_cast<ssize_t>(k), out_item - out_begin);
+            ++out_item;
+        }
+        _history.push_back_bulk(std::ranges::subrange(
+            in_item + static_cast<ssize_t>(pushed), in_item + static_cast<ssize_t>(n)));
+        in_item += static_cast<ssize_t>(n);
+        _clock_phase = (_clock_phase + n) % sps;
+    }
+
+    // Publishes the queued tags that go on the output symbol produced by the
+    // input sample at position. Tags go on the "nearest" possible output
+    // symbol, which means when their index relative to the input sample is
+    // in the interval [-sps/2, sps/2).
+    void publish_tags(ssize_t position, ssize_t output_index)
+    {
+        while (!_tags.empty() && _tags.front().index - position <
+                                     static_cast<ssize_t>(samples_per_symbol / 2)) {
 #ifdef TRACE
-        fmt::println("{} consumed = {}, published = {}",
-                     this->name,
-                     in_item - inSpan.begin(),
-                     out_item - outSpan.begin());
+            fmt::println("{} publishTag() {} at index = {}",
+                         this->name,
+                         _tags.front().map,
+                         output_index);
 #endif
-
-        return gr::work::Status::OK;
+            out.publishTag(_tags.front().map, output_index);
+            _tags.pop_front();
+        }
     }
 };
 
@@ -0,0 +1,402 @@
+#ifndef _GR4_PACKET_MODEM_SYNCWORD_CORRELATOR
+#define _GR4_PACKET_MODEM_SYNCWORD_CORRELATOR
+
+#include <gnuradio-4.0/Block.hpp>
+#include <gnuradio-4.0/packet-modem/fft.hpp>
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace gr::packet_modem {
+
+// Computes the overlap-save correlation of a segment of samples against a
+// syncword template shifted to several frequency bins.
+//
+// All the workspaces are allocated in init() and reused for every
+// segment. The correlations for all the frequency bins are computed with a
+// single batched FFT. The correlation for each frequency bin is stored
+// contiguously, so that correlation(nfreq) returns a pointer to fft_size items.
+//
+// The correlator has a number of independent workspaces (slots), so that the
+// results for several segments can be kept at the same time. Additionally, the
+// correlation can be computed only for the frequency bins whose index is
+// congruent to a given value modulo bin_step, which is used for coarse
+// searches.
+class SyncwordCorrelator
+{
+public:
+    using c64 = std::complex<float>;
+
+    // Identifies the templates produced by the make_template function given to
+    // init(). Correlators initialized with equal keys (and equal sizes and FFT
+    // backend) share the FFTs of the templates, which are computed only once
+    // per process.
+    struct TemplateKey {
+        std::vector<c64> syncword_samples;
+        int min_freq_bin;
+        size_t decimation;
+
+        bool operator==(const TemplateKey&) const = default;
+    };
+
+private:
+    struct CacheKey {
+        TemplateKey key;
+        size_t template_size;
+        size_t fft_size;
+        size_t num_freq_bins;
+        FftBackend backend;
+
+        bool operator==(const CacheKey&) const = default;
+    };
+
+    using Table = std::shared_ptr<const c64[]>;
+
+    // Cache of the conj(FFT(syncword)) tables. The most recently used tables
+    // are at the back.
+    struct TableCache {
+        static constexpr size_t max_size = 16;
+        std::mutex mutex;
+        std::deque<std::pair<CacheKey, Table>> entries;
+    };
+
+    static TableCache& table_cache()
+    {
+        static TableCache cache;
+        return cache;
+    }
+
+    struct Slot {
+        // input segment (FFTW requires aligned buffers to use SIMD)
+        fftw::buffer<c64> samples;
+        fftw::buffer<c64> spectrum;
+        // FFT(samples) * conj(FFT(syncword)) for each freq bin, which gets
+        // transformed in-place into the correlation
+        fftw::buffer<c64> correlation;
+    };
+
+    size_t _fft_size = 0;
+    // distance between the correlations of consecutive freq bins. It is
+    // rounded up so that all of them have the same alignment, which is
+    // needed to execute the same plan on any of them.
+    size_t _row_stride = 0;
+    size_t _num_freq_bins = 0;
+    size_t _bin_step = 1;
+    std::vector<Slot> _slots;
+    // conj(FFT(syncword)) for each freq bin, with the same layout as the
+    // correlation
+    Table _syncword_fft_conj;
+    Fft _forward_fft;
+    Fft _correlation_fft;
+    // _strided_ffts[r] computes the correlation of the freq bins r, r +
+    // _bin_step, r + 2 * _bin_step, ...
+    std::vector<Fft> _strided_ffts;
+    // computes the correlation of a single freq bin
+    Fft _row_fft;
+
+    size_t num_strided_bins(size_t first_bin) const noexcept
+    {
+        return first_bin < _num_freq_bins
+                   ? (_num_freq_bins - first_bin + _bin_step - 1) / _bin_step
+                   : 0;
+    }
+
+    static Table lookup_table(const CacheKey& key)
+    {
+        auto& cache = table_cache();
+        std::lock_guard lock(cache.mutex);
+        const auto it =
+            std::ranges::find(cache.entries, key, &std::pair<CacheKey, Table>::first);
+        if (it == cache.entries.end()) {
+            return {};
+        }
+        auto entry = std::move(*it);
+        cache.entries.erase(it);
+        cache.entries.push_back(std::move(entry));
+        return cache.entries.back().second;
+    }
+
+    static void insert_table(CacheKey key, Table table)
+    {
+        auto& cache = table_cache();
+        std::lock_guard lock(cache.mutex);
+        if (cache.entries.size() == TableCache::max_size) {
+            cache.entries.pop_front();
+        }
+        cache.entries.emplace_back(std::move(key), std::move(table));
+    }
+
+    void multiply(Slot& slot, size_t first_bin, size_t step, size_t end_bin)
+    {
+        // Multiply the spectrum by each of the syncword templates. The loop
+        // runs over the whole batch of products so that it can be vectorized.
+        const c64* spectrum = slot.spectrum.get();
+        for (size_t nfreq = first_bin; nfreq < end_bin; nfreq += step) {
+            const c64* syncword_fft_conj = &_syncword_fft_conj[nfreq * _row_stride];
+            c64* prod = &slot.correlation[nfreq * _row_stride];
+            for (const size_t k : std::views::iota(0UZ, _fft_size)) {
+                // written explicitly rather than with operator* so that the
+                // compiler does not need to handle the inf/nan corner cases
+                // of complex multiplication and can vectorize the loop
+                const float re = spectrum[k].real() * syncword_fft_conj[k].real() -
+                                 spectrum[k].imag() * syncword_fft_conj[k].imag();
+                const float im = spectrum[k].real() * syncword_fft_conj[k].imag() +
+                                 spectrum[k].imag() * syncword_fft_conj[k].real();
+                prod[k] = c64{ re, im };
+            }
+        }
+    }
+
+public:
+    // Shifts the syncword_samples in frequency by freq_bin bins. Each
+    // frequency bin is 1/2 of the coherent integration interval.
+    static void shift_frequency(std::span<const c64> syncword_samples,
+                                int freq_bin,
+                                std::span<c64> shifted)
+    {
+        double phase = 0.0;
+        const double phase_incr = static_cast<double>(freq_bin) * std::numbers::pi /
+                                  static_cast<double>(syncword_samples.size());
+        for (const size_t j : std::views::iota(0UZ, syncword_samples.size())) {
+            shifted[j] = syncword_samples[j] * c64{ static_cast<float>(std::cos(phase)),
+                                                    static_cast<float>(std::sin(phase)) };
+            phase += phase_incr;
+            if (phase >= std::numbers::pi) {
+                phase -= 2.0 * std::numbers::pi;
+            } else if (phase < -std::numbers::pi) {
+                phase += 2.0 * std::numbers::pi;
+            }
+        }
+    }
+
+    // Initializes the correlator. The syncword_samples are the modulated
+    // syncword, which gets shifted in frequency to each of the bins from
+    // min_freq_bin to max_freq_bin, both included.
+    void init(std::span<const c64> syncword_samples,
+              size_t fft_size,
+              int min_freq_bin,
+              int max_freq_bin,
+              size_t bin_step = 1,
+              size_t num_slots = 1,
+              const FftConfig& fft_config = {})
+    {
+        if (min_freq_bin > max_freq_bin) {
+            throw gr::exception("min_freq_bin is greater than max_freq_bin");
+        }
+        init(
+            syncword_samples.size(),
+            fft_size,
+            static_cast<size_t>(max_freq_bin - min_freq_bin + 1),
+            bin_step,
+            num_slots,
+            [&](size_t nfreq, std::span<c64> syncword_template) {
+                shift_frequency(syncword_samples,
+                                min_freq_bin + static_cast<int>(nfreq),
+                                syncword_template);
+            },
+            fft_config,
+            TemplateKey{ { syncword_samples.begin(), syncword_samples.end() },
+                         min_freq_bin,
+                         1 });
+    }
+
+    // Initializes the correlator with arbitrary templates. The function
+    // make_template(nfreq, syncword_template) is called for each frequency bin
+    // to fill the template_size samples of syncword_template. If a key is
+    // given, make_template is not called when the FFTs of the templates are
+    // found in the cache.
+    template <typename F>
+    void init(size_t template_size,
+              size_t fft_size,
+              size_t num_freq_bins,
+              size_t bin_step,
+              size_t num_slots,
+              F&& make_template,
+              const FftConfig& fft_config = {},
+              std::optional<TemplateKey> key = std::nullopt)
+    {
+        if (template_size > fft_size) {
+            throw gr::exception("fft_size too small");
+        }
+        if (num_freq_bins == 0) {
+            throw gr::exception("num_freq_bins cannot be zero");
+        }
+        if (bin_step == 0) {
+            throw gr::exception("bin_step cannot be zero");
+        }
+        if (num_slots == 0) {
+            throw gr::exception("num_slots cannot be zero");
+        }
+        _fft_size = fft_size;
+        // 16 complex items are 128 bytes, which is more than the alignment
+        // required by any SIMD instruction set
+        _row_stride = (fft_size + 15) / 16 * 16;
+        _num_freq_bins = num_freq_bins;
+        _bin_step = bin_step;
+        _slots.clear();
+        _slots.resize(num_slots);
+        for (auto& slot : _slots) {
+            slot.samples = fftw::allocate<c64>(_fft_size);
+            slot.spectrum = fftw::allocate<c64>(_fft_size);
+            slot.correlation = fftw::allocate<c64>(_num_freq_bins * _row_stride);
+        }
+
+        Slot& slot0 = _slots[0];
+        _forward_fft.init(fft_config,
+                          _fft_size,
+                          1,
+                          _fft_size,
+                          slot0.samples.get(),
+                          slot0.spectrum.get());
+        // The IFFT is computed as an FFT, so the sign of its time axis is
+        // flipped.
+        const auto init_bins = [&](Fft& fft, size_t first_bin, size_t step) {
+            c64* correlation = &slot0.correlation[first_bin * _row_stride];
+            fft.init(fft_config,
+                     _fft_size,
+                     (_num_freq_bins - first_bin + step - 1) / step,
+                     step * _row_stride,
+                     correlation,
+                     correlation);
+        };
+        init_bins(_correlation_fft, 0, 1);
+        _row_fft.init(fft_config,
+                      _fft_size,
+                      1,
+                      _row_stride,
+                      slot0.correlation.get(),
+                      slot0.correlation.get());
+        _strided_ffts.clear();
+        if (_bin_step > 1) {
+            _strided_ffts.resize(_bin_step);
+            for (const size_t first_bin : std::views::iota(0UZ, _bin_step)) {
+                if (num_strided_bins(first_bin) > 0) {
+                    init_bins(_strided_ffts[first_bin], first_bin, _bin_step);
+                }
+            }
+        }
+
+        std::optional<CacheKey> cache_key;
+        if (key.has_value()) {
+            cache_key = CacheKey{ std::move(*key),
+                                  template_size,
+                                  _fft_size,
+                                  _num_freq_bins,
+                                  fft_config.backend };
+            _syncword_fft_conj = lookup_table(*cache_key);
+            if (_syncword_fft_conj) {
+                return;
+            }
+        }
+
+        auto table = fftw::allocate<c64>(_num_freq_bins * _row_stride);
+        for (const size_t nfreq : std::views::iota(0UZ, _num_freq_bins)) {
+            std::fill_n(slot0.samples.get(), _fft_size, c64{});
+            make_template(nfreq, std::span<c64>{ slot0.samples.get(), template_size });
+            _forward_fft.execute(slot0.samples.get(), slot0.spectrum.get());
+            std::ranges::transform(slot0.spectrum.get(),
+                                   slot0.spectrum.get() + _fft_size,
+                                   &table[nfreq * _row_stride],
+                                   [](c64 z) { return std::conj(z); });
+        }
+        _syncword_fft_conj = Table(table.release(), fftw::free_deleter{});
+        if (cache_key.has_value()) {
+            insert_table(std::move(*cache_key), _syncword_fft_conj);
+        }
+    }
+
+    // Computes the FFT of a segment, storing it in a slot. The input range
+    // must contain at least fft_size samples.
+    template <typename Range>
+    void compute_spectrum(size_t slot, Range&& samples)
+    {
+        Slot& s = _slots[slot];
+        std::ranges::copy(samples | std::views::take(_fft_size), s.samples.get());
+        _forward_fft.execute(s.samples.get(), s.spectrum.get());
+    }
+
+    // Computes IFFT(FFT(samples) * conj(FFT(syncword))) for all the frequency
+    // bins, using the spectrum stored in the slot.
+    void correlate(size_t slot)
+    {
+        Slot& s = _slots[slot];
+        multiply(s, 0, 1, _num_freq_bins);
+        c64* correlation = s.correlation.get();
+        _correlation_fft.execute(correlation, correlation);
+    }
+
+    // Computes the correlation only for the frequency bins first_bin, first_bin
+    // + bin_step, first_bin + 2 * bin_step, ...
+    void correlate_strided(size_t slot, size_t first_bin)
+    {
+        if (_bin_step == 1) {
+            if (first_bin == 0) {
+                correlate(slot);
+            }
+            return;
+        }
+        if (num_strided_bins(first_bin) == 0) {
+            return;
+        }
+        Slot& s = _slots[slot];
+        multiply(s, first_bin, _bin_step, _num_freq_bins);
+        c64* correlation = &s.correlation[first_bin * _row_stride];
+        _strided_ffts[first_bin].execute(correlation, correlation);
+    }
+
+    // Computes the correlation only for the frequency bins from first_bin to
+    // end_bin (not included). This is cheaper than correlate() when only a few
+    // frequency bins are needed.
+    void correlate_range(size_t slot, size_t first_bin, size_t end_bin)
+    {
+        end_bin = std::min(end_bin, _num_freq_bins);
+        Slot& s = _slots[slot];
+        multiply(s, first_bin, 1, end_bin);
+        for (size_t nfreq = first_bin; nfreq < end_bin; ++nfreq) {
+            c64* correlation = &s.correlation[nfreq * _row_stride];
+            _row_fft.execute(correlation, correlation);
+        }
+    }
+
+    // Computes the spectrum and correlation of a segment using slot 0
+    template <typename Range>
+    void compute(Range&& samples)
+    {
+        compute_spectrum(0, std::forward<Range>(samples));
+        correlate(0);
+    }
+
+    size_t fft_size() const noexcept { return _fft_size; }
+
+    size_t num_freq_bins() const noexcept { return _num_freq_bins; }
+
+    size_t bin_step() const noexcept { return _bin_step; }
+
+    size_t num_slots() const noexcept { return _slots.size(); }
+
+    // FFT of the last segment stored in the slot
+    const c64* spectrum(size_t slot = 0) const noexcept
+    {
+        return _slots[slot].spectrum.get();
+    }
+
+    // Correlation for the last segment stored in the slot. The correlation is
+    // time-reversed, because the IFFT is computed as an FFT.
+    const c64* correlation(size_t nfreq, size_t slot = 0) const noexcept
+    {
+        return &_slots[slot].correlation[nfreq * _row_stride];
+    }
+};
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_SYNCWORD_CORRELATOR
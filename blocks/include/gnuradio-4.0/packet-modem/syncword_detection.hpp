@@ -2,34 +2,514 @@
 #define _GR4_PACKET_MODEM_SYNCWORD_DETECTION
 
 #include <gnuradio-4.0/Block.hpp>
-#include <gnuradio-4.0/HistoryBuffer.hpp>
-#include <gnuradio-4.0/algorithm/fourier/fftw.hpp>
+#include <gnuradio-4.0/packet-modem/fft.hpp>
+#include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/syncword_correlator.hpp>
+#include <gnuradio-4.0/packet-modem/worker_pool.hpp>
 #include <gnuradio-4.0/reflection.hpp>
+#include <magic_enum.hpp>
 #include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
 #include <complex>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
 #include <numbers>
 #include <numeric>
+#include <random>
 #include <ranges>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 namespace gr::packet_modem {
 
 namespace syncword_detection {
-struct HistoryItem {
+
+// FULL computes the correlation for all the frequency bins in every
+// segment. TWO_STAGE first computes the correlation only for a coarse grid of
+// frequency bins and computes the rest of the bins only near segments where
+// the coarse grid has found a candidate peak.
+enum class SearchMode { FULL, TWO_STAGE };
+
+// MEDIAN declares a detection when a correlation peak is the maximum in a
+// window of +/-time_threshold items and it is above power_threshold times the
+// median of the window. CAUSAL declares a detection when a correlation peak is
+// above an absolute threshold given by the noise power and no larger peak
+// follows it within a short lookahead.
+enum class DetectionMode { MEDIAN, CAUSAL };
+
+// Correlation peak found for an item. This is only kept for the current
+// candidate for a detection.
+struct CorrelationItem {
     using c64 = std::complex<float>;
-    c64 sample;
-    float correlation_power;
+    float correlation_power = 0.0f;
     // correlation power in adjacent bins; used for quadratic interpolation
     // for finer frequency estimate
-    float correlation_power_left;
-    float correlation_power_right;
+    float correlation_power_left = 0.0f;
+    float correlation_power_right = 0.0f;
+    // whether the correlation power in the adjacent bins has been computed,
+    // which is not the case at the edges of the frequency bins searched
+    bool has_left = false;
+    bool has_right = false;
     c64 correlation;
-    int freq_bin;
-    float fft_noise_power;
-    bool detection = false;
+    int freq_bin = 0;
+    // index of the syncword in the list of syncwords
+    int syncword_id = 0;
+    float fft_noise_power = 0.0f;
+};
+
+// History of correlation powers used to check the median condition.
+//
+// The powers are stored in a ring buffer in which each item is written twice,
+// so that the last size() items are always contiguous in memory. This makes
+// counting the items below a threshold a single pass over a float array that
+// the compiler can vectorize.
+class PowerHistory
+{
+private:
+    std::vector<float> _buffer;
+    size_t _size = 0;
+    // index of the oldest item
+    size_t _pos = 0;
+
+public:
+    void reset(size_t size)
+    {
+        _size = size;
+        _buffer.assign(2 * size, 0.0f);
+        _pos = 0;
+    }
+
+    size_t size() const noexcept { return _size; }
+
+    void push_back(float power) noexcept
+    {
+        _buffer[_pos] = power;
+        _buffer[_pos + _size] = power;
+        if (++_pos == _size) {
+            _pos = 0;
+        }
+    }
+
+    // the last size() items, in order of arrival
+    std::span<const float> window() const noexcept
+    {
+        return { _buffer.data() + _pos, _size };
+    }
+
+    size_t count_below(float threshold) const noexcept
+    {
+        uint32_t count = 0;
+        for (const float power : window()) {
+            count += power < threshold ? 1U : 0U;
+        }
+        return count;
+    }
+};
+
+// Computes noise power as the power in the outermost 1/2 of the FFT bin (note
+// that there is no fftshift, so the outermost 1/2 is actually the central 1/2)
+inline float spectrum_noise_power(const std::complex<float>* samples_fft,
+                                  size_t fft_size)
+{
+    float fft_noise_power = 0.0f;
+    for (const size_t k : std::views::iota(fft_size / 4, 3 * fft_size / 4)) {
+        const auto z = samples_fft[k];
+        fft_noise_power += z.real() * z.real() + z.imag() * z.imag();
+    }
+    // dividing by fft_size (which is sqrt(fft_size) squared) is needed
+    // to obtain a unitary FFT transform
+    return fft_noise_power /
+           (static_cast<float>(fft_size / 2) * static_cast<float>(fft_size));
+}
+
+// Input samples kept from previous calls to processBulk().
+//
+// These are used to produce the output, which is the input delayed by a fixed
+// number of samples, and to look back at past input samples. The output is
+// written with bulk copies from these samples and from the input span, rather
+// than sample by sample.
+class InputTail
+{
+private:
+    using c64 = std::complex<float>;
+
+    // oldest sample first
+    std::vector<c64> _samples;
+
+public:
+    void reset(size_t size) { _samples.assign(size, c64{}); }
+
+    size_t size() const noexcept { return _samples.size(); }
+
+    // Sample that was received age samples before the first sample of the
+    // current input. The age must be between 1 and size().
+    c64 past(size_t age) const noexcept { return _samples[_samples.size() - age]; }
+
+    // Writes n output samples, which are the input delayed by delay
+    // samples. The delay must not be larger than size().
+    template <typename In, typename Out>
+    void delayed_copy(const In& in, Out& out, size_t n, size_t delay) const
+    {
+        const auto tail = _samples.cend() - static_cast<ssize_t>(delay);
+        if (n <= delay) {
+            std::copy_n(tail, n, out.begin());
+        } else {
+            std::copy_n(tail, delay, out.begin());
+            std::copy_n(in.begin(), n - delay, out.begin() + static_cast<ssize_t>(delay));
+        }
+    }
+
+    // Appends the first n input samples, dropping the oldest samples
+    template <typename In>
+    void push(const In& in, size_t n)
+    {
+        const size_t size = _samples.size();
+        if (n >= size) {
+            std::copy_n(
+                in.begin() + static_cast<ssize_t>(n - size), size, _samples.begin());
+        } else {
+            std::copy(_samples.cbegin() + static_cast<ssize_t>(n),
+                      _samples.cend(),
+                      _samples.begin());
+            std::copy_n(in.begin(), n, _samples.end() - static_cast<ssize_t>(n));
+        }
+    }
+};
+
+// Estimates the noise power of a block of samples with its own FFT. This is
+// used when the correlation is computed on a decimated version of the input,
+// since the decimation filter removes the part of the spectrum where the noise
+// power is measured.
+class NoiseEstimator
+{
+private:
+    using c64 = std::complex<float>;
+
+    size_t _fft_size = 0;
+    fftw::buffer<c64> _samples;
+    fftw::buffer<c64> _spectrum;
+    Fft _fft;
+
+public:
+    void init(size_t fft_size, const FftConfig& fft_config = {})
+    {
+        _fft_size = fft_size;
+        _samples = fftw::allocate<c64>(fft_size);
+        _spectrum = fftw::allocate<c64>(fft_size);
+        _fft.init(fft_config, fft_size, 1, fft_size, _samples.get(), _spectrum.get());
+    }
+
+    size_t fft_size() const noexcept { return _fft_size; }
+
+    // Estimates the noise power of fft_size() samples
+    template <typename Range>
+    float estimate(Range&& samples)
+    {
+        std::ranges::copy(samples | std::views::take(_fft_size), _samples.get());
+        _fft.execute(_samples.get(), _spectrum.get());
+        return spectrum_noise_power(_spectrum.get(), _fft_size);
+    }
 };
+
+// Decides which segments need to be correlated by measuring their energy.
+//
+// Each segment is divided in blocks, and the segment is active if the mean
+// power of any of its blocks is above threshold times the noise floor. The
+// noise floor is tracked with the mean power of the segments that are not
+// active. A segment is correlated if any segment within margin segments before
+// or after it is active, so that the power history used by the median check
+// contains the correlation of the noise before and after a burst.
+class EnergyGate
+{
+private:
+    // time constant (in segments) of the noise floor averaging
+    static constexpr float averaging = 64.0f;
+
+    float _threshold = 0.0f;
+    size_t _block_size = 1;
+    size_t _margin = 0;
+    float _noise_floor = 0.0f;
+    bool _noise_floor_valid = false;
+    // activity of the segments from _first_segment onwards
+    std::deque<bool> _active;
+    uint64_t _first_segment = 0;
+
+public:
+    void reset(float threshold, size_t block_size, size_t margin)
+    {
+        _threshold = threshold;
+        _block_size = std::max(1UZ, block_size);
+        _margin = margin;
+        _noise_floor = 0.0f;
+        _noise_floor_valid = false;
+        _active.clear();
+        _first_segment = 0;
+    }
+
+    size_t margin() const noexcept { return _margin; }
+
+    float noise_floor() const noexcept { return _noise_floor; }
+
+    // number of segments measured so far
+    uint64_t num_measured() const noexcept { return _first_segment + _active.size(); }
+
+    // Measures the segment num_measured(), given its samples
+    template <typename Range>
+    void measure(Range&& samples)
+    {
+        float total_power = 0.0f;
+        float max_block_power = 0.0f;
+        size_t n = 0;
+        float block_power = 0.0f;
+        size_t block_items = 0;
+        for (const auto z : samples) {
+            block_power += z.real() * z.real() + z.imag() * z.imag();
+            if (++block_items == _block_size) {
+                total_power += block_power;
+                max_block_power = std::max(max_block_power, block_power);
+                block_power = 0.0f;
+                block_items = 0;
+            }
+            ++n;
+        }
+        max_block_power /= static_cast<float>(_block_size);
+        if (block_items > 0) {
+            // last partial block
+            total_power += block_power;
+            max_block_power =
+                std::max(max_block_power, block_power / static_cast<float>(block_items));
+        }
+        const float mean_power = n > 0 ? total_power / static_cast<float>(n) : 0.0f;
+        // the first segment is always active, since there is no noise floor
+        // estimate yet
+        const bool active =
+            !_noise_floor_valid || max_block_power > _threshold * _noise_floor;
+        if (!_noise_floor_valid || mean_power < _noise_floor) {
+            _noise_floor = mean_power;
+            _noise_floor_valid = true;
+        } else if (!active) {
+            _noise_floor += (mean_power - _noise_floor) / averaging;
+        }
+        _active.push_back(active);
+    }
+
+    // Returns whether the segment needs to be correlated. The segments up to
+    // segment + margin() must have been measured, and the segments must be
+    // queried in increasing order.
+    bool open(uint64_t segment)
+    {
+        while (_first_segment + _margin < segment && !_active.empty()) {
+            _active.pop_front();
+            ++_first_segment;
+        }
+        const size_t end = std::min(
+            _active.size(), static_cast<size_t>(segment + _margin + 1 - _first_segment));
+        return std::any_of(_active.cbegin(),
+                           _active.cbegin() + static_cast<std::ptrdiff_t>(end),
+                           std::identity{});
+    }
+};
+
+// Parameters that determine the cost of correlating a segment, which are used
+// to choose the FFT size when fft_size is zero.
+struct FftSizeKey {
+    size_t template_size;
+    // number of templates in the correlator
+    size_t num_rows;
+    size_t bin_step;
+    // number of strided correlations computed for each segment (the coarse
+    // grid in TWO_STAGE mode, or a single correlation of all the rows)
+    size_t num_strided;
+    FftConfig fft_config;
+
+    bool operator==(const FftSizeKey&) const = default;
+
+    std::string to_string() const
+    {
+        return fmt::format("{} {} {} {} {} {}",
+                           template_size,
+                           num_rows,
+                           bin_step,
+                           num_strided,
+                           magic_enum::enum_name(fft_config.backend),
+                           magic_enum::enum_name(fft_config.planner));
+    }
+};
+
+// FFT sizes tried by the auto-tuning. These are between 2 and 16 times the
+// template size and have the form 2^k * m, where m only contains small prime
+// factors, so that both powers of two and other sizes efficient for FFTW are
+// tried. The MIXED_RADIX backend has no radix-7 stage, so m = 7 is not used
+// with it.
+inline std::vector<size_t> fft_size_candidates(size_t template_size, FftBackend backend)
+{
+    constexpr size_t max_fft_size = 65536;
+    const size_t min_size = std::max(64UZ, 2 * template_size);
+    const size_t max_size =
+        std::max(min_size, std::min(16 * template_size, max_fft_size));
+    std::vector<size_t> candidates;
+    for (const size_t m : { 1UZ, 3UZ, 5UZ, 7UZ, 9UZ, 15UZ }) {
+        if (m == 7 && backend == FftBackend::MIXED_RADIX) {
+            continue;
+        }
+        for (size_t size = m; size <= max_size; size *= 2) {
+            if (size >= min_size) {
+                candidates.push_back(size);
+            }
+        }
+    }
+    if (candidates.empty()) {
+        candidates.push_back(std::bit_ceil(min_size));
+    }
+    std::ranges::sort(candidates);
+    return candidates;
+}
+
+// Measures the time per input sample spent correlating segments with an FFT
+// size. The templates are zero, since their values do not change the time.
+inline double segment_cost(const FftSizeKey& key, size_t fft_size)
+{
+    using c64 = std::complex<float>;
+    constexpr auto min_duration = std::chrono::milliseconds(2);
+    SyncwordCorrelator correlator;
+    correlator.init(key.template_size,
+                    fft_size,
+                    key.num_rows,
+                    key.bin_step,
+                    1,
+                    [](size_t, std::span<c64>) {},
+                    key.fft_config);
+    std::minstd_rand rng;
+    std::normal_distribution<float> dist;
+    std::vector<c64> samples(fft_size);
+    for (auto& z : samples) {
+        z = c64{ dist(rng), dist(rng) };
+    }
+    const auto correlate = [&]() {
+        correlator.compute_spectrum(0, samples);
+        for (const size_t r : std::views::iota(0UZ, key.num_strided)) {
+            correlator.correlate_strided(0, r);
+        }
+    };
+    // warm up the caches
+    correlate();
+    const double stride = static_cast<double>(fft_size - key.template_size + 1);
+    for (size_t iterations = 1;; iterations *= 2) {
+        const auto begin = std::chrono::steady_clock::now();
+        for (size_t j = 0; j < iterations; ++j) {
+            correlate();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - begin;
+        if (elapsed >= min_duration) {
+            return std::chrono::duration<double>(elapsed).count() /
+                   (static_cast<double>(iterations) * stride);
+        }
+    }
+}
+
+// Chooses the FFT size with the lowest cost per input sample. The result is
+// kept for the lifetime of the process and, if cache_file is not empty, it is
+// also stored in that file, so that later starts do not need to run the
+// benchmarks. The second member of the returned pair is true if the result was
+// cached. A size in the file that cannot be parsed or is not one of the
+// candidates is measured again and replaced.
+inline std::pair<size_t, bool> tune_fft_size(const FftSizeKey& key,
+                                             const std::string& cache_file)
+{
+    struct Cache {
+        std::mutex mutex;
+        std::vector<std::pair<FftSizeKey, size_t>> entries;
+    };
+    static Cache cache;
+    // the mutex is held during the benchmarks, so that several blocks
+    // starting at the same time do not disturb each other's measurements
+    std::lock_guard lock(cache.mutex);
+    const auto it =
+        std::ranges::find(cache.entries, key, &std::pair<FftSizeKey, size_t>::first);
+    if (it != cache.entries.end()) {
+        return { it->second, true };
+    }
+
+    // each line of the file contains a key followed by the FFT size
+    const std::string key_string = key.to_string();
+    const auto candidates =
+        fft_size_candidates(key.template_size, key.fft_config.backend);
+    std::vector<std::string> lines;
+    if (!cache_file.empty()) {
+        std::ifstream file(cache_file);
+        for (std::string line; std::getline(file, line);) {
+            const size_t pos = line.rfind(' ');
+            if (pos != std::string::npos && line.substr(0, pos) == key_string) {
+                const char* first = line.data() + pos + 1;
+                const char* last = line.data() + line.size();
+                size_t size = 0;
+                const auto [ptr, ec] = std::from_chars(first, last, size);
+                if (ec == std::errc{} && ptr == last &&
+                    std::ranges::find(candidates, size) != candidates.end()) {
+                    cache.entries.emplace_back(key, size);
+                    return { size, true };
+                }
+                // A corrupt or stale size is a cache miss. The line is dropped
+                // and written again after measuring.
+                continue;
+            }
+            lines.push_back(std::move(line));
+        }
+    }
+
+    size_t best_size = 0;
+    double best_cost = 0.0;
+    for (const size_t size : candidates) {
+        const double cost = segment_cost(key, size);
+        if (best_size == 0 || cost < best_cost) {
+            best_size = size;
+            best_cost = cost;
+        }
+    }
+    cache.entries.emplace_back(key, best_size);
+
+    if (!cache_file.empty()) {
+        // the file is written as the FFTW wisdom file, replacing it with a
+        // temporary file
+        lines.push_back(fmt::format("{} {}", key_string, best_size));
+        const std::string tmp_filename =
+            fmt::format("{}.{:08x}", cache_file, std::random_device{}());
+        {
+            std::ofstream file(tmp_filename);
+            for (const auto& line : lines) {
+                file << line << '\n';
+            }
+            if (!file) {
+                throw gr::exception(
+                    fmt::format("could not write FFT size cache to {}", tmp_filename));
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp_filename, cache_file, ec);
+        if (ec) {
+            std::filesystem::remove(tmp_filename, ec);
+            throw gr::exception(
+                fmt::format("could not write FFT size cache file {}", cache_file));
+        }
+    }
+    return { best_size, false };
+}
 } // namespace syncword_detection
 
-class SyncwordDetection : public gr::Block<SyncwordDetection>
+template <size_t fixed_fft_size = 0,
+          size_t fixed_num_freq_bins = 0,
+          size_t fixed_samples_per_symbol = 0>
+class SyncwordDetection : public gr::Block<SyncwordDetection<fixed_fft_size,
+                                                              fixed_num_freq_bins,
+                                                              fixed_samples_per_symbol>>
 {
 public:
     using Description = Doc<R""(
@@ -47,22 +527,233 @@ a time window of +/-`time_threshold` and such maximum is greater than
 attached to the item where the modulated syncword begins. The tag indicates
 carrier phase and frequency of the syncword.
 
+Several syncwords of the same length can be detected by concatenating them in
+`syncword` and setting `num_syncwords` to the number of syncwords. The FFT of
+each input segment is computed once and correlated against the templates of all
+the syncwords, so each additional syncword only adds the cost of the products
+and IFFTs of its templates. The `syncword_id` in the tag is the index of the
+detected syncword in the list. Only the syncword with the highest correlation is
+reported when several of them attain the maximum in the same time window.
+
+When `search_mode` is `TWO_STAGE`, the correlation is first computed only for
+the frequency bins that are a multiple of `coarse_bin_step` bins away from the
+zero frequency bin. All the frequency bins are only computed for a segment if
+the coarse search finds a correlation power greater than `coarse_threshold *
+power_threshold` times the median of the history in that segment or in any of
+its two adjacent segments. The items of the remaining segments only use the
+coarse frequency bins. The default `coarse_threshold` accounts for the loss of a
+syncword that is one frequency bin away from the coarse grid, which is the
+worst case for `coarse_bin_step = 2`. This reduces the computational cost when
+the input does not contain syncwords, at the expense of one segment of
+additional buffering.
+
+When `decimation` is greater than one, the correlation is computed on a version
+of the input that has been low-pass filtered and decimated by `decimation`, so
+`fft_size` refers to the decimated sample rate. When a syncword is detected, the
+correlation is computed again at the input sample rate around the detected
+peak, so the timing, phase and frequency in the tags have the same accuracy as
+without decimation. The decimated sample rate must be large enough to contain
+the bandwidth of the syncword (for instance, `samples_per_symbol / decimation`
+should be at least 2 for an RRC with a roll-off of 0.35, though 1 sample per
+symbol still works with some loss). The `time_threshold` is still given in
+input samples and it must be larger than the syncword length.
+
+When `num_threads` is greater than one and `search_mode` is `FULL`, the
+correlations of consecutive segments are computed in parallel by a pool of
+`num_threads` threads (including the thread that runs the block). The peak
+search is still done sequentially, so the output is the same as with a single
+thread. In `TWO_STAGE` mode the decision of which frequency bins to compute
+depends on the history of previous segments, so `num_threads` has no effect.
+
+The FFTs are computed with FFTW by default. Setting `fft_backend` to
+`MIXED_RADIX` uses an in-tree FFT that does not need any planning, which is
+mostly useful for sizes that are not a power of two. The effort spent by the
+FFTW planner is set by `fftw_planner` (`ESTIMATE`, `MEASURE` or `PATIENT`). If
+`fftw_wisdom_file` is not empty, the FFTW wisdom is loaded from that file before
+planning and saved to it afterwards, so that measured plans only need to be
+computed the first time. The FFTs of the syncword templates are cached for the
+lifetime of the process, so restarting the block with the same syncword, taps,
+FFT size and frequency bins does not compute them again. The time spent in the
+initialization done by `start()` is stored in `_startup_time_secs`.
+
+If `fft_size` is zero, `start()` chooses the FFT size by measuring the time
+needed to correlate a segment with several candidate sizes between 2 and 16
+times the syncword length, including sizes that are not a power of two, and
+picking the one with the lowest cost per input sample. The chosen size is
+stored in `_fft_size`. The result is kept for the lifetime of the
+process, and when `fftw_wisdom_file` is not empty it is also stored in a file
+with the same name followed by `.fft_size`, so that later starts with the same
+configuration skip the measurements. If `log` is true, the chosen size is
+printed, indicating whether it was taken from the cache.
+
+If `energy_gate_threshold` is greater than zero, the block measures the power of
+each segment in blocks of half the syncword length before correlating it. The
+noise floor is tracked with the mean power of the segments where no block is
+above `energy_gate_threshold` times the noise floor, and a segment is only
+correlated if some segment within the length of the power history before or
+after it is above the threshold. This reduces the computational cost with bursty
+input, since the correlation is skipped while only noise is received, at the
+expense of buffering the length of the power history. Syncwords whose power is
+below `energy_gate_threshold` times the noise floor can be missed, so a
+threshold of a few dB above the noise is a good choice. The number of segments
+skipped since `start()` is stored in `_skipped_segments`.
+
+When `detection_mode` is `CAUSAL`, a detection does not wait for the window of
++/-`time_threshold` items. An item is a candidate when its correlation power is
+above `causal_threshold` times the expected correlation power of the noise,
+which is obtained from the noise power of the segment (so `causal_threshold` is
+the minimum syncword energy to noise power spectral density ratio, in linear
+units). The candidate is declared once `causal_lookahead` items have followed it
+without a larger candidate, if it is also above `power_threshold` times the
+median of the last `2 * time_threshold + 1` items, which are mostly before
+it. This median check rejects the correlation peaks of data symbols when the SNR
+is high. During the `time_threshold` items after a detection, only a larger peak
+can give another detection. Since a detection cannot be retracted when a larger
+peak follows it, this mode gives more false alarms than `MEDIAN` when the SNR is
+high. The output delay is `causal_lookahead + 1` instead of `2 * time_threshold
++ 1`, which reduces the latency of the receiver. Syncwords below
+`causal_threshold` are not detected. This mode requires `decimation` to be
+one. The number of detections since `start()` is stored in `_num_detections` in
+both modes.
+
+In stream mode, packets are sent back to back, so once the header of a packet
+has been decoded the position of the next syncword is known. This prediction
+can be sent as a message to the `next_syncword` port, as done by the Syncword
+Detection Filter, with the output sample index where the syncword is expected in
+the `"syncword_index"` field and optionally its frequency bin in the
+`"syncword_freq_bin"` field. If `prediction_time_window` is non-zero, the block
+skips the correlation of the segments before the window of
++/-`prediction_time_window` samples around the prediction, and in the segments
+that contain the window it only computes the frequency bins within
++/-`prediction_freq_window` of the predicted bin. The largest peak in the window
+is detected if it passes the median check, and after the window the block goes
+back to the full search. A wrong prediction causes the loss of the syncwords
+before the end of its window. Predictions that arrive after the block has
+processed the beginning of their window are ignored. The number of missed and
+late predictions since `start()` is stored in `_missed_predictions` and
+`_late_predictions`, and the skipped segments are counted in
+`_skipped_segments`. This requires `MEDIAN` detection mode and `decimation` one,
+and `prediction_time_window` must be less than half of `time_threshold`.
+
+If `cfo_tracking` is true, the frequency of the syncword of each successfully
+decoded packet, given in the `"syncword_freq"` field of the messages received in
+the `next_syncword` port, is filtered with a single-pole filter with coefficient
+`tracking_alpha` to estimate the carrier frequency offset. The correlations are
+then only computed for the frequency bins within +/-`tracking_freq_window` of
+the estimate (the syncword templates are already shifted to each bin), plus the
+adjacent bins used to interpolate the frequency when the segment contains a
+candidate peak. Since the median of the correlation power is lower when fewer
+bins are searched, `power_threshold` is scaled by the ratio between the median
+with all the bins and the median with the tracking window, which is measured
+by correlating all the bins of the first segment searched with a new window. If
+no packet is decoded in `tracking_timeout` input samples, the block goes back to
+searching all the frequency bins. The number of timeouts since `start()` is
+stored in `_tracking_timeouts`. While tracking, the segments are correlated one
+by one, so `num_threads` has no effect.
+
+If `psd_frame_length` is non-zero, the block sends power spectral density frames
+in the optional `psd` message port. Each frame averages the FFTs of the
+segments correlated in `psd_frame_length` input samples, which the correlator
+has already computed, so the frames are obtained without any additional FFTs.
+The segments overlap by the length of the syncword and are not windowed. The
+message contains the PSD in `"psd"`, as a vector of `fft_size` floats with the
+zero frequency in the centre and normalized so that white noise gives its power
+per sample in each bin, the average noise power of the segments in
+`"noise_power"`, which is estimated in the same way as for the
+`syncword_noise_power` tags, the number of segments averaged in
+`"num_segments"`, and the input sample at the end of the frame in
+`"sample_index"`. When `decimation` is greater than one, the PSD and the noise
+power are those of the decimated samples. Frames in which all the segments have
+been skipped are not sent, and frames that do not fit in the `psd` port are
+dropped, so that this output never slows down the detection. The number of
+dropped frames is stored in `_psd_dropped_frames`.
+
+Some settings can be changed while the block is running, which is used by the
+Load Governor of the Packet Receiver to reduce the CPU usage when the receiver
+cannot keep up with its input. `min_freq_bin` and `max_freq_bin` can be set to
+any range within the frequency bins given when the block was started. Only the
+bins in this range are searched, in the same way as when tracking the carrier
+frequency offset, and the tracking window is limited to this range. Setting the
+bins back to the start range restores the full search. `power_threshold` and
+`coarse_threshold` take effect immediately. `search_mode` can only be changed
+between `FULL` and `TWO_STAGE` if `runtime_search_mode` is true when the block
+is started, because the block then keeps the lookahead of the `TWO_STAGE` search
+in both modes, which adds one segment of buffering and latency in `FULL`
+mode. Changing any other setting requires restarting the block.
+
+The template parameters `fixed_fft_size`, `fixed_num_freq_bins` and
+`fixed_samples_per_symbol` give a variant of the block specialised at compile
+time for a particular configuration. When they are non-zero, `fft_size`,
+`max_freq_bin - min_freq_bin + 1` and `samples_per_symbol` must be equal to
+them, and the loops over the FFT and the frequency bins have compile-time trip
+counts, so the compiler can unroll and vectorize them. The default template
+parameters give the runtime version, which accepts any configuration.
+
 )"">;
 
 private:
     using c64 = std::complex<float>;
-    using FFT = gr::algorithm::FFTw<c64, c64>;
 
-    gr::property_map output_tag(const syncword_detection::HistoryItem& item,
-                                const syncword_detection::HistoryItem& previous_item,
-                                const syncword_detection::HistoryItem& next_item) const
+    // FFT size, number of frequency bins and samples per symbol, which are
+    // compile-time constants in the specialised variants of the block
+    size_t fft_len() const noexcept
+    {
+        if constexpr (fixed_fft_size != 0) {
+            return fixed_fft_size;
+        } else {
+            return _fft_size;
+        }
+    }
+
+    size_t num_bins() const noexcept
+    {
+        if constexpr (fixed_num_freq_bins != 0) {
+            return fixed_num_freq_bins;
+        } else {
+            return _num_freq_bins;
+        }
+    }
+
+    // The correlator has a template for each frequency bin and syncword. The
+    // templates of all the syncwords for the same frequency bin are
+    // contiguous, so that the coarse grid of frequency bins is a strided
+    // subset of the templates.
+    size_t template_row(size_t nfreq, size_t syncword_id) const noexcept
+    {
+        return nfreq * _num_syncwords + syncword_id;
+    }
+
+    size_t sps() const noexcept
+    {
+        if constexpr (fixed_samples_per_symbol != 0) {
+            return fixed_samples_per_symbol;
+        } else {
+            return samples_per_symbol;
+        }
+    }
+
+    // Number of items whose correlation is obtained from each segment
+    size_t segment_stride() const noexcept { return fft_len() - _template_size + 1; }
+
+    // Index in the correlation of the item k of a segment. This takes into
+    // account the time-reversal of the correlation.
+    size_t correlation_index(size_t k) const noexcept
+    {
+        return k == 0 ? 0 : fft_len() - k;
+    }
+
+    gr::property_map output_tag(const syncword_detection::CorrelationItem& item,
+                                float previous_power,
+                                float next_power) const
     {
         const double bin_spacing =
             std::numbers::pi / static_cast<double>(_syncword_samples_size);
         double syncword_freq = static_cast<double>(item.freq_bin) * bin_spacing;
         float syncword_phase = std::arg(item.correlation);
+        const float self_corr =
+            _syncword_self_corr[static_cast<size_t>(item.syncword_id)];
         float correlation_power;
-        if (item.freq_bin > min_freq_bin && item.freq_bin < max_freq_bin) {
+        if (item.has_left && item.has_right) {
             // perform quadratic interpolation to get a finer frequency estimate
             const double a = static_cast<double>(item.correlation_power_left);
             const double b = static_cast<double>(item.correlation_power);
@@ -89,18 +780,17 @@ private:
         // 1/N factor
         const float syncword_amplitude =
             std::sqrt(correlation_power) /
-            (static_cast<float>(fft_size) * _syncword_self_corr);
-        const float syncword_power =
-            syncword_amplitude * syncword_amplitude * _syncword_self_corr;
+            (static_cast<float>(fft_len()) * self_corr);
+        const float syncword_power = syncword_amplitude * syncword_amplitude * self_corr;
         const float esn0_db =
-            10.0f * std::log10((syncword_power * static_cast<float>(samples_per_symbol)) /
+            10.0f * std::log10((syncword_power * static_cast<float>(sps())) /
                                (item.fft_noise_power *
                                 static_cast<float>(_syncword_samples_size)));
-        // perform quadratic interpolation of power between previous_item, item
-        // and next_item to get a finer time estimate
-        const double a = static_cast<double>(previous_item.correlation_power);
+        // perform quadratic interpolation of power between the previous item,
+        // item and the next item to get a finer time estimate
+        const double a = static_cast<double>(previous_power);
         const double b = static_cast<double>(item.correlation_power);
-        const double c = static_cast<double>(next_item.correlation_power);
+        const double c = static_cast<double>(next_power);
         const float time_est = static_cast<float>(
             std::clamp((c - a) / (2.0 * (2.0 * b - (a + c))), -0.5, 0.5));
         return {
@@ -108,115 +798,1374 @@ private:
             { "syncword_phase", syncword_phase },
             { "syncword_freq", syncword_freq },
             { "syncword_freq_bin", item.freq_bin },
+            { "syncword_id", item.syncword_id },
             { "syncword_noise_power", item.fft_noise_power },
             { "syncword_esn0_db", esn0_db },
             { "syncword_time_est", time_est },
         };
     }
 
+    // Computes the spectrum and the coarse correlation of the segment that
+    // begins at the start of samples, storing the noise power of the segment
+    // and whether the coarse correlation contains a candidate peak.
+    template <typename Range>
+    void coarse_search(size_t slot, Range&& samples)
+    {
+        _correlator.compute_spectrum(slot, std::forward<Range>(samples));
+        _slot_noise_power[slot] = noise_power(_correlator.spectrum(slot));
+        for (const size_t id : std::views::iota(0UZ, _num_syncwords)) {
+            _correlator.correlate_strided(slot, template_row(_coarse_first_bin, id));
+        }
+        float max_power = 0.0f;
+        const size_t num_freq_bins = num_bins();
+        for (size_t nfreq = _coarse_first_bin; nfreq < num_freq_bins;
+             nfreq += coarse_bin_step) {
+            for (const size_t id : std::views::iota(0UZ, _num_syncwords)) {
+                const c64* correlation =
+                    _correlator.correlation(template_row(nfreq, id), slot);
+                for (const size_t k : std::views::iota(0UZ, fft_len())) {
+                    const c64 z = correlation[k];
+                    const float power = z.real() * z.real() + z.imag() * z.imag();
+                    max_power = std::max(max_power, power);
+                }
+            }
+        }
+        // same median check as the one used for detection, but with a lower
+        // threshold to account for the loss of the coarse frequency grid
+        const size_t below_threshold = _power_history.count_below(
+            max_power / (coarse_threshold * power_threshold));
+        _slot_pass[slot] = max_power > 0.0f && 2 * below_threshold >= _history_size;
+    }
+
+    float noise_power(const c64* samples_fft) const
+    {
+        return syncword_detection::spectrum_noise_power(samples_fft, fft_len());
+    }
+
+    struct Segment {
+        // correlator slot that contains the correlation of the segment
+        size_t slot;
+        // frequency bins for which the correlation has been computed
+        size_t first_bin;
+        size_t bin_step;
+        float fft_noise_power;
+        // false if the energy gate has skipped the segment
+        bool correlated = true;
+        // frequency bins after the last one searched, which is less than the
+        // number of bins when the search is limited to a predicted window
+        size_t end_bin = std::numeric_limits<size_t>::max();
+        // whether the bins adjacent to the searched bins, which are used to
+        // interpolate the frequency, have been computed
+        bool adjacent_bins = true;
+    };
+
+    // Computes the correlation of the segment that begins at samples[j]. In
+    // TWO_STAGE mode, the segment that begins at samples[j + _stride] is also
+    // used to decide which frequency bins to compute.
+    template <typename Samples>
+    Segment correlate_segment(const Samples& samples, size_t j)
+    {
+        Segment segment{ 0, 0, 1, 0.0f };
+        if (_search_mode == syncword_detection::SearchMode::TWO_STAGE) {
+            const size_t slot = _slot;
+            if (!_lookahead_valid) {
+                coarse_search(slot, samples | std::views::drop(j));
+            }
+            const size_t next_slot = 1 - slot;
+            coarse_search(next_slot, samples | std::views::drop(j + segment_stride()));
+            if (_prev_pass || _slot_pass[slot] || _slot_pass[next_slot]) {
+                // compute the remaining frequency bins
+                for (const size_t r :
+                     std::views::iota(0UZ, coarse_bin_step * _num_syncwords)) {
+                    if (r / _num_syncwords != _coarse_first_bin) {
+                        _correlator.correlate_strided(slot, r);
+                    }
+                }
+            } else {
+                segment.first_bin = _coarse_first_bin;
+                segment.bin_step = coarse_bin_step;
+            }
+            segment.slot = slot;
+            segment.fft_noise_power = _slot_noise_power[slot];
+            _prev_pass = _slot_pass[slot];
+            _slot = next_slot;
+            _lookahead_valid = true;
+        } else {
+            // Compute IFFT(FFT(samples) * conj(FFT(syncword)) for all the
+            // frequency bins
+            _correlator.compute(samples | std::views::drop(j));
+            segment.fft_noise_power = noise_power(_correlator.spectrum());
+        }
+        return segment;
+    }
+
+    // Computes the correlation of the segment that begins at samples[j] for the
+    // frequency bins from first_bin to end_bin (not included). The adjacent
+    // bins are only computed if the segment contains a candidate peak, using
+    // the same check as the coarse search of the TWO_STAGE mode, so most
+    // segments cost about as much as a search with as many bins as the window.
+    template <typename Samples>
+    Segment correlate_window(const Samples& samples,
+                             size_t j,
+                             size_t first_bin,
+                             size_t end_bin)
+    {
+        _correlator.compute_spectrum(0, samples | std::views::drop(j));
+        const size_t first_row = template_row(first_bin, 0);
+        const size_t end_row = template_row(end_bin, 0);
+        if (_scale_bins != end_bin - first_bin) {
+            calibrate_window(first_row, end_row);
+            _scale_bins = end_bin - first_bin;
+        } else {
+            _correlator.correlate_range(0, first_row, end_row);
+        }
+        float max_power = 0.0f;
+        for (const size_t row : std::views::iota(first_row, end_row)) {
+            const c64* correlation = _correlator.correlation(row, 0);
+            for (const size_t k : std::views::iota(0UZ, fft_len())) {
+                const c64 z = correlation[k];
+                const float power = z.real() * z.real() + z.imag() * z.imag();
+                max_power = std::max(max_power, power);
+            }
+        }
+        const size_t below_threshold = _power_history.count_below(
+            max_power / (coarse_threshold * detection_threshold()));
+        const bool candidate = max_power > 0.0f && 2 * below_threshold >= _history_size;
+        if (candidate) {
+            if (first_bin > 0) {
+                _correlator.correlate_range(0, first_row - _num_syncwords, first_row);
+            }
+            _correlator.correlate_range(0, end_row, end_row + _num_syncwords);
+        }
+        // the two-stage search starts again after the window
+        _lookahead_valid = false;
+        _prev_pass = false;
+        return Segment{ 0,
+                        first_bin,
+                        1,
+                        noise_power(_correlator.spectrum(0)),
+                        true,
+                        end_bin,
+                        candidate };
+    }
+
+    // Computes the correlation of the segment in slot 0 for all the frequency
+    // bins, and scales the threshold by the ratio between the median of the
+    // correlation power of all the bins and the median of the correlation
+    // power of the window from first_row to end_row (not included). Both
+    // medians are measured in the same segment, so that the ratio does not
+    // depend on whether the segment contains a signal. This is done each time
+    // that the number of bins of the window changes.
+    void calibrate_window(size_t first_row, size_t end_row)
+    {
+        _correlator.correlate(0);
+        const size_t _stride = segment_stride();
+        std::vector<float> all_powers(_stride, 0.0f);
+        std::vector<float> window_powers(_stride, 0.0f);
+        for (const size_t row : std::views::iota(0UZ, num_bins() * _num_syncwords)) {
+            const c64* correlation = _correlator.correlation(row, 0);
+            const bool in_window = row >= first_row && row < end_row;
+            for (const size_t k : std::views::iota(0UZ, _stride)) {
+                const c64 z = correlation[correlation_index(k)];
+                const float power = z.real() * z.real() + z.imag() * z.imag();
+                all_powers[k] = std::max(all_powers[k], power);
+                if (in_window) {
+                    window_powers[k] = std::max(window_powers[k], power);
+                }
+            }
+        }
+        const auto median = [](std::vector<float>& v) {
+            const auto middle = v.begin() + static_cast<std::ptrdiff_t>(v.size() / 2);
+            std::ranges::nth_element(v, middle);
+            return *middle;
+        };
+        const float window_median = median(window_powers);
+        _threshold_scale =
+            window_median > 0.0f ? std::max(1.0f, median(all_powers) / window_median)
+                                 : 1.0f;
+    }
+
+    // Updates the estimate of the carrier frequency offset with the frequency
+    // of the syncword of a successfully decoded packet, and centres the
+    // tracking window on it.
+    void track(const gr::property_map& packet)
+    {
+        const auto it = packet.find("syncword_freq");
+        if (!cfo_tracking || it == packet.end()) {
+            return;
+        }
+        const double freq = pmtv::cast<double>(it->second);
+        if (_tracking) {
+            _cfo_estimate += static_cast<double>(tracking_alpha) * (freq - _cfo_estimate);
+        } else {
+            _cfo_estimate = freq;
+            _tracking = true;
+            // the threshold is calibrated in the first segment of the tracking
+        }
+        _last_packet_idx = _items_consumed / decimation;
+        const double bin_spacing =
+            std::numbers::pi / static_cast<double>(_syncword_samples_size);
+        const int bin = static_cast<int>(std::lround(_cfo_estimate / bin_spacing)) -
+                        _first_freq_bin;
+        const int window = tracking_freq_window;
+        _tracking_first_bin = static_cast<size_t>(
+            std::clamp(bin - window, 0, static_cast<int>(num_bins()) - 1));
+        _tracking_end_bin = static_cast<size_t>(
+            std::clamp(bin + window + 1, 1, static_cast<int>(num_bins())));
+    }
+
+    // Measures the energy of all the segments whose samples are available,
+    // given the samples that begin at the correlator item consumed
+    template <typename Samples>
+    void measure_energy(const Samples& samples, uint64_t consumed)
+    {
+        const size_t _stride = segment_stride();
+        const uint64_t available = consumed + std::ranges::size(samples);
+        while ((_energy_gate.num_measured() + 1) * _stride <= available) {
+            const size_t begin =
+                static_cast<size_t>(_energy_gate.num_measured() * _stride - consumed);
+            _energy_gate.measure(samples | std::views::drop(begin) |
+                                 std::views::take(_stride));
+        }
+    }
+
+    // Adds the spectrum of a segment, which ends at the input item segment_end,
+    // to the power spectral density frame, and finishes the frame if the
+    // segment reaches its end. The spectrum of the segment has already been
+    // computed by the correlator, so this does not need any FFTs.
+    void update_psd(const Segment& segment, uint64_t segment_end)
+    {
+        if (psd_frame_length == 0) {
+            return;
+        }
+        const size_t nfft = fft_len();
+        if (segment.correlated) {
+            const c64* spectrum = _correlator.spectrum(segment.slot);
+            for (const size_t k : std::views::iota(0UZ, nfft)) {
+                const c64 z = spectrum[k];
+                _psd_sum[k] += z.real() * z.real() + z.imag() * z.imag();
+            }
+            _psd_noise_sum += segment.fft_noise_power;
+            ++_psd_num_segments;
+        }
+        if (segment_end < _psd_frame_end) {
+            return;
+        }
+        // a frame in which the energy gate has skipped all the segments is
+        // not sent
+        if (_psd_num_segments > 0) {
+            // same normalization as the noise power (unitary FFT), with the
+            // zero frequency in the centre
+            const float scale =
+                1.0f / (static_cast<float>(_psd_num_segments) * static_cast<float>(nfft));
+            std::vector<float> frame(nfft);
+            for (const size_t k : std::views::iota(0UZ, nfft)) {
+                frame[k] = _psd_sum[(k + nfft / 2) % nfft] * scale;
+            }
+            gr::Message msg;
+            msg.data = gr::property_map{
+                { "psd", std::move(frame) },
+                { "noise_power",
+                  _psd_noise_sum / static_cast<float>(_psd_num_segments) },
+                { "num_segments", _psd_num_segments },
+                { "sample_index", segment_end }
+            };
+            _psd_frames.push_back(std::move(msg));
+        }
+        std::ranges::fill(_psd_sum, 0.0f);
+        _psd_noise_sum = 0.0f;
+        _psd_num_segments = 0;
+        while (_psd_frame_end <= segment_end) {
+            _psd_frame_end += psd_frame_length;
+        }
+    }
+
+    // Sends the power spectral density frames finished in this call to
+    // processBulk(). The frames that do not fit in the psd port are dropped,
+    // so that a slow consumer of the frames never stalls the detection.
+    void publish_psd(gr::PublishableSpan auto& psdSpan)
+    {
+        const size_t n = std::min(_psd_frames.size(), psdSpan.size());
+        std::ranges::move(_psd_frames | std::views::take(n), psdSpan.begin());
+        psdSpan.publish(n);
+        _psd_dropped_frames += _psd_frames.size() - n;
+        _psd_frames.clear();
+    }
+
+    // Computes the correlations of a batch of consecutive segments beginning at
+    // samples[j], which is the segment with index segment_index, storing them in
+    // _segments, and returns the number of segments in the batch. The batch has
+    // more than one segment only if the correlations are computed in
+    // parallel. A segment closed by the energy gate is returned on its own,
+    // without computing its correlation.
+    template <typename Samples>
+    size_t correlate_segments(const Samples& samples, size_t j, uint64_t segment_index)
+    {
+        const bool gate = energy_gate_threshold > 0.0f;
+        // segments before a predicted window are skipped, and the energy gate
+        // is not used while there is a prediction
+        const bool skip =
+            _prediction_active
+                ? (segment_index + 1) * segment_stride() <= _window_begin
+                : gate && !_energy_gate.open(segment_index);
+        if (skip) {
+            _segments[0] = Segment{ 0, 0, 1, 0.0f, false };
+            // the two-stage search starts again in the next correlated segment
+            _lookahead_valid = false;
+            _prev_pass = false;
+            ++_skipped_segments;
+            return 1;
+        }
+        if (_prediction_active && segment_index * segment_stride() <= _window_end) {
+            // Only the frequency bins of the window, plus the adjacent bins
+            // used to interpolate the frequency, are computed. The two-stage
+            // search is not used, so it starts again after the prediction.
+            const size_t first = _window_first_bin > 0 ? _window_first_bin - 1 : 0;
+            _correlator.compute_spectrum(0, samples | std::views::drop(j));
+            _correlator.correlate_range(0,
+                                        template_row(first, 0),
+                                        template_row(_window_end_bin + 1, 0));
+            _segments[0] = Segment{ 0,
+                                    _window_first_bin,
+                                    1,
+                                    noise_power(_correlator.spectrum(0)),
+                                    true,
+                                    _window_end_bin };
+            _lookahead_valid = false;
+            _prev_pass = false;
+            return 1;
+        }
+        if (_tracking &&
+            segment_index * segment_stride() > _last_packet_idx + _tracking_timeout) {
+            // go back to the full search
+            _tracking = false;
+            ++_tracking_timeouts;
+        }
+        if (_tracking || _search_first_bin > 0 || _search_end_bin < num_bins()) {
+            size_t first = _search_first_bin;
+            size_t end = _search_end_bin;
+            if (_tracking) {
+                first = std::clamp(_tracking_first_bin, first, end - 1);
+                end = std::clamp(_tracking_end_bin, first + 1, end);
+            }
+            _segments[0] = correlate_window(samples, j, first, end);
+            return 1;
+        }
+        _threshold_scale = 1.0f;
+        _scale_bins = num_bins();
+        if (_search_mode == syncword_detection::SearchMode::TWO_STAGE ||
+            _workers.num_threads() == 1) {
+            _segments[0] = correlate_segment(samples, j);
+            return 1;
+        }
+        // this is called _stride rather than stride because stride is already
+        // a member of Block
+        const size_t _stride = segment_stride();
+        // Every segment of the batch keeps the lookahead after it, as the
+        // first one does. The energy gate has only measured the margin of the
+        // segments that have it, so a segment without its lookahead could be
+        // closed by a burst that has not been measured yet.
+        size_t num_segments = std::min(
+            _workers.num_threads(),
+            (std::ranges::size(samples) - fft_len() - _lookahead - j) / _stride + 1);
+        if (gate) {
+            // the batch only contains consecutive segments open by the gate
+            size_t num_open = 1;
+            while (num_open < num_segments &&
+                   _energy_gate.open(segment_index + num_open)) {
+                ++num_open;
+            }
+            num_segments = num_open;
+        }
+        _workers.run(num_segments, [&](size_t slot) {
+            _correlator.compute_spectrum(slot,
+                                         samples | std::views::drop(j + slot * _stride));
+            _correlator.correlate(slot);
+            _segments[slot] =
+                Segment{ slot, 0, 1, noise_power(_correlator.spectrum(slot)) };
+        });
+        return num_segments;
+    }
+
+    // Finds the best template (frequency bin and syncword) and its correlation
+    // power for each of the first n items of a segment, storing them in
+    // _item_row and _item_power. The loop over the items is the inner loop, so
+    // that it can be vectorized, and the loop over the frequency bins can be
+    // unrolled when the number of bins is a compile-time constant.
+    void best_freq_bins(const Segment& segment, size_t n)
+    {
+        float* powers = _item_power.data();
+        uint32_t* rows = _item_row.data();
+        std::fill_n(powers, n, -1.0f);
+        std::fill_n(rows, n, 0U);
+        const size_t nfft = fft_len();
+        const auto update_row = [&](size_t row) {
+            const c64* correlation = _correlator.correlation(row, segment.slot);
+            const uint32_t row32 = static_cast<uint32_t>(row);
+            // the item 0 is handled separately because its correlation index
+            // does not follow the same pattern as for the rest of the items
+            const float power0 = correlation[0].real() * correlation[0].real() +
+                                 correlation[0].imag() * correlation[0].imag();
+            if (power0 > powers[0]) {
+                powers[0] = power0;
+                rows[0] = row32;
+            }
+            for (const size_t k : std::views::iota(1UZ, n)) {
+                const c64 z = correlation[nfft - k];
+                const float power = z.real() * z.real() + z.imag() * z.imag();
+                const bool better = power > powers[k];
+                powers[k] = better ? power : powers[k];
+                rows[k] = better ? row32 : rows[k];
+            }
+        };
+        const auto update_bin = [&](size_t nfreq) {
+            for (const size_t id : std::views::iota(0UZ, _num_syncwords)) {
+                update_row(template_row(nfreq, id));
+            }
+        };
+        if (segment.bin_step == 1 && segment.first_bin == 0 &&
+            segment.end_bin >= num_bins()) {
+            for (const size_t nfreq : std::views::iota(0UZ, num_bins())) {
+                update_bin(nfreq);
+            }
+        } else {
+            for (size_t nfreq = segment.first_bin;
+                 nfreq < std::min(num_bins(), segment.end_bin);
+                 nfreq += segment.bin_step) {
+                update_bin(nfreq);
+            }
+        }
+    }
+
+    // Fills the correlation item for the correlation index z_idx of a segment,
+    // given its best template. This is only done for items that become the
+    // best candidate for a detection.
+    syncword_detection::CorrelationItem
+    correlation_item(const Segment& segment, size_t z_idx, size_t best_row) const
+    {
+        const size_t num_freq_bins = num_bins();
+        const size_t best_freq = best_row / _num_syncwords;
+        const size_t id = best_row % _num_syncwords;
+        const auto power = [&](size_t nfreq) {
+            const c64 z = _correlator.correlation(template_row(nfreq, id),
+                                                  segment.slot)[z_idx];
+            return z.real() * z.real() + z.imag() * z.imag();
+        };
+        syncword_detection::CorrelationItem item;
+        item.correlation = _correlator.correlation(best_row, segment.slot)[z_idx];
+        item.correlation_power = power(best_freq);
+        // the adjacent bins have not been computed if bin_step != 1, and the
+        // bins outside of a reduced search window are only computed if
+        // adjacent_bins is true
+        if (segment.bin_step == 1) {
+            if (best_freq > 0 &&
+                (segment.adjacent_bins || best_freq > segment.first_bin)) {
+                item.correlation_power_left = power(best_freq - 1);
+                item.has_left = true;
+            }
+            if (best_freq < num_freq_bins - 1 &&
+                (segment.adjacent_bins || best_freq + 1 < segment.end_bin)) {
+                item.correlation_power_right = power(best_freq + 1);
+                item.has_right = true;
+            }
+        }
+        item.freq_bin = _first_freq_bin + static_cast<int>(best_freq);
+        item.syncword_id = static_cast<int>(id);
+        item.fft_noise_power = segment.fft_noise_power;
+        return item;
+    }
+
+    // Updates the best candidate for a detection with the item curr_idx, which
+    // is the item k of the segment. The best frequency bins of the segment
+    // must have been computed with best_freq_bins().
+    void update_best(const Segment& segment, size_t k, uint64_t curr_idx)
+    {
+        const float power = _item_power[k];
+        if (power > _best) {
+            _best = power;
+            _best_idx = curr_idx;
+            _best_item = correlation_item(segment, correlation_index(k), _item_row[k]);
+        }
+        _power_history.push_back(power);
+    }
+
+    // Updates the MEDIAN detection with the item curr_idx, which is the item k
+    // of the segment. The candidate is declared when time_threshold items have
+    // followed it without a larger one, if it is above the history median.
+    void median_update(const Segment& segment, size_t k, uint64_t curr_idx)
+    {
+        if (curr_idx - _best_idx > _time_threshold) {
+            if (best_above_median()) {
+#ifdef TRACE
+                fmt::println("{} best found: _best = {}, _best_idx = {}, curr_idx = {}",
+                             this->name,
+                             _best,
+                             _best_idx,
+                             curr_idx);
+#endif
+                queue_detection(curr_idx);
+            }
+            _best = 0.0f;
+            _best_idx = curr_idx;
+        }
+        update_best(segment, k, curr_idx);
+    }
+
+    // Drops the current candidate for a detection when a segment is skipped by
+    // the energy gate. The gate only skips a segment when there is no energy
+    // above the noise floor in it or in the segments around it, so the
+    // candidate can only be a noise peak. The next candidate starts after
+    // last_idx, which is the last item of the skipped segment.
+    void skip_segment(uint64_t last_idx)
+    {
+        _best = 0.0f;
+        _best_idx = last_idx;
+    }
+
+    // Correlation power of the item idx, taken from the power history, when
+    // the last item in the history is curr_idx - 1
+    float history_power(uint64_t idx, uint64_t curr_idx) const
+    {
+        const auto window = _power_history.window();
+        const uint64_t age = curr_idx - idx;
+        return age >= 1 && age <= window.size() ? window[window.size() - age] : 0.0f;
+    }
+
+    // Queues the tag for the current candidate, when the last item in the
+    // power history is curr_idx - 1. The tag is published when the item
+    // _best_idx comes out of the output delay.
+    void queue_detection(uint64_t curr_idx)
+    {
+        _pending_tags.emplace_back(_best_idx + _output_delay,
+                                   output_tag(_best_item,
+                                              history_power(_best_idx - 1, curr_idx),
+                                              history_power(_best_idx + 1, curr_idx)));
+        ++_num_detections;
+    }
+
+    // Updates the CAUSAL detection with the item curr_idx, which is the item k
+    // of the segment. The candidate is the largest item above the absolute
+    // threshold, and it is declared when causal_lookahead items have followed
+    // it without a larger candidate, as long as it also passes the median
+    // check against the power history, which then contains mostly past items.
+    void causal_update(const Segment& segment, size_t k, uint64_t curr_idx)
+    {
+        if (_best > 0.0f && curr_idx - _best_idx > causal_lookahead) {
+            if (best_above_median()) {
+                queue_detection(curr_idx);
+                // the rest of the correlation peak and its sidelobes cannot
+                // give another detection, but a larger peak can, since the
+                // detection might have been a false alarm shortly before a
+                // syncword
+                _holdoff_end = _best_idx + _time_threshold + 1;
+                _holdoff_power = _best;
+            }
+            _best = 0.0f;
+        }
+        const float power = _item_power[k];
+        if (power > _best && (curr_idx >= _holdoff_end || power > _holdoff_power)) {
+            // the IFFT lacks the 1/N factor, so the correlation power of the
+            // noise is scaled by fft_len() squared
+            const float nfft = static_cast<float>(fft_len());
+            const float noise_correlation_power =
+                nfft * nfft * _syncword_self_corr[_item_row[k] % _num_syncwords] *
+                segment.fft_noise_power;
+            if (power > causal_threshold * noise_correlation_power) {
+                _best = power;
+                _best_idx = curr_idx;
+                _best_item =
+                    correlation_item(segment, correlation_index(k), _item_row[k]);
+            }
+        }
+        _power_history.push_back(power);
+    }
+
+    // Updates the search in a predicted window with the item curr_idx, which is
+    // the item k of the segment. Only the items inside the window can be a
+    // candidate. The decision is taken time_threshold items after the end of
+    // the window, as in the MEDIAN detection, and then the full search
+    // continues.
+    void predicted_update(const Segment& segment, size_t k, uint64_t curr_idx)
+    {
+        if (curr_idx > _window_end + _time_threshold) {
+            if (_best > 0.0f && best_above_median()) {
+                queue_detection(curr_idx);
+            } else {
+                ++_missed_predictions;
+            }
+            _prediction_active = false;
+            _best = 0.0f;
+            _best_idx = curr_idx;
+            update_best(segment, k, curr_idx);
+            return;
+        }
+        if (curr_idx >= _window_begin && curr_idx <= _window_end) {
+            update_best(segment, k, curr_idx);
+        } else {
+            _power_history.push_back(_item_power[k]);
+        }
+    }
+
+    // Starts a search in a window around the syncword predicted by a
+    // message. The syncword_index in the message refers to the output, which
+    // is delayed by _output_delay with respect to the correlator items.
+    void predict(const gr::property_map& prediction)
+    {
+        if (prediction_time_window == 0 || _prediction_active) {
+            return;
+        }
+        const uint64_t index = pmtv::cast<uint64_t>(prediction.at("syncword_index"));
+        if (index < _output_delay + prediction_time_window ||
+            index - _output_delay - prediction_time_window < _items_consumed) {
+            // the window has already been searched
+            ++_late_predictions;
+            return;
+        }
+        const uint64_t center = index - _output_delay;
+        _window_begin = center - prediction_time_window;
+        _window_end = center + prediction_time_window;
+        _window_first_bin = 0;
+        _window_end_bin = num_bins();
+        if (const auto it = prediction.find("syncword_freq_bin");
+            it != prediction.end()) {
+            const int bin = pmtv::cast<int>(it->second) - _first_freq_bin;
+            const int window = prediction_freq_window;
+            _window_first_bin = static_cast<size_t>(
+                std::clamp(bin - window, 0, static_cast<int>(num_bins()) - 1));
+            _window_end_bin = static_cast<size_t>(
+                std::clamp(bin + window + 1, 1, static_cast<int>(num_bins())));
+        }
+        // the current candidate is inside the packet that gave the prediction,
+        // so it cannot be a syncword
+        _best = 0.0f;
+        _prediction_active = true;
+    }
+
+    // Threshold for the median check. The median of the correlation power is
+    // lower when fewer frequency bins are searched, so the threshold of a
+    // reduced search window is scaled to keep the same absolute level.
+    float detection_threshold() const noexcept
+    {
+        return _threshold_scale * power_threshold;
+    }
+
+    // Checks if the value _best / detection_threshold() is above the history
+    // median by counting if more than half of the history items are below
+    // this value
+    bool best_above_median() const
+    {
+        const size_t below_threshold =
+            _power_history.count_below(_best / detection_threshold());
+        return 2 * below_threshold >= _history_size;
+    }
+
+    // Refines a detection at the decimated correlation index best_idx by
+    // computing the correlation at the input sample rate around it, and queues
+    // the tag for the syncword. Only the input samples before the absolute
+    // index num_pushed are used.
+    void refine_detection(const gr::ConsumableSpan auto& inSpan,
+                          const syncword_detection::CorrelationItem& coarse_item,
+                          uint64_t best_idx,
+                          uint64_t num_pushed)
+    {
+        const int64_t syncword_size = static_cast<int64_t>(_syncword_samples_size);
+        const int64_t pushed = static_cast<int64_t>(num_pushed);
+        const int64_t consumed = static_cast<int64_t>(_items_consumed);
+        const int64_t oldest_lag =
+            std::max(int64_t{ 0 }, consumed - static_cast<int64_t>(_input_tail.size()));
+        const int64_t newest_lag = pushed - syncword_size;
+        // input sample with absolute index n, which can be in the input span or
+        // in the input tail
+        const auto sample = [&](int64_t n) {
+            if (n < 0) {
+                return c64{};
+            }
+            return n >= consumed ? inSpan[static_cast<size_t>(n - consumed)]
+                                 : _input_tail.past(static_cast<size_t>(consumed - n));
+        };
+        const size_t id = static_cast<size_t>(coarse_item.syncword_id);
+        const auto correlate = [&](int64_t lag, size_t nfreq) {
+            if (lag < oldest_lag || lag > newest_lag) {
+                return c64{};
+            }
+            const c64* syncword_samples =
+                &_shifted_syncwords[template_row(nfreq, id) * _syncword_samples_size];
+            c64 acc{};
+            for (const int64_t u : std::views::iota(int64_t{ 0 }, syncword_size)) {
+                acc += sample(lag + u) * std::conj(syncword_samples[u]);
+            }
+            // scale as the correlation computed with the FFT, which lacks the
+            // 1/N factor of the IFFT
+            return acc * static_cast<float>(fft_len());
+        };
+        const auto power = [](c64 z) {
+            return z.real() * z.real() + z.imag() * z.imag();
+        };
+
+        const int64_t decim = static_cast<int64_t>(decimation);
+        const int64_t center = decim * static_cast<int64_t>(best_idx);
+        size_t nfreq = static_cast<size_t>(coarse_item.freq_bin - _first_freq_bin);
+        int64_t best_lag = center;
+        c64 z{};
+        float zpow = -1.0f;
+        for (const int64_t lag : std::views::iota(center - decim, center + decim + 1)) {
+            const c64 zz = correlate(lag, nfreq);
+            if (power(zz) > zpow) {
+                best_lag = lag;
+                z = zz;
+                zpow = power(zz);
+            }
+        }
+        // the best frequency bin at the input sample rate can be adjacent to
+        // the one found by the decimated correlation
+        const size_t num_freq_bins = num_bins();
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (const size_t candidate : { nfreq - 1, nfreq + 1 }) {
+                if (candidate < num_freq_bins) { // also handles nfreq - 1 wrapping
+                    const c64 zz = correlate(best_lag, candidate);
+                    if (power(zz) > zpow) {
+                        nfreq = candidate;
+                        z = zz;
+                        zpow = power(zz);
+                        moved = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        syncword_detection::CorrelationItem item;
+        item.correlation = z;
+        item.correlation_power = zpow;
+        item.has_left = nfreq > 0;
+        item.has_right = nfreq < num_freq_bins - 1;
+        item.correlation_power_left =
+            item.has_left ? power(correlate(best_lag, nfreq - 1)) : 0.0f;
+        item.correlation_power_right =
+            item.has_right ? power(correlate(best_lag, nfreq + 1)) : 0.0f;
+        item.freq_bin = _first_freq_bin + static_cast<int>(nfreq);
+        item.syncword_id = coarse_item.syncword_id;
+        // the noise is estimated with the most recent input samples
+        const size_t noise_fft_size = _noise_estimator.fft_size();
+        item.fft_noise_power = _noise_estimator.estimate(
+            std::views::iota(pushed - static_cast<int64_t>(noise_fft_size), pushed) |
+            std::views::transform(sample));
+        if (num_pushed < noise_fft_size) {
+            // at the beginning of the stream the delay line is partially
+            // filled with zeros
+            item.fft_noise_power *=
+                static_cast<float>(noise_fft_size) / static_cast<float>(num_pushed);
+        }
+        const float previous_power = power(correlate(best_lag - 1, nfreq));
+        const float next_power = power(correlate(best_lag + 1, nfreq));
+#ifdef TRACE
+        fmt::println("{} refined detection: best_idx = {}, best_lag = {}, freq_bin = {}",
+                     this->name,
+                     best_idx,
+                     best_lag,
+                     item.freq_bin);
+#endif
+        _pending_tags.emplace_back(static_cast<uint64_t>(best_lag) + _output_delay,
+                                   output_tag(item, previous_power, next_power));
+        ++_num_detections;
+    }
+
+    // Writes the first n output samples, publishes the tags that fall in them,
+    // and consumes n input samples.
+    void produce_output(const gr::ConsumableSpan auto& inSpan,
+                        gr::PublishableSpan auto& outSpan,
+                        size_t n)
+    {
+        _input_tail.delayed_copy(inSpan, outSpan, n, _output_delay);
+        while (!_pending_tags.empty() &&
+               _pending_tags.front().first < _items_consumed + n) {
+            out.publishTag(
+                _pending_tags.front().second,
+                static_cast<ssize_t>(_pending_tags.front().first - _items_consumed));
+            _pending_tags.pop_front();
+        }
+        _input_tail.push(inSpan, n);
+        if (!inSpan.consume(n)) {
+            throw gr::exception("consume failed");
+        }
+        _items_consumed += n;
+        outSpan.publish(n);
+#ifdef TRACE
+        fmt::println("{} consume & publish = {}", this->name, n);
+#endif
+    }
+
+    gr::work::Status process_decimated(const gr::ConsumableSpan auto& inSpan,
+                                       gr::PublishableSpan auto& outSpan)
+    {
+        const size_t ntaps = _decimation_taps.size();
+        // decimate all the input, using taps that look forward in time
+        const size_t num_decimated = (inSpan.size() - ntaps) / decimation + 1;
+        _decimated.resize(num_decimated);
+        for (const size_t m : std::views::iota(0UZ, num_decimated)) {
+            c64 acc{};
+            for (const size_t t : std::views::iota(0UZ, ntaps)) {
+                acc += inSpan[m * decimation + t] * _decimation_taps[t];
+            }
+            _decimated[m] = acc;
+        }
+
+        const size_t _stride = segment_stride();
+        const uint64_t decimated_consumed = _items_consumed / decimation;
+        if (energy_gate_threshold > 0.0f) {
+            measure_energy(_decimated, decimated_consumed);
+        }
+        size_t j = 0;
+        while (j + _lookahead + fft_len() <= num_decimated) {
+            const size_t num_segments =
+                correlate_segments(_decimated, j, (decimated_consumed + j) / _stride);
+            for (const Segment& segment : std::span{ _segments }.first(num_segments)) {
+                update_psd(segment, (decimated_consumed + j + _stride) * decimation);
+                if (!segment.correlated) {
+                    skip_segment(decimated_consumed + j + _stride - 1);
+                    j += _stride;
+                    continue;
+                }
+                best_freq_bins(segment, _stride);
+                for (const size_t k : std::views::iota(0UZ, _stride)) {
+                    const uint64_t curr_idx = decimated_consumed + j + k;
+                    if (curr_idx - _best_idx > _time_threshold) {
+                        if (best_above_median()) {
+                            refine_detection(inSpan,
+                                             _best_item,
+                                             _best_idx,
+                                             _items_consumed + (j + k) * decimation);
+                        }
+                        _best = 0.0f;
+                        _best_idx = curr_idx;
+                    }
+                    update_best(segment, k, curr_idx);
+                }
+                j += _stride;
+            }
+        }
+
+        produce_output(inSpan, outSpan, j * decimation);
+        return gr::work::Status::OK;
+    }
+
 public:
     size_t _syncword_samples_size;
-    FFT _fft;
-    // one vector for each freq bin
-    std::vector<std::vector<c64>> _syncword_fft_conj;
-    float _syncword_self_corr;
+    // FFT size used by the correlator, which is chosen by start() if fft_size
+    // is zero
+    size_t _fft_size;
+    size_t _num_syncwords;
+    size_t _num_freq_bins;
+    // frequency bin of the first template, which is the min_freq_bin given to
+    // start()
+    int _first_freq_bin;
+    // frequency bins searched (end bin not included), which are narrowed when
+    // min_freq_bin and max_freq_bin are changed after start()
+    size_t _search_first_bin;
+    size_t _search_end_bin;
+    // scale of power_threshold in a reduced search window, and number of bins
+    // for which it has been calibrated
+    float _threshold_scale;
+    size_t _scale_bins;
+    // true between start() and stop(), when the settings that can be changed
+    // at runtime are applied by settingsChanged()
+    bool _running = false;
+    // value of runtime_search_mode given to start()
+    bool _runtime_search_mode = false;
+    SyncwordCorrelator _correlator;
+    syncword_detection::SearchMode _search_mode = syncword_detection::SearchMode::FULL;
+    syncword_detection::DetectionMode _detection_mode =
+        syncword_detection::DetectionMode::MEDIAN;
+    // in CAUSAL mode, the items before _holdoff_end can only be a candidate if
+    // their power is above _holdoff_power
+    uint64_t _holdoff_end;
+    float _holdoff_power;
+    // number of detections since start()
+    uint64_t _num_detections = 0;
+    // search window around a predicted syncword, in correlator items and
+    // frequency bins (end bin not included)
+    bool _prediction_active;
+    uint64_t _window_begin;
+    uint64_t _window_end;
+    size_t _window_first_bin;
+    size_t _window_end_bin;
+    // predictions without a detection in their window, and predictions
+    // received after their window had been searched, since start()
+    uint64_t _missed_predictions = 0;
+    uint64_t _late_predictions = 0;
+    // carrier frequency offset tracking state: filtered frequency of the
+    // decoded packets, correlator item when the last one was received, and
+    // window of frequency bins around the estimate (end bin not included)
+    bool _tracking;
+    double _cfo_estimate;
+    uint64_t _last_packet_idx;
+    uint64_t _tracking_timeout;
+    size_t _tracking_first_bin;
+    size_t _tracking_end_bin;
+    // number of times that the tracking has gone back to the full search
+    // since start()
+    uint64_t _tracking_timeouts = 0;
+    // first frequency bin (as an index into the correlator bins) of the coarse
+    // grid
+    size_t _coarse_first_bin;
+    // two-stage search state: slot of the correlator that contains the
+    // current segment, and whether it has been computed already as the
+    // lookahead of the previous segment
+    size_t _slot;
+    bool _lookahead_valid;
+    bool _prev_pass;
+    float _slot_noise_power[2];
+    bool _slot_pass[2];
+    // number of samples after the segment being correlated that must be
+    // available, to compute the two-stage lookahead or to measure the energy
+    // of the segments after it
+    size_t _lookahead;
+    syncword_detection::EnergyGate _energy_gate;
+    // number of segments skipped by the energy gate or before a predicted
+    // window since start()
+    uint64_t _skipped_segments = 0;
+    // power spectral density frame being accumulated: sum of the power
+    // spectra and of the noise powers of its segments, and input item at
+    // which the frame ends
+    std::vector<float> _psd_sum;
+    float _psd_noise_sum;
+    uint64_t _psd_num_segments;
+    uint64_t _psd_frame_end;
+    // frames finished in the current call to processBulk()
+    std::vector<gr::Message> _psd_frames;
+    // frames dropped because the psd port had no space since start()
+    uint64_t _psd_dropped_frames = 0;
+    // size of the syncword template used by the correlator, which is smaller
+    // than _syncword_samples_size if decimation is used
+    size_t _template_size;
+    // time_threshold at the sample rate of the correlator
+    uint64_t _time_threshold;
+    // decimation state
+    std::vector<float> _decimation_taps;
+    std::vector<c64> _decimated;
+    // syncwords shifted to each frequency bin at the input sample rate, in
+    // the order given by template_row()
+    std::vector<c64> _shifted_syncwords;
+    // input samples, which are output with a delay of _output_delay
+    syncword_detection::InputTail _input_tail;
+    size_t _output_delay;
+    syncword_detection::NoiseEstimator _noise_estimator;
+    // correlation of a batch of segments computed by the workers
+    std::vector<Segment> _segments;
+    // best template and its correlation power for each item of a segment
+    std::vector<uint32_t> _item_row;
+    std::vector<float> _item_power;
+    WorkerPool _workers;
+    // tags for detected syncwords, indexed by output item
+    std::deque<std::pair<uint64_t, gr::property_map>> _pending_tags;
+    // energy of each syncword
+    std::vector<float> _syncword_self_corr;
+    // best candidate for a detection
     float _best;
     uint64_t _best_idx;
+    syncword_detection::CorrelationItem _best_item;
     uint64_t _items_consumed;
     size_t _history_size;
-    // placeholder size; assigned in start()
-    HistoryBuffer<syncword_detection::HistoryItem> _history{ 2 };
+    // correlation powers of the last _history_size items
+    syncword_detection::PowerHistory _power_history;
+    FftConfig _fft_config;
+    // time spent in the last call to start()
+    double _startup_time_secs = 0.0;
 
 public:
+    gr::PortIn<gr::Message, gr::Async> next_syncword;
     gr::PortIn<std::complex<float>> in;
     gr::PortOut<std::complex<float>> out;
-    size_t fft_size = 2048;
-    size_t samples_per_symbol = 4;
+    gr::PortOut<gr::Message, gr::Async, gr::Optional> psd;
+    size_t fft_size = fixed_fft_size != 0 ? fixed_fft_size : 2048;
+    size_t samples_per_symbol =
+        fixed_samples_per_symbol != 0 ? fixed_samples_per_symbol : 4;
     std::vector<float> rrc_taps;
     std::vector<uint8_t> syncword;
+    size_t num_syncwords = 1;
     std::vector<std::complex<float>> constellation;
-    int min_freq_bin = 0;
-    int max_freq_bin = 0;
+    int min_freq_bin = -static_cast<int>(fixed_num_freq_bins / 2);
+    int max_freq_bin =
+        fixed_num_freq_bins != 0 ? static_cast<int>((fixed_num_freq_bins - 1) / 2) : 0;
     uint64_t time_threshold = 768;
     float power_threshold = 9.5;
+    std::string search_mode{ magic_enum::enum_name(_search_mode) };
+    size_t coarse_bin_step = 2;
+    float coarse_threshold = 0.6f;
+    bool runtime_search_mode = false;
+    size_t decimation = 1;
+    size_t num_threads = 1;
+    std::string fft_backend{ magic_enum::enum_name(_fft_config.backend) };
+    std::string fftw_planner{ magic_enum::enum_name(_fft_config.planner) };
+    std::string fftw_wisdom_file;
+    float energy_gate_threshold = 0.0f;
+    std::string detection_mode{ magic_enum::enum_name(_detection_mode) };
+    uint64_t causal_lookahead = 64;
+    float causal_threshold = 25.0f;
+    uint64_t prediction_time_window = 0;
+    int prediction_freq_window = 1;
+    bool cfo_tracking = false;
+    int tracking_freq_window = 0;
+    float tracking_alpha = 0.25f;
+    uint64_t tracking_timeout = 10'000'000;
+    uint64_t psd_frame_length = 0;
+    bool log = false;
 
     void start()
     {
+        const auto startup_begin = std::chrono::steady_clock::now();
         if (min_freq_bin > max_freq_bin) {
             throw gr::exception("min_freq_bin is greater than max_freq_bin");
         }
-        _syncword_samples_size =
-            (syncword.size() - 1) * samples_per_symbol + rrc_taps.size();
-        if (_syncword_samples_size > fft_size) {
+        if (decimation == 0) {
+            throw gr::exception("decimation cannot be zero");
+        }
+        if (num_threads == 0) {
+            throw gr::exception("num_threads cannot be zero");
+        }
+        if (fixed_fft_size != 0 && fft_size != fixed_fft_size) {
+            throw gr::exception(
+                fmt::format("fft_size must be {} in this variant", fixed_fft_size));
+        }
+        if (fixed_num_freq_bins != 0 &&
+            static_cast<size_t>(max_freq_bin - min_freq_bin + 1) != fixed_num_freq_bins) {
+            throw gr::exception(fmt::format(
+                "there must be {} frequency bins in this variant", fixed_num_freq_bins));
+        }
+        if (fixed_samples_per_symbol != 0 &&
+            samples_per_symbol != fixed_samples_per_symbol) {
+            throw gr::exception(
+                fmt::format("samples_per_symbol must be {} in this variant",
+                            fixed_samples_per_symbol));
+        }
+        if (num_syncwords == 0) {
+            throw gr::exception("num_syncwords cannot be zero");
+        }
+        if (syncword.empty() || syncword.size() % num_syncwords != 0) {
+            throw gr::exception(
+                "the syncword size must be a non-zero multiple of num_syncwords");
+        }
+        _num_syncwords = num_syncwords;
+        _num_freq_bins = static_cast<size_t>(max_freq_bin - min_freq_bin + 1);
+        _first_freq_bin = min_freq_bin;
+        _search_first_bin = 0;
+        _search_end_bin = _num_freq_bins;
+        const size_t syncword_length = syncword.size() / _num_syncwords;
+        _syncword_samples_size = (syncword_length - 1) * sps() + rrc_taps.size();
+        _template_size = (_syncword_samples_size - 1) / decimation + 1;
+        if (fft_size != 0 && _template_size > fft_size) {
             throw gr::exception("fft_size too small");
         }
+        if (decimation > 1 && time_threshold <= _syncword_samples_size) {
+            throw gr::exception("time_threshold too small for decimation");
+        }
+        _search_mode = magic_enum::enum_cast<syncword_detection::SearchMode>(
+                           search_mode, magic_enum::case_insensitive)
+                           .value();
+        if (coarse_bin_step == 0) {
+            throw gr::exception("coarse_bin_step cannot be zero");
+        }
+        if (energy_gate_threshold < 0.0f) {
+            throw gr::exception("energy_gate_threshold cannot be negative");
+        }
+        _detection_mode = magic_enum::enum_cast<syncword_detection::DetectionMode>(
+                              detection_mode, magic_enum::case_insensitive)
+                              .value();
+        const bool causal = _detection_mode == syncword_detection::DetectionMode::CAUSAL;
+        if (causal && decimation != 1) {
+            throw gr::exception("CAUSAL detection_mode requires decimation = 1");
+        }
+        if (causal && (causal_lookahead == 0 || causal_lookahead >= time_threshold)) {
+            throw gr::exception("causal_lookahead must be between 1 and time_threshold");
+        }
+        if (prediction_time_window > 0 && (causal || decimation != 1)) {
+            throw gr::exception("prediction_time_window requires MEDIAN detection_mode "
+                                "and decimation = 1");
+        }
+        if (2 * prediction_time_window >= time_threshold) {
+            throw gr::exception("prediction_time_window must be less than half of "
+                                "time_threshold");
+        }
+        if (prediction_freq_window < 0) {
+            throw gr::exception("prediction_freq_window cannot be negative");
+        }
+        if (tracking_freq_window < 0) {
+            throw gr::exception("tracking_freq_window cannot be negative");
+        }
+        if (tracking_alpha <= 0.0f || tracking_alpha > 1.0f) {
+            throw gr::exception("tracking_alpha must be in (0, 1]");
+        }
+        _fft_config.backend =
+            magic_enum::enum_cast<FftBackend>(fft_backend, magic_enum::case_insensitive)
+                .value();
+        _fft_config.planner =
+            magic_enum::enum_cast<FftPlanner>(fftw_planner, magic_enum::case_insensitive)
+                .value();
+        const bool use_wisdom =
+            _fft_config.backend == FftBackend::FFTW && !fftw_wisdom_file.empty();
+        if (use_wisdom) {
+            fftw::import_wisdom(fftw_wisdom_file);
+        }
+        const bool two_stage = _search_mode == syncword_detection::SearchMode::TWO_STAGE;
+        // the coarse grid is strided in frequency bins, and each frequency
+        // bin contains a template for each syncword
+        const size_t bin_step = coarse_bin_step * _num_syncwords;
+        if (fft_size != 0) {
+            _fft_size = fft_size;
+        } else {
+            const syncword_detection::FftSizeKey key{ _template_size,
+                                                      _num_freq_bins * _num_syncwords,
+                                                      two_stage ? bin_step : 1,
+                                                      two_stage ? _num_syncwords : 1,
+                                                      _fft_config };
+            const auto [size, cached] =
+                syncword_detection::tune_fft_size(
+                    key,
+                    fftw_wisdom_file.empty() ? std::string{}
+                                             : fftw_wisdom_file + ".fft_size");
+            _fft_size = size;
+            if (log) {
+                fmt::println("{} auto-tuned fft_size = {}{}",
+                             this->name,
+                             _fft_size,
+                             cached ? " (cached)" : "");
+            }
+        }
 
-        std::vector<c64> syncword_samples(_syncword_samples_size);
-        for (const size_t j : std::views::iota(0UZ, syncword.size())) {
-            for (const size_t k : std::views::iota(0UZ, rrc_taps.size())) {
-                syncword_samples[j * samples_per_symbol + k] +=
-                    constellation[syncword[j]] * rrc_taps[k];
-            }
-        }
-        _syncword_self_corr = 0.0f;
-        for (auto x : syncword_samples) {
-            _syncword_self_corr += x.real() * x.real() + x.imag() * x.imag();
-        }
-
-        for (const int freq_bin : std::views::iota(min_freq_bin, max_freq_bin + 1)) {
-            // shift syncword samples in frequency; each frequency bin is 1/2 of
-            // the coherent integration interval
-            double phase = 0.0;
-            const double phase_incr = static_cast<double>(freq_bin) * std::numbers::pi /
-                                      static_cast<double>(_syncword_samples_size);
-            std::vector<c64> syncword_samples_shifted = syncword_samples;
-            for (auto& x : syncword_samples_shifted) {
-                x *= std::complex<float>{ static_cast<float>(std::cos(phase)),
-                                          static_cast<float>(std::sin(phase)) };
-                phase += phase_incr;
-                if (phase >= std::numbers::pi) {
-                    phase -= 2.0 * std::numbers::pi;
-                } else if (phase < std::numbers::pi) {
-                    phase += 2.0 * std::numbers::pi;
+        // modulated syncwords, one after another
+        std::vector<c64> syncword_samples(_num_syncwords * _syncword_samples_size);
+        _syncword_self_corr.assign(_num_syncwords, 0.0f);
+        for (const size_t id : std::views::iota(0UZ, _num_syncwords)) {
+            c64* samples = &syncword_samples[id * _syncword_samples_size];
+            for (const size_t j : std::views::iota(0UZ, syncword_length)) {
+                const c64 symbol = constellation[syncword[id * syncword_length + j]];
+                for (const size_t k : std::views::iota(0UZ, rrc_taps.size())) {
+                    samples[j * sps() + k] += symbol * rrc_taps[k];
                 }
             }
-            syncword_samples_shifted.resize(fft_size);
-            auto syncword_fft_conj = _fft.compute(syncword_samples_shifted);
-            for (auto& z : syncword_fft_conj) {
-                z = std::conj(z);
+            for (const size_t j : std::views::iota(0UZ, _syncword_samples_size)) {
+                _syncword_self_corr[id] += samples[j].real() * samples[j].real() +
+                                           samples[j].imag() * samples[j].imag();
+            }
+        }
+        _shifted_syncwords.assign(
+            _num_freq_bins * _num_syncwords * _syncword_samples_size, c64{});
+        for (const size_t nfreq : std::views::iota(0UZ, _num_freq_bins)) {
+            for (const size_t id : std::views::iota(0UZ, _num_syncwords)) {
+                SyncwordCorrelator::shift_frequency(
+                    std::span{ &syncword_samples[id * _syncword_samples_size],
+                               _syncword_samples_size },
+                    min_freq_bin + static_cast<int>(nfreq),
+                    std::span{ &_shifted_syncwords[template_row(nfreq, id) *
+                                                   _syncword_samples_size],
+                               _syncword_samples_size });
             }
-            _syncword_fft_conj.push_back(syncword_fft_conj);
         }
 
+        // In FULL mode each worker thread computes the correlation of one
+        // segment on its own slot. The correlator is prepared for both search
+        // modes if search_mode can be changed at runtime.
+        _runtime_search_mode = runtime_search_mode;
+        const size_t num_slots = runtime_search_mode ? std::max(2UZ, num_threads)
+                                 : two_stage         ? 2UZ
+                                                     : num_threads;
+        if (decimation > 1) {
+            // the passband of the decimation filter extends up to 1/2 of the
+            // decimated sample rate
+            _decimation_taps = firdes::low_pass(
+                1.0, static_cast<double>(decimation), 0.5, 8 * decimation + 1);
+            _noise_estimator.init(decimation * _fft_size, _fft_config);
+        }
+        // All the syncwords are correlated against the same spectrum of the
+        // input, so the forward FFT is computed once per segment regardless of
+        // the number of syncwords. With decimation, the templates are the
+        // frequency shifted syncwords passed through the same decimation
+        // filter as the input.
+        _correlator.init(
+            _template_size,
+            _fft_size,
+            _num_freq_bins * _num_syncwords,
+            bin_step,
+            num_slots,
+            [&](size_t row, std::span<c64> syncword_template) {
+                const c64* shifted = &_shifted_syncwords[row * _syncword_samples_size];
+                if (decimation == 1) {
+                    std::copy_n(shifted, _template_size, syncword_template.begin());
+                    return;
+                }
+                const size_t ntaps = _decimation_taps.size();
+                for (const size_t m : std::views::iota(0UZ, _template_size)) {
+                    c64 acc{};
+                    for (const size_t t : std::views::iota(0UZ, ntaps)) {
+                        const size_t n = m * decimation + t;
+                        if (n < _syncword_samples_size) {
+                            acc += shifted[n] * _decimation_taps[t];
+                        }
+                    }
+                    syncword_template[m] = acc;
+                }
+            },
+            _fft_config,
+            SyncwordCorrelator::TemplateKey{
+                std::move(syncword_samples), min_freq_bin, decimation });
+        if (use_wisdom) {
+            fftw::export_wisdom(fftw_wisdom_file);
+        }
+        // the coarse grid contains the frequency bin closest to zero
+        const int center_bin = std::clamp(0, min_freq_bin, max_freq_bin);
+        _coarse_first_bin =
+            static_cast<size_t>(center_bin - min_freq_bin) % coarse_bin_step;
+        _slot = 0;
+        _lookahead_valid = false;
+        _prev_pass = false;
+
         _best = 0.0f;
         _best_idx = 0;
+        _best_item = {};
         _items_consumed = 0;
-        _history_size = 2 * time_threshold + 1;
-        // the history actually contains at least _history_size + 1 items
-        // because we need to look to the previous item in order to estimate
-        // fine time delay
-        _history = HistoryBuffer<syncword_detection::HistoryItem>(
-            std::bit_ceil(_history_size + 1));
-        in.min_samples = fft_size;
-        out.min_samples = fft_size;
+        _time_threshold = (time_threshold + decimation - 1) / decimation;
+        _history_size = 2 * _time_threshold + 1;
+        _power_history.reset(_history_size);
+        _segments.resize(num_slots);
+        _item_row.resize(segment_stride());
+        _item_power.resize(segment_stride());
+        // the gate keeps open enough segments before and after the energy to
+        // fill the power history
+        const size_t gate_margin =
+            std::max(1UZ, (_history_size + segment_stride() - 1) / segment_stride());
+        _energy_gate.reset(energy_gate_threshold, _template_size / 2, gate_margin);
+        _skipped_segments = 0;
+        _psd_sum.assign(psd_frame_length > 0 ? _fft_size : 0UZ, 0.0f);
+        _psd_noise_sum = 0.0f;
+        _psd_num_segments = 0;
+        _psd_frame_end = psd_frame_length;
+        _psd_frames.clear();
+        _psd_dropped_frames = 0;
+        // the lookahead of the two-stage search is also kept in FULL mode if
+        // search_mode can be changed at runtime
+        _lookahead = std::max(two_stage || runtime_search_mode ? segment_stride() : 0UZ,
+                              energy_gate_threshold > 0.0f
+                                  ? gate_margin * segment_stride()
+                                  : 0UZ);
+        _workers.start(two_stage && !runtime_search_mode ? 1 : num_threads);
+        _holdoff_end = 0;
+        _holdoff_power = 0.0f;
+        _num_detections = 0;
+        _prediction_active = false;
+        _missed_predictions = 0;
+        _late_predictions = 0;
+        _tracking = false;
+        _cfo_estimate = 0.0;
+        _threshold_scale = 1.0f;
+        _scale_bins = _num_freq_bins;
+        _last_packet_idx = 0;
+        _tracking_timeout = tracking_timeout / decimation;
+        _tracking_timeouts = 0;
+        // in CAUSAL mode a detection is declared causal_lookahead items after
+        // the peak
+        _output_delay = causal ? causal_lookahead + 1 : 2 * time_threshold + 1;
+        // in decimated mode, the input tail also needs to contain the samples
+        // used to refine a detection and the samples used to estimate the
+        // noise
+        _input_tail.reset(
+            decimation == 1 ? _output_delay
+                            : std::max({ _output_delay,
+                                         time_threshold + 3 * decimation + 1,
+                                         _noise_estimator.fft_size() }));
+        _pending_tags.clear();
+        // the two-stage search needs the next segment to decide whether to
+        // compute all the frequency bins in the current segment, and the
+        // energy gate needs the segments within its margin
+        const size_t correlator_samples = _fft_size + _lookahead;
+        const size_t min_samples =
+            decimation == 1 ? correlator_samples
+                            : (correlator_samples - 1) * decimation +
+                                  _decimation_taps.size();
+        in.min_samples = min_samples;
+        out.min_samples = min_samples;
+        _running = true;
+        _startup_time_secs = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - startup_begin)
+                                 .count();
+    }
+
+    void stop()
+    {
+        _running = false;
+        _workers.stop();
+    }
+
+    void settingsChanged(const gr::property_map& /* old_settings */,
+                         const gr::property_map& new_settings)
+    {
+        // Before start() is called all the settings are applied by start().
+        // Afterwards, only the frequency bins, the search mode and the
+        // thresholds can be changed without restarting the block.
+        if (!_running) {
+            return;
+        }
+        if (new_settings.contains("min_freq_bin") ||
+            new_settings.contains("max_freq_bin")) {
+            const int end_freq_bin = _first_freq_bin + static_cast<int>(num_bins());
+            if (min_freq_bin > max_freq_bin || min_freq_bin < _first_freq_bin ||
+                max_freq_bin >= end_freq_bin) {
+                throw gr::exception(
+                    fmt::format("the frequency bins can only be changed to a subset "
+                                "of [{}, {}] without restarting the block",
+                                _first_freq_bin,
+                                end_freq_bin - 1));
+            }
+            _search_first_bin = static_cast<size_t>(min_freq_bin - _first_freq_bin);
+            _search_end_bin = static_cast<size_t>(max_freq_bin - _first_freq_bin + 1);
+        }
+        if (new_settings.contains("search_mode")) {
+            const auto mode = magic_enum::enum_cast<syncword_detection::SearchMode>(
+                                  search_mode, magic_enum::case_insensitive)
+                                  .value();
+            if (mode != _search_mode && !_runtime_search_mode) {
+                throw gr::exception("search_mode can only be changed without "
+                                    "restarting the block if runtime_search_mode "
+                                    "is true");
+            }
+            _search_mode = mode;
+            // the two-stage search starts again in the next segment
+            _lookahead_valid = false;
+            _prev_pass = false;
+        }
     }
 
-    gr::work::Status processBulk(const gr::ConsumableSpan auto& inSpan,
-                                 gr::PublishableSpan auto& outSpan)
+    gr::work::Status processBulk(const gr::ConsumableSpan auto& nextSpan,
+                                 const gr::ConsumableSpan auto& inSpan,
+                                 gr::PublishableSpan auto& outSpan,
+                                 gr::PublishableSpan auto& psdSpan)
     {
 #ifdef TRACE
-        fmt::println("{}::processBulk(inSpan.size() = {}, outSpan.size = {})",
+        fmt::println("{}::processBulk(nextSpan.size() = {}, inSpan.size() = {}, "
+                     "outSpan.size = {}, psdSpan.size() = {})",
                      this->name,
+                     nextSpan.size(),
                      inSpan.size(),
-                     outSpan.size());
+                     outSpan.size(),
+                     psdSpan.size());
 #endif
+        for (const auto& message : nextSpan) {
+            if (message.data.has_value()) {
+                predict(message.data.value());
+                track(message.data.value());
+            }
+        }
+        if (!nextSpan.consume(nextSpan.size())) {
+            throw gr::exception("consume failed");
+        }
         // it seems that the scheduler isn't respecting the rules of min_samples when
         // calling this block
-        if (inSpan.size() < fft_size) {
+        if (inSpan.size() < in.min_samples) {
             if (!inSpan.consume(0)) {
                 throw gr::exception("consume failed");
             }
             outSpan.publish(0);
+            psdSpan.publish(0);
 #ifdef TRACE
             fmt::println("{} called with {} input items, but minimum is {}",
                          this->name,
@@ -226,149 +2175,104 @@ public:
             return gr::work::Status::INSUFFICIENT_INPUT_ITEMS;
         }
         assert(inSpan.size() == outSpan.size());
-        assert(inSpan.size() >= fft_size);
-        const size_t num_freq_bins = static_cast<size_t>(max_freq_bin - min_freq_bin + 1);
-        std::vector<c64> samples_fft;
-        std::vector<c64> samples_fft_prod(fft_size);
-        std::vector<std::vector<c64>> correlation(num_freq_bins);
+        assert(inSpan.size() >= in.min_samples);
+        if (decimation > 1) {
+            const auto status = process_decimated(inSpan, outSpan);
+            publish_psd(psdSpan);
+            return status;
+        }
         // this is called _stride rather than stride because stride is already a
         // member of Block
-        const size_t _stride = fft_size - _syncword_samples_size + 1;
-        size_t j;
-        for (j = 0; j + fft_size <= inSpan.size(); j += _stride) {
-            samples_fft =
-                _fft.compute(inSpan | std::views::drop(j) | std::views::take(fft_size),
-                             std::move(samples_fft));
-            // Compute IFFT(FFT(samples) * conj(FFT(syncword))
-            //
-            // The IFFT is computed as an FFT, so the sign of its time axis is
-            // flipped.
-            for (const size_t nfreq : std::views::iota(0UZ, num_freq_bins)) {
-                for (const size_t k : std::views::iota(0UZ, fft_size)) {
-                    samples_fft_prod[k] = samples_fft[k] * _syncword_fft_conj[nfreq][k];
+        const size_t _stride = segment_stride();
+        if (energy_gate_threshold > 0.0f) {
+            measure_energy(inSpan, _items_consumed);
+        }
+        size_t j = 0;
+        while (j + _lookahead + fft_len() <= inSpan.size()) {
+            const size_t num_segments =
+                correlate_segments(inSpan, j, (_items_consumed + j) / _stride);
+            for (const Segment& segment : std::span{ _segments }.first(num_segments)) {
+                update_psd(segment, _items_consumed + j + _stride);
+                if (!segment.correlated) {
+                    skip_segment(_items_consumed + j + _stride - 1);
+                    j += _stride;
+                    continue;
                 }
-                correlation[nfreq] =
-                    _fft.compute(samples_fft_prod, std::move(correlation[nfreq]));
-            }
-
-            // Compute noise power as the power in the outermost 1/2 of the FFT
-            // bin (note that there is no fftshift, so the outermost 1/2 is
-            // actually the central 1/2)
-            float fft_noise_power = 0.0f;
-            for (const size_t k : std::views::iota(fft_size / 4, 3 * fft_size / 4)) {
-                const auto z = samples_fft[k];
-                fft_noise_power += z.real() * z.real() + z.imag() * z.imag();
-            }
-            // dividing by fft_size (which is sqrt(fft_size) squared) is needed
-            // to obtain a unitary FFT transform
-            fft_noise_power /=
-                static_cast<float>(fft_size / 2) * static_cast<float>(fft_size);
-
-            for (const size_t k : std::views::iota(0UZ, _stride)) {
-                const uint64_t curr_idx = _items_consumed + j + k;
-                if (curr_idx - _best_idx > time_threshold) {
-                    // check if the value _best / power_threshold is above the
-                    // history median by counting if more than half of the
-                    // history items are below this value
-                    size_t below_threshold = 0;
-                    for (const size_t u : std::views::iota(0UZ, _history_size)) {
-                        if (_history[u].correlation_power < _best / power_threshold) {
-                            ++below_threshold;
+                best_freq_bins(segment, _stride);
+                if (_prediction_active) {
+                    for (const size_t k : std::views::iota(0UZ, _stride)) {
+                        // the prediction ends inside the segment if the
+                        // decision is taken
+                        if (_prediction_active) {
+                            predicted_update(segment, k, _items_consumed + j + k);
+                        } else {
+                            median_update(segment, k, _items_consumed + j + k);
                         }
                     }
-                    if (2 * below_threshold >= _history_size) {
-#ifdef TRACE
-                        fmt::println(
-                            "{} best found: _best = {}, _best_idx = {}, curr_idx = {}",
-                            this->name,
-                            _best,
-                            _best_idx,
-                            curr_idx);
-#endif
-                        // the items in the history have these indices:
-                        // _curr_idx - _history_size, _curr_idx - _history_size + 1, ...,
-                        // _curr_idx - 1.
-                        const size_t hist_idx = _best_idx + _history_size - curr_idx;
-                        // the history indices are time-reversed: _history[0] is the
-                        // item most recently pushed into the history
-                        _history[_history_size - 1 - hist_idx].detection = true;
-                    }
-                    _best = 0.0f;
-                    _best_idx = curr_idx;
+                    j += _stride;
+                    continue;
                 }
-                // This takes into account the time-reversal of the correlation
-                const size_t z_idx = k == 0 ? 0 : fft_size - k;
-                size_t best_freq = 0;
-                c64 z;
-                float zpow = -1.0;
-                // Find best frequency bin
-                for (const size_t nfreq : std::views::iota(0UZ, num_freq_bins)) {
-                    const c64 zz = correlation[nfreq][z_idx];
-                    const float zzpow = zz.real() * zz.real() + zz.imag() * zz.imag();
-                    if (zzpow > zpow) {
-                        best_freq = nfreq;
-                        z = zz;
-                        zpow = zzpow;
+                if (_detection_mode == syncword_detection::DetectionMode::CAUSAL) {
+                    for (const size_t k : std::views::iota(0UZ, _stride)) {
+                        causal_update(segment, k, _items_consumed + j + k);
                     }
+                    j += _stride;
+                    continue;
                 }
-                if (zpow > _best) {
-                    _best = zpow;
-                    _best_idx = curr_idx;
-                }
-                const auto& pop_history = _history[_history_size - 1];
-                outSpan[j + k] = pop_history.sample;
-                if (pop_history.detection) {
-                    out.publishTag(output_tag(pop_history,
-                                              _history[_history_size],
-                                              _history[_history_size - 2]),
-                                   static_cast<ssize_t>(j + k));
-                }
-                syncword_detection::HistoryItem item;
-                item.sample = inSpan[j + k];
-                item.correlation_power = zpow;
-                if (best_freq > 0) {
-                    const auto z_left = correlation[best_freq - 1][z_idx];
-                    item.correlation_power_left =
-                        z_left.real() * z_left.real() + z_left.imag() * z_left.imag();
+                for (const size_t k : std::views::iota(0UZ, _stride)) {
+                    median_update(segment, k, _items_consumed + j + k);
                 }
-                if (best_freq < num_freq_bins - 1) {
-                    const auto z_right = correlation[best_freq + 1][z_idx];
-                    item.correlation_power_right =
-                        z_right.real() * z_right.real() + z_right.imag() * z_right.imag();
-                }
-                item.correlation = z;
-                item.freq_bin = min_freq_bin + static_cast<int>(best_freq);
-                item.fft_noise_power = fft_noise_power;
-                _history.push_back(item);
+                j += _stride;
             }
         }
 
-        if (!inSpan.consume(j)) {
-            throw gr::exception("consume failed");
-        }
-        _items_consumed += j;
-        outSpan.publish(j);
-#ifdef TRACE
-        fmt::println("{} consume & publish = {}", this->name, j);
-#endif
-
+        produce_output(inSpan, outSpan, j);
+        publish_psd(psdSpan);
         return gr::work::Status::OK;
     }
 };
 
 } // namespace gr::packet_modem
 
-ENABLE_REFLECTION(gr::packet_modem::SyncwordDetection,
-                  in,
-                  out,
-                  fft_size,
-                  samples_per_symbol,
-                  rrc_taps,
-                  syncword,
-                  constellation,
-                  min_freq_bin,
-                  max_freq_bin,
-                  time_threshold,
-                  power_threshold);
+ENABLE_REFLECTION_FOR_TEMPLATE_FULL(
+    (size_t fixed_fft_size, size_t fixed_num_freq_bins, size_t fixed_samples_per_symbol),
+    (gr::packet_modem::SyncwordDetection<fixed_fft_size,
+                                         fixed_num_freq_bins,
+                                         fixed_samples_per_symbol>),
+    next_syncword,
+    in,
+    out,
+    psd,
+    fft_size,
+    samples_per_symbol,
+    rrc_taps,
+    syncword,
+    num_syncwords,
+    constellation,
+    min_freq_bin,
+    max_freq_bin,
+    time_threshold,
+    power_threshold,
+    search_mode,
+    coarse_bin_step,
+    coarse_threshold,
+    runtime_search_mode,
+    decimation,
+    num_threads,
+    fft_backend,
+    fftw_planner,
+    fftw_wisdom_file,
+    energy_gate_threshold,
+    detection_mode,
+    causal_lookahead,
+    causal_threshold,
+    prediction_time_window,
+    prediction_freq_window,
+    cfo_tracking,
+    tracking_freq_window,
+    tracking_alpha,
+    tracking_timeout,
+    psd_frame_length,
+    log);
 
 #endif // _GR4_PACKET_MODEM_SYNCWORD_DETECTION
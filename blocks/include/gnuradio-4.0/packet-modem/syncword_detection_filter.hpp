@@ -3,6 +3,7 @@
 
 #include <gnuradio-4.0/Block.hpp>
 #include <gnuradio-4.0/reflection.hpp>
+#include <atomic>
 #include <complex>
 
 namespace gr::packet_modem {
@@ -29,18 +30,37 @@ the packet has finished after the header). In this way, the Syncword Detection
 Filter keeps track of wheter a particular sample is inside of a packet or
 not. If syncword_ tags are received inside a packet, they are dropped.
 
+When a header indicating the packet length is received, the block sends a
+message in the `next_syncword` port with the index of the sample where the
+syncword of the next packet would begin if it was sent immediately after this
+packet (as in stream mode), in the `"syncword_index"` field, and the frequency
+bin and frequency of the syncword of this packet, in the `"syncword_freq_bin"`
+and `"syncword_freq"` fields, if the syncword tag contained them. This message
+can be sent to the Syncword Detection block to restrict its search to a window
+around the next syncword or to track the carrier frequency offset of the
+packets.
+
 )"">;
 
 public:
     bool _in_packet = false;
+    // copy of _in_packet that can be read from other threads, for instance
+    // by the Load Governor of the Packet Receiver
+    std::atomic<bool> _packet_open = false;
     size_t _position = 0;
     size_t _block_until = 0;
+    uint64_t _items_consumed = 0;
+    // index of the sample where the current packet begins and frequency of
+    // its syncword
+    uint64_t _packet_start = 0;
+    gr::property_map _packet_freq;
 
 public:
     gr::PortIn<gr::Message, gr::Async> parsed_header;
     gr::PortIn<gr::Message, gr::Async> ignored_syncword;
     gr::PortIn<T> in;
     gr::PortOut<T> out;
+    gr::PortOut<gr::Message, gr::Async> next_syncword;
     size_t samples_per_symbol = 4;
     size_t syncword_size = 64;
     size_t header_size = 128;
@@ -49,12 +69,18 @@ public:
     constexpr static gr::TagPropagationPolicy tag_policy =
         gr::TagPropagationPolicy::TPP_CUSTOM;
 
-    void start() { _in_packet = false; }
+    void start()
+    {
+        _in_packet = false;
+        _packet_open.store(false, std::memory_order::relaxed);
+        _items_consumed = 0;
+    }
 
     gr::work::Status processBulk(const gr::ConsumableSpan auto& headerSpan,
                                  const gr::ConsumableSpan auto& ignoredSpan,
                                  const gr::ConsumableSpan auto& inSpan,
-                                 gr::PublishableSpan auto& outSpan)
+                                 gr::PublishableSpan auto& outSpan,
+                                 gr::PublishableSpan auto& nextSpan)
     {
         using namespace std::string_literals;
 
@@ -93,8 +119,16 @@ public:
             }
             if (new_in_packet) {
                 _in_packet = true;
+                _packet_open.store(true, std::memory_order::relaxed);
                 _position = 0;
                 _block_until = 0; // packet size yet unknown
+                _packet_start = _items_consumed;
+                _packet_freq.clear();
+                for (const char* key : { "syncword_freq_bin", "syncword_freq" }) {
+                    if (const auto it = tag.map.find(key); it != tag.map.end()) {
+                        _packet_freq[key] = it->second;
+                    }
+                }
             }
             if (!output_tags.empty()) {
 #ifdef TRACE
@@ -117,6 +151,8 @@ public:
                 throw gr::exception(fmt::format("inSpan.consume({}) failed", n));
             }
             outSpan.publish(n);
+            nextSpan.publish(0);
+            _items_consumed += n;
             // _mergedInputTag.map.clear() only gets called automatically by the
             // block forwardTags() whenever the block consumes some samples on
             // all inputs and produces some samples on all outputs. Here it
@@ -130,6 +166,7 @@ public:
         }
 
         size_t header_consumed = 0;
+        size_t next_published = 0;
 
         if (_block_until == 0 && headerSpan.size() > 0) {
             auto meta = headerSpan[0].data.value();
@@ -149,6 +186,17 @@ public:
                 const size_t payload_symbols = (packet_length + crc_size_bytes) * 4;
                 _block_until = samples_per_symbol * (header_size + syncword_size -
                                                      allowed_margin + payload_symbols);
+                if (nextSpan.size() == 0) {
+                    throw gr::exception("nextSpan is empty but we need to use it");
+                }
+                gr::property_map next = _packet_freq;
+                next["syncword_index"] =
+                    _packet_start +
+                    samples_per_symbol * (syncword_size + header_size + payload_symbols);
+                gr::Message message;
+                message.data = std::move(next);
+                nextSpan[0] = std::move(message);
+                next_published = 1;
             }
         }
 
@@ -181,6 +229,7 @@ public:
             consumed += n;
             if (_position >= _block_until) {
                 _in_packet = false;
+                _packet_open.store(false, std::memory_order::relaxed);
             }
         }
 
@@ -194,6 +243,8 @@ public:
             throw gr::exception(fmt::format("ignoredSpan.consume({})", ignored_consumed));
         }
         outSpan.publish(consumed);
+        nextSpan.publish(next_published);
+        _items_consumed += consumed;
         // _mergedInputTag.map.clear() only gets called automatically by the
         // block forwardTags() whenever the block consumes some samples on all
         // inputs and produces some samples on all outputs. Here it needs to be
@@ -217,6 +268,7 @@ ENABLE_REFLECTION_FOR_TEMPLATE(gr::packet_modem::SyncwordDetectionFilter,
                                ignored_syncword,
                                in,
                                out,
+                               next_syncword,
                                samples_per_symbol,
                                syncword_size,
                                header_size);
@@ -0,0 +1,133 @@
+#ifndef _GR4_PACKET_MODEM_WORKER_POOL
+#define _GR4_PACKET_MODEM_WORKER_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gr::packet_modem {
+
+// Pool of worker threads used by blocks to split their work among several
+// CPUs.
+//
+// The run() function executes a number of independent tasks and returns when
+// all of them have finished. The calling thread also executes tasks, so a pool
+// with num_threads threads of parallelism spawns num_threads - 1 workers. The
+// workers sleep on a condition variable when there is no work.
+class WorkerPool
+{
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _cv_work;
+    std::condition_variable _cv_done;
+    bool _stop = false;
+    // incremented each time that run() submits work
+    uint64_t _generation = 0;
+    // number of workers that have not finished the current generation
+    size_t _busy = 0;
+    std::function<void(size_t)> _task;
+    size_t _num_tasks = 0;
+    std::atomic<size_t> _next_task;
+
+    void execute_tasks()
+    {
+        size_t task;
+        while ((task = _next_task.fetch_add(1, std::memory_order::relaxed)) <
+               _num_tasks) {
+            _task(task);
+        }
+    }
+
+    void worker(uint64_t generation)
+    {
+        while (true) {
+            {
+                std::unique_lock lock(_mutex);
+                _cv_work.wait(lock, [this, generation]() {
+                    return _stop || _generation != generation;
+                });
+                if (_stop) {
+                    return;
+                }
+                generation = _generation;
+            }
+            execute_tasks();
+            {
+                std::lock_guard lock(_mutex);
+                if (--_busy == 0) {
+                    _cv_done.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() { stop(); }
+
+    // Starts the pool with num_threads threads of parallelism (including the
+    // thread that calls run()).
+    void start(size_t num_threads)
+    {
+        stop();
+        _stop = false;
+        for (size_t j = 1; j < num_threads; ++j) {
+            _threads.emplace_back(
+                [this, generation = _generation]() { worker(generation); });
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stop = true;
+        }
+        _cv_work.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+        _threads.clear();
+    }
+
+    size_t num_threads() const noexcept { return _threads.size() + 1; }
+
+    // Runs task(0), task(1), ..., task(num_tasks - 1) in parallel. The tasks
+    // must not throw exceptions.
+    template <typename F>
+    void run(size_t num_tasks, F&& task)
+    {
+        if (_threads.empty() || num_tasks <= 1) {
+            for (size_t j = 0; j < num_tasks; ++j) {
+                task(j);
+            }
+            return;
+        }
+        {
+            std::lock_guard lock(_mutex);
+            _task = std::ref(task);
+            _num_tasks = num_tasks;
+            _next_task.store(0, std::memory_order::relaxed);
+            _busy = _threads.size();
+            ++_generation;
+        }
+        _cv_work.notify_all();
+        execute_tasks();
+        std::unique_lock lock(_mutex);
+        _cv_done.wait(lock, [this]() { return _busy == 0; });
+        _task = nullptr;
+    }
+};
+
+} // namespace gr::packet_modem
+
+#endif // _GR4_PACKET_MODEM_WORKER_POOL
@@ -89,8 +89,8 @@ int main(int argc, char** argv)
               fg.connect<"out">(noise_source).to<"in1">(add_noise)));
     expect(
         eq(gr::ConnectionResult::SUCCESS, fg.connect<"out">(add_noise).to<"in">(head)));
-    expect(eq(gr::ConnectionResult::SUCCESS,
-              fg.connect<"out">(head).to<"in">(*packet_receiver.syncword_detection)));
+    expect(
+        eq(gr::ConnectionResult::SUCCESS, packet_receiver.connect_input(fg, head)));
     expect(eq(gr::ConnectionResult::SUCCESS,
               fg.connect<"out">(*packet_receiver.payload_crc_check).to<"in">(file_sink)));
     expect(
@@ -35,8 +35,11 @@ void register_constellation_llr_decoder();
 void register_costas_loop();
 void register_crc_append();
 void register_crc_check();
+void register_feedforward_phase_estimator();
 void register_file_sink();
 void register_file_source();
+void register_fused_front_end();
+void register_fused_symbol_decoder();
 void register_glfsr_source();
 void register_head();
 void register_header_fec_decoder();
@@ -94,8 +97,11 @@ void register_blocks()
     register_costas_loop();
     register_crc_append();
     register_crc_check();
+    register_feedforward_phase_estimator();
     register_file_sink();
     register_file_source();
+    register_fused_front_end();
+    register_fused_symbol_decoder();
     register_glfsr_source();
     register_head();
     register_header_fec_decoder();
@@ -0,0 +1,9 @@
+#include <gnuradio-4.0/packet-modem/feedforward_phase_estimator.hpp>
+
+#include "register_helpers.hpp"
+
+void register_feedforward_phase_estimator()
+{
+    using namespace gr::packet_modem;
+    register_all_float_types<FeedforwardPhaseEstimator>();
+}
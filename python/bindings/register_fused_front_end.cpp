@@ -0,0 +1,9 @@
+#include <gnuradio-4.0/packet-modem/fused_front_end.hpp>
+
+#include "register_helpers.hpp"
+
+void register_fused_front_end()
+{
+    using namespace gr::packet_modem;
+    register_all_float_types<FusedFrontEnd>();
+}
@@ -0,0 +1,9 @@
+#include <gnuradio-4.0/packet-modem/fused_symbol_decoder.hpp>
+
+#include "register_helpers.hpp"
+
+void register_fused_symbol_decoder()
+{
+    using namespace gr::packet_modem;
+    register_all_float_types<FusedSymbolDecoder>();
+}
@@ -6,5 +6,5 @@ void register_syncword_detection()
 {
     using namespace gr::packet_modem;
     auto& reg = gr::globalBlockRegistry();
-    reg.addBlockType<SyncwordDetection>("gr::packet_modem::SyncwordDetection", "");
+    reg.addBlockType<SyncwordDetection<>>("gr::packet_modem::SyncwordDetection", "");
 }
@@ -5,6 +5,8 @@
 #include <gnuradio-4.0/packet-modem/vector_sink.hpp>
 #include <gnuradio-4.0/packet-modem/vector_source.hpp>
 #include <boost/ut.hpp>
+#include <cmath>
+#include <complex>
 #include <numbers>
 #include <random>
 
@@ -63,6 +65,39 @@ boost::ut::suite CostasLoopTests = [] {
         }
         expect(sink.tags().empty());
     } | std::vector<std::string>{ "PILOT", "BPSK", "QPSK" };
+
+    "costas_loop_reproducible"_test = [](auto constellation) {
+        // running the same input twice gives bit-for-bit identical outputs
+        using c64 = std::complex<float>;
+        std::vector<c64> v;
+        std::default_random_engine e(0);
+        std::normal_distribution<float> dist(0.0f, 0.1f);
+        double phase = 0.0;
+        for (size_t j = 0; j < 100000; ++j) {
+            const c64 z = j % 3 == 0 ? c64{ -1.0f, 0.0f } : c64{ 1.0f, 0.0f };
+            v.push_back(z * std::polar(1.0f, static_cast<float>(phase)) +
+                        c64{ dist(e), dist(e) });
+            phase = std::remainder(phase + 0.003, 2.0 * std::numbers::pi);
+        }
+        std::vector<std::vector<c64>> outputs;
+        for (int run = 0; run < 2; ++run) {
+            Graph fg;
+            auto& source = fg.emplaceBlock<VectorSource<c64>>();
+            source.data = v;
+            auto& costas =
+                fg.emplaceBlock<CostasLoop<>>({ { "constellation", constellation } });
+            auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+            expect(eq(ConnectionResult::SUCCESS,
+                      fg.connect<"out">(source).to<"in">(costas)));
+            expect(
+                eq(ConnectionResult::SUCCESS, fg.connect(costas, "out"s, sink, "in"s)));
+            scheduler::Simple sched{ std::move(fg) };
+            expect(sched.runAndWait().has_value());
+            outputs.push_back(sink.data());
+        }
+        expect(eq(outputs[0].size(), v.size()));
+        expect(outputs[0] == outputs[1]);
+    } | std::vector<std::string>{ "PILOT", "BPSK", "QPSK" };
 };
 
 int main() {}
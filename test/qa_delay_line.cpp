@@ -0,0 +1,120 @@
+#include <gnuradio-4.0/packet-modem/delay_line.hpp>
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <complex>
+#include <numeric>
+#include <span>
+#include <vector>
+
+boost::ut::suite DelayLineTests = [] {
+    using namespace boost::ut;
+    using namespace gr::packet_modem;
+
+    "delay_line_window"_test = [](size_t size) {
+        DelayLine<float> delay_line(size);
+        expect(eq(delay_line.size(), size));
+        for (size_t j = 0; j < size; ++j) {
+            expect(eq(delay_line.window()[j], 0.0f));
+        }
+        // push enough items to move the buffer contents several times, mixing
+        // single items and bulk pushes
+        std::vector<float> v(10000);
+        std::iota(v.begin(), v.end(), 1.0f);
+        size_t pushed = 0;
+        for (size_t chunk = 1; pushed + chunk <= v.size(); chunk = (chunk * 7) % 3001) {
+            if (chunk == 1) {
+                delay_line.push_back(v[pushed]);
+            } else {
+                delay_line.push_back_bulk(std::span(v).subspan(pushed, chunk));
+            }
+            pushed += chunk;
+            const float* window = delay_line.window();
+            for (size_t j = 0; j < size; ++j) {
+                const float expected =
+                    pushed + j >= size ? v[pushed + j - size] : 0.0f;
+                expect(eq(window[j], expected));
+                expect(eq(delay_line[size - 1 - j], expected));
+            }
+        }
+    } | std::vector<size_t>{ 1U, 2U, 11U, 64U, 1500U };
+
+    "delay_line_window_delay"_test = [] {
+        // after a bulk push of at most block_size items, the windows that end
+        // at any of them are available
+        const size_t size = 7;
+        DelayLine<float> delay_line(size);
+        std::vector<float> v(10 * DelayLine<float>::block_size);
+        std::iota(v.begin(), v.end(), 1.0f);
+        size_t pushed = 0;
+        for (size_t chunk = 1; pushed + chunk <= v.size(); chunk = (chunk * 5) % 1021) {
+            delay_line.push_back_bulk(std::span(v).subspan(pushed, chunk));
+            pushed += chunk;
+            for (size_t delay = 0; delay <= chunk; ++delay) {
+                const float* window = delay_line.window(delay);
+                for (size_t j = 0; j < size; ++j) {
+                    const size_t index = pushed + j - delay;
+                    expect(eq(window[j], index >= size ? v[index - size] : 0.0f));
+                }
+            }
+        }
+    };
+
+    "delay_line_append"_test = [] {
+        // the items written to the pointer returned by append() are pushed to
+        // the delay line
+        const size_t size = 13;
+        DelayLine<float> delay_line(size);
+        std::vector<float> v(10 * DelayLine<float>::block_size);
+        std::iota(v.begin(), v.end(), 1.0f);
+        size_t pushed = 0;
+        for (size_t chunk = 1; pushed + chunk <= v.size(); chunk = (chunk * 3) % 1024) {
+            std::copy_n(&v[pushed], chunk, delay_line.append(chunk));
+            pushed += chunk;
+            for (size_t delay = 0; delay <= chunk; ++delay) {
+                const float* window = delay_line.window(delay);
+                for (size_t j = 0; j < size; ++j) {
+                    const size_t index = pushed + j - delay;
+                    expect(eq(window[j], index >= size ? v[index - size] : 0.0f));
+                }
+            }
+        }
+    };
+
+    "delay_line_resize"_test = [] {
+        DelayLine<float> delay_line(4);
+        delay_line.push_back_bulk(std::vector<float>{ 1.0f, 2.0f, 3.0f, 4.0f, 5.0f });
+        delay_line.resize(6);
+        const std::vector<float> expected = { 0.0f, 0.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+        expect(std::ranges::equal(std::span(delay_line.window(), 6), expected));
+        delay_line.resize(2);
+        expect(std::ranges::equal(std::span(delay_line.window(), 2),
+                                  std::vector<float>{ 4.0f, 5.0f }));
+        delay_line.reset();
+        expect(std::ranges::equal(std::span(delay_line.window(), 2),
+                                  std::vector<float>{ 0.0f, 0.0f }));
+    };
+
+    "delay_line_dot_product"_test = [] {
+        using c64 = std::complex<float>;
+        const std::vector<float> taps = { 1.0f, -2.0f, 0.5f, 3.0f, 0.25f };
+        const auto arms = reversed_polyphase_arms(taps, 2, 3);
+        expect(eq(arms, std::vector<float>{ 0.25f, 0.5f, 1.0f, 0.0f, 3.0f, -2.0f }));
+        // convolution of the input with the taps of the first arm
+        DelayLine<c64> delay_line(3);
+        std::vector<c64> x(100);
+        for (size_t j = 0; j < x.size(); ++j) {
+            x[j] = c64{ static_cast<float>(j), -static_cast<float>(j * j % 7) };
+        }
+        for (size_t j = 0; j < x.size(); ++j) {
+            delay_line.push_back(x[j]);
+            c64 expected{};
+            for (size_t k = 0; k < 3 && k <= j; ++k) {
+                expected += taps[2 * k] * x[j - k];
+            }
+            const c64 y = delay_line.dot_product<c64>(arms.data());
+            expect(std::abs(y - expected) < 1e-4f);
+        }
+    };
+};
+
+int main() {}
@@ -0,0 +1,86 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/feedforward_phase_estimator.hpp>
+#include <gnuradio-4.0/packet-modem/vector_sink.hpp>
+#include <gnuradio-4.0/packet-modem/vector_source.hpp>
+#include <boost/ut.hpp>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+
+boost::ut::suite FeedforwardPhaseEstimatorTests = [] {
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+    using namespace std::string_literals;
+
+    "feedforward_phase_estimator"_test = [](size_t window_size) {
+        Graph fg;
+        using c64 = std::complex<float>;
+        const size_t syncword_size = 64;
+        const size_t header_size = 128;
+        const std::vector<size_t> payload_sizes = { 300, 77, 1000 };
+        std::vector<c64> v;
+        std::vector<Tag> tags;
+        std::default_random_engine e(0);
+        std::uniform_int_distribution<uint8_t> dist(0, 3);
+        const float a = 1.0f / std::numbers::sqrt2_v<float>;
+        const auto qpsk = [&]() {
+            const uint8_t n = dist(e);
+            return c64{ n % 2 == 0 ? a : -a, n / 2 == 0 ? a : -a };
+        };
+        for (const size_t payload_size : payload_sizes) {
+            // the syncword is a pilot after the syncword wipe-off
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "syncword_amplitude", 1.0f },
+                               { "constellation", "PILOT"s } } });
+            v.insert(v.end(), syncword_size, c64{ 1.0f, 0.0f });
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "constellation", "QPSK"s }, { "header_start", true } } });
+            for (size_t j = 0; j < header_size; ++j) {
+                v.push_back(qpsk());
+            }
+            const auto payload_symbols = static_cast<uint64_t>(payload_size);
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "payload_symbols", payload_symbols } } });
+            for (size_t j = 0; j < payload_size; ++j) {
+                v.push_back(qpsk());
+            }
+        }
+        // phase offset and slow frequency offset
+        const float phase0 = 0.5f;
+        const float freq = 2e-4f;
+        std::vector<c64> rotated(v.size());
+        for (size_t j = 0; j < v.size(); ++j) {
+            rotated[j] = v[j] * std::polar(1.0f, phase0 + freq * static_cast<float>(j));
+        }
+        auto& source = fg.emplaceBlock<VectorSource<c64>>();
+        source.data = rotated;
+        source.tags = tags;
+        auto& estimator = fg.emplaceBlock<FeedforwardPhaseEstimator<>>(
+            { { "window_size", window_size },
+              { "syncword_size", syncword_size },
+              { "header_size", header_size } });
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(source).to<"in">(estimator)));
+        expect(eq(ConnectionResult::SUCCESS, fg.connect(estimator, "out"s, sink, "in"s)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        const auto data = sink.data();
+        expect(eq(data.size(), v.size()));
+        // the phase changes by at most freq * window_size within a window
+        const float tolerance = 2e-2f;
+        for (size_t j = 0; j < v.size(); ++j) {
+            expect(std::abs(data[j] - v[j]) < tolerance);
+        }
+        const auto out_tags = sink.tags();
+        expect(eq(out_tags.size(), tags.size()));
+        for (size_t j = 0; j < tags.size(); ++j) {
+            expect(tags[j] == out_tags[j]);
+        }
+    } | std::vector<size_t>{ 16UZ, 64UZ, 100UZ };
+};
+
+int main() {}
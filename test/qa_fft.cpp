@@ -0,0 +1,105 @@
+#include <gnuradio-4.0/packet-modem/fft.hpp>
+#include <boost/ut.hpp>
+#include <complex>
+#include <filesystem>
+#include <numbers>
+#include <random>
+#include <vector>
+
+boost::ut::suite FftTests = [] {
+    using namespace boost::ut;
+    using namespace gr::packet_modem;
+    using c64 = std::complex<float>;
+
+    const auto random_vector = [](size_t size) {
+        std::default_random_engine e(static_cast<unsigned>(size));
+        std::normal_distribution<float> dist;
+        std::vector<c64> v(size);
+        for (auto& x : v) {
+            x = c64{ dist(e), dist(e) };
+        }
+        return v;
+    };
+
+    const auto dft = [](const std::vector<c64>& x) {
+        const size_t n = x.size();
+        std::vector<c64> y(n);
+        for (size_t k = 0; k < n; ++k) {
+            std::complex<double> acc{};
+            for (size_t j = 0; j < n; ++j) {
+                const double phase = -2.0 * std::numbers::pi *
+                                     static_cast<double>((j * k) % n) /
+                                     static_cast<double>(n);
+                acc += std::complex<double>(x[j]) *
+                       std::complex<double>(std::cos(phase), std::sin(phase));
+            }
+            y[k] = c64(acc);
+        }
+        return y;
+    };
+
+    const auto relative_error = [](const std::vector<c64>& x,
+                                   const std::vector<c64>& y) {
+        double error = 0.0;
+        double norm = 0.0;
+        for (size_t j = 0; j < x.size(); ++j) {
+            error += static_cast<double>(std::norm(x[j] - y[j]));
+            norm += static_cast<double>(std::norm(x[j]));
+        }
+        return norm == 0.0 ? error : std::sqrt(error / norm);
+    };
+
+    "mixed_radix"_test = [&](size_t size) {
+        const auto x = random_vector(size);
+        const auto expected = dft(x);
+        MixedRadixFft fft;
+        fft.init(size);
+        expect(eq(fft.size(), size));
+        std::vector<c64> y(size);
+        fft.execute(x.data(), y.data());
+        expect(relative_error(expected, y) < 1e-6) << "size =" << size;
+        // in-place
+        auto z = x;
+        fft.execute(z.data(), z.data());
+        expect(z == y) << "size =" << size;
+    } | std::vector<size_t>{ 1, 2, 3, 4, 5, 7, 8, 12, 60, 77, 121, 1000, 1536, 2048 };
+
+    "batched"_test = [&](FftBackend backend) {
+        const size_t size = 384;
+        const size_t howmany = 5;
+        const size_t dist = 400;
+        auto x = fftw::allocate<c64>(howmany * dist);
+        auto y = fftw::allocate<c64>(howmany * dist);
+        Fft fft;
+        fft.init(
+            { backend, FftPlanner::ESTIMATE }, size, howmany, dist, x.get(), y.get());
+        expect(eq(fft.size(), size));
+        const auto input = random_vector(howmany * dist);
+        std::ranges::copy(input, x.get());
+        fft.execute(x.get(), y.get());
+        for (size_t row = 0; row < howmany; ++row) {
+            const std::vector<c64> row_in(&input[row * dist],
+                                          &input[row * dist + size]);
+            const std::vector<c64> row_out(&y[row * dist], &y[row * dist + size]);
+            expect(relative_error(dft(row_in), row_out) < 1e-6) << "row =" << row;
+        }
+    } | std::vector<FftBackend>{ FftBackend::FFTW, FftBackend::MIXED_RADIX };
+
+    "wisdom"_test = [] {
+        const auto filename =
+            (std::filesystem::temp_directory_path() / "qa_fft_wisdom").string();
+        std::filesystem::remove(filename);
+        expect(!fftw::import_wisdom(filename));
+        auto x = fftw::allocate<c64>(1024);
+        auto y = fftw::allocate<c64>(1024);
+        Fft fft;
+        fft.init(
+            { FftBackend::FFTW, FftPlanner::MEASURE }, 1024, 1, 1024, x.get(), y.get());
+        fftw::export_wisdom(filename);
+        expect(std::filesystem::exists(filename));
+        expect(fftw::import_wisdom(filename));
+        std::filesystem::remove(filename);
+    };
+};
+
+int main() {}
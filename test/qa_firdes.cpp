@@ -1,6 +1,8 @@
 #include <gnuradio-4.0/packet-modem/firdes.hpp>
 #include <boost/ut.hpp>
 #include <cmath>
+#include <complex>
+#include <numbers>
 
 boost::ut::suite FirdesTests = [] {
     using namespace boost::ut;
@@ -42,6 +44,30 @@ boost::ut::suite FirdesTests = [] {
             expect(std::abs(taps[j] - expected_taps[j]) < tolerance);
         }
     };
+
+    "low_pass"_test = [] {
+        const size_t num_taps = 33;
+        const double cutoff = 0.25;
+        const auto taps = firdes::low_pass(1.0, 1.0, cutoff, num_taps);
+        expect(eq(taps.size(), num_taps));
+        for (size_t j = 0; j < taps.size(); ++j) {
+            expect(std::abs(taps[j] - taps[taps.size() - 1 - j]) < 1e-7f);
+        }
+        const auto response = [&](double freq) {
+            std::complex<double> acc{};
+            for (size_t j = 0; j < taps.size(); ++j) {
+                const double phase =
+                    -2.0 * std::numbers::pi * freq * static_cast<double>(j);
+                acc += static_cast<double>(taps[j]) * std::polar(1.0, phase);
+            }
+            return std::abs(acc);
+        };
+        expect(std::abs(response(0.0) - 1.0) < 1e-6);
+        expect(std::abs(response(cutoff) - 0.5) < 0.01);
+        expect(response(0.1) > 0.99);
+        expect(response(0.35) < 0.01);
+        expect(response(0.5) < 0.01);
+    };
 };
 
 int main() {}
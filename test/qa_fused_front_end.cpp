@@ -0,0 +1,120 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/coarse_frequency_correction.hpp>
+#include <gnuradio-4.0/packet-modem/firdes.hpp>
+#include <gnuradio-4.0/packet-modem/fused_front_end.hpp>
+#include <gnuradio-4.0/packet-modem/symbol_filter.hpp>
+#include <gnuradio-4.0/packet-modem/syncword_wipeoff.hpp>
+#include <gnuradio-4.0/packet-modem/vector_sink.hpp>
+#include <gnuradio-4.0/packet-modem/vector_source.hpp>
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <complex>
+#include <random>
+
+boost::ut::suite FusedFrontEndTests = [] {
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+
+    "fused_front_end"_test = [](size_t delay) {
+        // the output of the Fused Front End is the same as the output of the
+        // Coarse Frequency Correction, Symbol Filter and Syncword Wipe-off
+        // blocks
+        using c64 = std::complex<float>;
+        const size_t samples_per_symbol = 4;
+        const size_t num_arms = 32;
+        const size_t freq_correction_delay = 25;
+        auto taps = firdes::root_raised_cosine(
+            static_cast<double>(num_arms),
+            static_cast<double>(num_arms * samples_per_symbol),
+            1.0,
+            0.35,
+            num_arms * samples_per_symbol * 11U);
+        taps.pop_back();
+        std::default_random_engine e(0);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        std::uniform_real_distribution<float> time_est(-0.5f, 0.5f);
+        std::uniform_real_distribution<double> freq(-0.02, 0.02);
+        std::vector<float> syncword(64);
+        for (auto& x : syncword) {
+            x = noise(e) > 0.0f ? 1.0f : -1.0f;
+        }
+        std::vector<c64> v(200000);
+        for (auto& x : v) {
+            x = c64{ noise(e), noise(e) };
+        }
+        // syncword detections, some of them close together, so that a
+        // syncword_freq tag arrives before the previous one is applied
+        std::vector<Tag> tags;
+        for (size_t position = 1000; position < v.size() - 1000;
+             position += 10 + e() % 5000) {
+            const float t = time_est(e);
+            tags.push_back({ static_cast<ssize_t>(position),
+                             { { "syncword_amplitude", 1.0f + t },
+                               { "syncword_time_est", t },
+                               { "syncword_phase", 0.1f },
+                               { "syncword_freq", freq(e) },
+                               { "position", static_cast<uint64_t>(position) } } });
+        }
+
+        const gr::property_map symbol_filter_settings = {
+            { "taps", taps },
+            { "num_arms", num_arms },
+            { "samples_per_symbol", samples_per_symbol },
+            { "delay", delay }
+        };
+        Graph fg;
+        auto& source = fg.emplaceBlock<VectorSource<c64>>();
+        source.data = v;
+        source.tags = tags;
+        auto& freq_correction = fg.emplaceBlock<CoarseFrequencyCorrection<>>(
+            { { "delay", freq_correction_delay } });
+        auto& symbol_filter =
+            fg.emplaceBlock<SymbolFilter<c64, c64, float>>(symbol_filter_settings);
+        auto& syncword_wipeoff =
+            fg.emplaceBlock<SyncwordWipeoff<>>({ { "syncword", syncword } });
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        auto fused_settings = symbol_filter_settings;
+        fused_settings["freq_correction_delay"] = freq_correction_delay;
+        fused_settings["syncword"] = syncword;
+        auto& fused_source = fg.emplaceBlock<VectorSource<c64>>();
+        fused_source.data = v;
+        fused_source.tags = tags;
+        auto& front_end = fg.emplaceBlock<FusedFrontEnd<>>(fused_settings);
+        auto& fused_sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(source).to<"in">(freq_correction)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(freq_correction).to<"in">(symbol_filter)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(symbol_filter).to<"in">(syncword_wipeoff)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_wipeoff).to<"in">(sink)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(fused_source).to<"in">(front_end)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(front_end).to<"in">(fused_sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+
+        const auto expected = sink.data();
+        const auto data = fused_sink.data();
+        expect(eq(data.size(), expected.size()));
+        // the frequency correction can differ by a small rounding error
+        // depending on how the NCO is split into calls
+        const float tolerance = 1e-3f;
+        for (size_t j = 0; j < std::min(data.size(), expected.size()); ++j) {
+            expect(std::abs(data[j] - expected[j]) <
+                   tolerance * std::max(1.0f, std::abs(expected[j])));
+        }
+        const auto expected_tags = sink.tags();
+        const auto out_tags = fused_sink.tags();
+        expect(eq(out_tags.size(), expected_tags.size()));
+        for (size_t j = 0; j < std::min(out_tags.size(), expected_tags.size()); ++j) {
+            expect(out_tags[j] == expected_tags[j]);
+        }
+    } | std::vector<size_t>{ 43UZ, 44UZ, 45UZ, 46UZ };
+};
+
+int main() {}
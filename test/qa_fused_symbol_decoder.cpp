@@ -0,0 +1,131 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/additive_scrambler.hpp>
+#include <gnuradio-4.0/packet-modem/constellation_llr_decoder.hpp>
+#include <gnuradio-4.0/packet-modem/costas_loop.hpp>
+#include <gnuradio-4.0/packet-modem/fused_symbol_decoder.hpp>
+#include <gnuradio-4.0/packet-modem/syncword_remove.hpp>
+#include <gnuradio-4.0/packet-modem/vector_sink.hpp>
+#include <gnuradio-4.0/packet-modem/vector_source.hpp>
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <random>
+
+boost::ut::suite FusedSymbolDecoderTests = [] {
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+    using namespace std::string_literals;
+
+    "fused_symbol_decoder"_test = [] {
+        // the output of the Fused Symbol Decoder is the same as the output of
+        // the Costas Loop, Syncword Remove, Constellation LLR Decoder and
+        // Additive Scrambler blocks
+        using c64 = std::complex<float>;
+        const size_t syncword_size = 64;
+        const size_t header_size = 128;
+        const std::vector<size_t> payload_sizes = { 300, 77, 1000, 5000, 1 };
+        std::vector<c64> v;
+        std::vector<Tag> tags;
+        std::default_random_engine e(0);
+        std::uniform_int_distribution<uint8_t> dist(0, 3);
+        std::normal_distribution<float> noise(0.0f, 0.2f);
+        const float a = 1.0f / std::numbers::sqrt2_v<float>;
+        float phase = 0.3f;
+        const auto symbol = [&](c64 z) {
+            phase += 1e-4f;
+            return z * std::polar(1.0f, phase) + c64{ noise(e), noise(e) };
+        };
+        for (const size_t payload_size : payload_sizes) {
+            // tags as in the output of the Payload Metadata Insert block
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "syncword_amplitude", 1.0f },
+                               { "syncword_phase", phase + 0.05f },
+                               { "constellation", "PILOT"s },
+                               { "loop_bandwidth", 0.02 } } });
+            for (size_t j = 0; j < syncword_size; ++j) {
+                v.push_back(symbol(c64{ 1.0f, 0.0f }));
+            }
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "constellation", "QPSK"s },
+                               { "header_start", pmtv::pmt_null() },
+                               { "loop_bandwidth", 0.01 } } });
+            const auto payload_symbols = static_cast<uint64_t>(payload_size);
+            for (size_t j = 0; j < header_size; ++j) {
+                const uint8_t n = dist(e);
+                v.push_back(symbol(c64{ n % 2 == 0 ? a : -a, n / 2 == 0 ? a : -a }));
+            }
+            tags.push_back({ static_cast<ssize_t>(v.size()),
+                             { { "payload_symbols", payload_symbols },
+                               { "loop_bandwidth", 0.005 } } });
+            for (size_t j = 0; j < payload_size; ++j) {
+                const uint8_t n = dist(e);
+                v.push_back(symbol(c64{ n % 2 == 0 ? a : -a, n / 2 == 0 ? a : -a }));
+            }
+        }
+
+        Graph fg;
+        auto& source = fg.emplaceBlock<VectorSource<c64>>();
+        source.data = v;
+        source.tags = tags;
+        auto& costas_loop = fg.emplaceBlock<CostasLoop<>>();
+        auto& syncword_remove = fg.emplaceBlock<SyncwordRemove<>>();
+        auto& constellation_decoder = fg.emplaceBlock<ConstellationLLRDecoder<>>(
+            { { "noise_sigma", 0.7f }, { "constellation", "QPSK" } });
+        auto& descrambler = fg.emplaceBlock<AdditiveScrambler<float>>(
+            { { "mask", uint64_t{ 0x4001U } },
+              { "seed", uint64_t{ 0x18E38U } },
+              { "length", uint64_t{ 16U } },
+              { "reset_tag_key", "header_start" } });
+        auto& sink = fg.emplaceBlock<VectorSink<float>>();
+        auto& fused_source = fg.emplaceBlock<VectorSource<c64>>();
+        fused_source.data = v;
+        fused_source.tags = tags;
+        auto& symbol_decoder = fg.emplaceBlock<FusedSymbolDecoder<>>(
+            { { "noise_sigma", 0.7f },
+              { "constellation", "QPSK" },
+              { "scrambler_mask", uint64_t{ 0x4001U } },
+              { "scrambler_seed", uint64_t{ 0x18E38U } },
+              { "scrambler_length", uint64_t{ 16U } },
+              { "scrambler_reset_tag_key", "header_start" } });
+        auto& fused_sink = fg.emplaceBlock<VectorSink<float>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(source).to<"in">(costas_loop)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(costas_loop).to<"in">(syncword_remove)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_remove).to<"in">(constellation_decoder)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(constellation_decoder).to<"in">(descrambler)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(descrambler).to<"in">(sink)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(fused_source).to<"in">(symbol_decoder)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(symbol_decoder).to<"in">(fused_sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+
+        const auto expected = sink.data();
+        const auto data = fused_sink.data();
+        expect(eq(data.size(), 2 * (v.size() - payload_sizes.size() * syncword_size)));
+        expect(eq(data.size(), expected.size()));
+        const float tolerance = 1e-4f;
+        for (size_t j = 0; j < std::min(data.size(), expected.size()); ++j) {
+            expect(std::abs(data[j] - expected[j]) <
+                   tolerance * std::max(1.0f, std::abs(expected[j])));
+        }
+        const auto expected_tags = sink.tags();
+        const auto out_tags = fused_sink.tags();
+        expect(eq(out_tags.size(), 2 * payload_sizes.size()));
+        expect(eq(out_tags.size(), expected_tags.size()));
+        for (size_t j = 0; j < std::min(out_tags.size(), expected_tags.size()); ++j) {
+            expect(out_tags[j] == expected_tags[j]);
+        }
+    };
+};
+
+int main() {}
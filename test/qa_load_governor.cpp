@@ -0,0 +1,114 @@
+#include <gnuradio-4.0/Graph.hpp>
+#include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/load_governor.hpp>
+#include <gnuradio-4.0/packet-modem/null_sink.hpp>
+#include <gnuradio-4.0/packet-modem/null_source.hpp>
+#include <gnuradio-4.0/packet-modem/throttle.hpp>
+#include <boost/ut.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Runs the flowgraph for about one second
+void run_for_one_second(gr::Graph&& fg)
+{
+    using namespace boost::ut;
+    using namespace gr;
+
+    scheduler::Simple sched{ std::move(fg) };
+    MsgPortOut toScheduler;
+    expect(eq(ConnectionResult::SUCCESS, toScheduler.connect(sched.msgIn)));
+    std::thread stopper([&toScheduler]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        sendMessage<message::Command::Set>(toScheduler,
+                                           "",
+                                           block::property::kLifeCycleState,
+                                           { { "state", "REQUESTED_STOP" } });
+    });
+    expect(sched.runAndWait().has_value());
+    stopper.join();
+}
+
+} // namespace
+
+boost::ut::suite LoadGovernorTests = [] {
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+
+    const property_map governor_settings = { { "overload_backlog", uint64_t{ 1024 } },
+                                             { "headroom_backlog", uint64_t{ 256 } },
+                                             { "update_time_secs", 0.01 },
+                                             { "hold_time_secs", 0.05 },
+                                             { "num_levels", 2UZ },
+                                             { "drop_chunk", uint64_t{ 1000 } } };
+
+    "overload"_test = [&governor_settings] {
+        // The Throttle after the Load Governor is slower than the source, so
+        // the governor goes through all the levels until it drops samples.
+        Graph fg;
+        auto& source = fg.emplaceBlock<NullSource<int>>();
+        auto& governor = fg.emplaceBlock<LoadGovernor<int>>(governor_settings);
+        std::vector<size_t> levels;
+        governor.level_changed = [&levels](size_t level) { levels.push_back(level); };
+        auto& throttle = fg.emplaceBlock<Throttle<int>>(
+            { { "sample_rate", 100e3 }, { "maximum_items_per_chunk", 100UZ } });
+        auto& sink = fg.emplaceBlock<NullSink<int>>();
+        expect(
+            eq(ConnectionResult::SUCCESS, fg.connect<"out">(source).to<"in">(governor)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(governor).to<"in">(throttle)));
+        expect(eq(ConnectionResult::SUCCESS, fg.connect<"out">(throttle).to<"in">(sink)));
+        run_for_one_second(std::move(fg));
+        expect(eq(governor._level, 3UZ));
+        expect(eq(governor._level_changes, uint64_t{ 3 }));
+        expect(governor._dropped_samples > uint64_t{ 0 });
+        expect(eq(levels, std::vector<size_t>{ 1, 2 }));
+    };
+
+    "packet open"_test = [&governor_settings] {
+        // Same as the overload test, but the receiver is always inside a
+        // packet, so the governor never drops samples
+        Graph fg;
+        auto& source = fg.emplaceBlock<NullSource<int>>();
+        auto& governor = fg.emplaceBlock<LoadGovernor<int>>(governor_settings);
+        governor.packet_open = [] { return true; };
+        auto& throttle = fg.emplaceBlock<Throttle<int>>(
+            { { "sample_rate", 100e3 }, { "maximum_items_per_chunk", 100UZ } });
+        auto& sink = fg.emplaceBlock<NullSink<int>>();
+        expect(
+            eq(ConnectionResult::SUCCESS, fg.connect<"out">(source).to<"in">(governor)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(governor).to<"in">(throttle)));
+        expect(eq(ConnectionResult::SUCCESS, fg.connect<"out">(throttle).to<"in">(sink)));
+        run_for_one_second(std::move(fg));
+        expect(eq(governor._level, 3UZ));
+        expect(eq(governor._dropped_samples, uint64_t{ 0 }));
+    };
+
+    "no overload"_test = [&governor_settings] {
+        // The Throttle before the Load Governor is slower than the sink, so
+        // there is never a backlog.
+        Graph fg;
+        auto& source = fg.emplaceBlock<NullSource<int>>();
+        auto& throttle = fg.emplaceBlock<Throttle<int>>(
+            { { "sample_rate", 100e3 }, { "maximum_items_per_chunk", 100UZ } });
+        auto& governor = fg.emplaceBlock<LoadGovernor<int>>(governor_settings);
+        std::vector<size_t> levels;
+        governor.level_changed = [&levels](size_t level) { levels.push_back(level); };
+        auto& sink = fg.emplaceBlock<NullSink<int>>();
+        expect(
+            eq(ConnectionResult::SUCCESS, fg.connect<"out">(source).to<"in">(throttle)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(throttle).to<"in">(governor)));
+        expect(eq(ConnectionResult::SUCCESS, fg.connect<"out">(governor).to<"in">(sink)));
+        run_for_one_second(std::move(fg));
+        expect(eq(governor._level, 0UZ));
+        expect(eq(governor._level_changes, uint64_t{ 0 }));
+        expect(eq(governor._dropped_samples, uint64_t{ 0 }));
+        expect(levels.empty());
+    };
+};
+
+int main() {}
@@ -96,8 +96,7 @@ boost::ut::suite LoopbackTests = [] {
             expect(eq(ConnectionResult::SUCCESS,
                       fg.connect<"out">(noise_source).to<"in1">(add_noise)));
             expect(eq(ConnectionResult::SUCCESS,
-                      fg.connect<"out">(add_noise).to<"in">(
-                          *packet_receiver.syncword_detection)));
+                      packet_receiver.connect_input(fg, add_noise)));
             expect(
                 eq(ConnectionResult::SUCCESS,
                    fg.connect<"out">(*packet_receiver.payload_crc_check).to<"in">(sink)));
@@ -0,0 +1,84 @@
+#include <gnuradio-4.0/packet-modem/nco.hpp>
+#include <boost/ut.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+boost::ut::suite NcoTests = [] {
+    using namespace boost::ut;
+    using namespace gr::packet_modem;
+    using c64 = std::complex<float>;
+
+    "nco_rotate"_test = [](double phase_incr) {
+        // rotating in chunks of random sizes, some of them not multiples of
+        // the number of lanes, gives the same phases as a single rotation
+        const size_t num_items = 100000;
+        const double phase = 0.3;
+        std::vector<c64> x(num_items);
+        std::default_random_engine e(0);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        for (auto& z : x) {
+            z = c64{ dist(e), dist(e) };
+        }
+        Nco<float> nco(phase, phase_incr);
+        std::vector<c64> y(num_items);
+        std::uniform_int_distribution<size_t> chunk_dist(0, 50);
+        size_t pos = 0;
+        while (pos < num_items) {
+            const size_t chunk = std::min(chunk_dist(e), num_items - pos);
+            nco.rotate(&x[pos], &y[pos], chunk);
+            pos += chunk;
+        }
+        for (size_t j = 0; j < num_items; ++j) {
+            const auto expected =
+                std::complex<double>(x[j]) *
+                std::polar(1.0, phase + static_cast<double>(j) * phase_incr);
+            const double tolerance = 5e-4 * std::max(1.0, std::abs(expected));
+            expect(std::abs(std::complex<double>(y[j]) - expected) < tolerance);
+        }
+        expect(std::abs(std::abs(nco.phasor()) - 1.0f) < 1e-5f);
+    } | std::vector<double>{ 0.0, 0.01, -0.1, 1.0, 3.0 };
+
+    "nco_short_chunks"_test = [] {
+        // a long stream rotated only in chunks shorter than the number of
+        // lanes keeps unit amplitude
+        Nco<float> nco(0.3, 0.3);
+        std::vector<c64> x(7, c64{ 1.0f, 0.0f });
+        std::vector<c64> y(7);
+        float max_error = 0.0f;
+        for (size_t j = 0; j < 1000000; ++j) {
+            const size_t chunk = 1 + j % 7;
+            nco.rotate(x.data(), y.data(), chunk);
+            for (size_t k = 0; k < chunk; ++k) {
+                max_error = std::max(max_error, std::abs(std::abs(y[k]) - 1.0f));
+            }
+        }
+        expect(max_error < 1e-5f);
+        expect(std::abs(std::abs(nco.phasor()) - 1.0f) < 1e-5f);
+    };
+
+    "nco_in_place"_test = [] {
+        std::vector<c64> x(1000, c64{ 1.0f, 0.0f });
+        Nco<float> nco(0.0, 0.05);
+        nco.rotate(x.data(), x.data(), x.size());
+        for (size_t j = 0; j < x.size(); ++j) {
+            const auto expected = std::polar(1.0f, 0.05f * static_cast<float>(j));
+            expect(std::abs(x[j] - expected) < 1e-4f);
+        }
+    };
+
+    "nco_set_phase_incr"_test = [] {
+        // changing the phase increment keeps the phase of the next sample
+        Nco<double> nco(0.0, 0.01);
+        std::vector<std::complex<double>> x(13, { 1.0, 0.0 });
+        nco.rotate(x.data(), x.data(), x.size());
+        expect(std::abs(std::arg(nco.phasor()) - 0.13) < 1e-12);
+        nco.set_phase_incr(-0.02);
+        nco.rotate(x.data(), x.data(), 5);
+        expect(std::abs(std::arg(nco.phasor()) - 0.03) < 1e-12);
+    };
+};
+
+int main() {}
@@ -7,6 +7,8 @@
 #include <boost/ut.hpp>
 #include <complex>
 #include <numbers>
+#include <utility>
+#include <vector>
 
 boost::ut::suite PfbArbResamplerTests = [] {
     using namespace boost::ut;
@@ -68,6 +70,67 @@ boost::ut::suite PfbArbResamplerTests = [] {
             }
         }
     };
+
+    "pfb_arb_resampler_rational"_test = [](std::pair<size_t, size_t> ratio) {
+        const auto [interpolation, decimation] = ratio;
+        using c64 = std::complex<float>;
+        const size_t num_items = 100000;
+        const double freq = 0.01;
+        std::vector<c64> v(num_items);
+        for (size_t j = 0; j < num_items; ++j) {
+            v[j] = std::polar(1.0f, static_cast<float>(std::remainder(
+                                        freq * static_cast<double>(j),
+                                        2 * std::numbers::pi)));
+        }
+        const double resampling_rate =
+            static_cast<double>(interpolation) / static_cast<double>(decimation);
+        // the ratio is given by the interpolation and decimation parameters,
+        // or detected from the rate
+        std::vector<std::vector<c64>> outputs;
+        for (const bool detect : { false, true }) {
+            Graph fg;
+            auto& source = fg.emplaceBlock<VectorSource<c64>>();
+            source.data = v;
+            property_map settings = { { "taps", pfb_arb_taps } };
+            if (detect) {
+                settings["rate"] = static_cast<float>(resampling_rate);
+                settings["detect_rational"] = true;
+            } else {
+                settings["interpolation"] = interpolation;
+                settings["decimation"] = decimation;
+            }
+            using Resampler = gr::packet_modem::PfbArbResampler<c64, c64, float>;
+            auto& resampler = fg.emplaceBlock<Resampler>(settings);
+            auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+            expect(eq(ConnectionResult::SUCCESS,
+                      fg.connect<"out">(source).to<"in">(resampler)));
+            expect(eq(ConnectionResult::SUCCESS,
+                      fg.connect<"out">(resampler).to<"in">(sink)));
+            scheduler::Simple sched{ std::move(fg) };
+            expect(sched.runAndWait().has_value());
+            expect(resampler._rational);
+            outputs.push_back(sink.data());
+        }
+        expect(outputs[0] == outputs[1]);
+
+        const auto& data = outputs[0];
+        const size_t expected_data_size = num_items * interpolation / decimation;
+        expect(data.size() <= expected_data_size + 5);
+        expect(expected_data_size <= data.size() + 5);
+        // the phase of the output tone does not drift, so it can be compared
+        // with the expected phase over the whole output
+        const double out_freq = freq / resampling_rate;
+        const float tolerance = 3e-3f;
+        const size_t start = 1000;
+        const double phase0 = static_cast<double>(std::arg(data[start]));
+        for (size_t j = start + 1; j < data.size(); ++j) {
+            const double phase =
+                phase0 + out_freq * static_cast<double>(j - start);
+            const c64 expected = std::polar(
+                1.0f, static_cast<float>(std::remainder(phase, 2 * std::numbers::pi)));
+            expect(std::abs(data[j] - expected) < tolerance);
+        }
+    } | std::vector<std::pair<size_t, size_t>>{ { 3, 4 }, { 3, 2 }, { 1, 1 }, { 5, 3 } };
 };
 
 int main() {}
@@ -0,0 +1,53 @@
+#include <gnuradio-4.0/packet-modem/sincos.hpp>
+#include <boost/ut.hpp>
+#include <cmath>
+#include <numbers>
+
+boost::ut::suite SincosTests = [] {
+    using namespace boost::ut;
+    using namespace gr::packet_modem;
+
+    "fast_expj_float"_test = [] {
+        const int num_points = 1000000;
+        const double range = 2.0 * std::numbers::pi;
+        double max_error = 0.0;
+        for (int j = -num_points; j <= num_points; ++j) {
+            const auto x = static_cast<float>(range * j / num_points);
+            const auto z = fast_expj(x);
+            const auto xd = static_cast<double>(x);
+            max_error = std::max(
+                max_error, std::abs(static_cast<double>(z.real()) - std::cos(xd)));
+            max_error = std::max(
+                max_error, std::abs(static_cast<double>(z.imag()) - std::sin(xd)));
+        }
+        expect(max_error < 2e-7);
+    };
+
+    "fast_expj_double"_test = [] {
+        const int num_points = 1000000;
+        const double range = 2.0 * std::numbers::pi;
+        double max_error = 0.0;
+        for (int j = -num_points; j <= num_points; ++j) {
+            const double x = range * j / num_points;
+            const auto z = fast_expj(x);
+            max_error = std::max(max_error, std::abs(z.real() - std::cos(x)));
+            max_error = std::max(max_error, std::abs(z.imag() - std::sin(x)));
+        }
+        expect(max_error < 1e-15);
+    };
+
+    "fast_expj_quadrants"_test = [] {
+        // exact multiples of pi/2 land in the expected quadrant
+        const float half_pi = std::numbers::pi_v<float> / 2.0f;
+        const float expected_cos[] = { 1.0f, 0.0f, -1.0f, 0.0f };
+        const float expected_sin[] = { 0.0f, 1.0f, 0.0f, -1.0f };
+        for (int n = -8; n <= 8; ++n) {
+            const auto z = fast_expj(static_cast<float>(n) * half_pi);
+            const int quadrant = ((n % 4) + 4) % 4;
+            expect(std::abs(z.real() - expected_cos[quadrant]) < 1e-6f);
+            expect(std::abs(z.imag() - expected_sin[quadrant]) < 1e-6f);
+        }
+    };
+};
+
+int main() {}
@@ -8,6 +8,7 @@
 #include <gnuradio-4.0/packet-modem/vector_sink.hpp>
 #include <gnuradio-4.0/packet-modem/vector_source.hpp>
 #include <boost/ut.hpp>
+#include <numeric>
 
 boost::ut::suite SymbolFilterTests = [] {
     using namespace boost::ut;
@@ -61,6 +62,50 @@ boost::ut::suite SymbolFilterTests = [] {
             expect(std::abs(std::abs(x) - expected_amplitude) < tolerance);
         }
     };
+
+    "symbol_filter_unaligned_tags"_test = [] {
+        // The tags are not aligned to the symbol boundaries. Each of them
+        // should go on the output symbol nearest to it.
+        Graph fg;
+        const size_t samples_per_symbol = 4U;
+        const size_t num_items = 10000U;
+        std::vector<float> v(num_items);
+        std::iota(v.begin(), v.end(), 0.0f);
+        const std::vector<ssize_t> tag_indices = {
+            1, 6, 13, 102, 1001, 4095, 5000, 9997
+        };
+        std::vector<Tag> tags;
+        for (const auto index : tag_indices) {
+            tags.emplace_back(index, property_map{ { "index", index } });
+        }
+        auto& source = fg.emplaceBlock<VectorSource<float>>();
+        source.data = v;
+        source.tags = tags;
+        auto& symbol_filter = fg.emplaceBlock<SymbolFilter<float, float, float>>(
+            { { "taps", std::vector<float>{ 1.0f } },
+              { "num_arms", 1UZ },
+              { "samples_per_symbol", samples_per_symbol },
+              { "delay", 0UZ } });
+        auto& sink = fg.emplaceBlock<VectorSink<float>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(source).to<"in">(symbol_filter)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(symbol_filter).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        const auto data = sink.data();
+        expect(eq(data.size(), num_items / samples_per_symbol));
+        for (size_t j = 0; j < data.size(); ++j) {
+            expect(eq(data[j], v[j * samples_per_symbol]));
+        }
+        const auto out_tags = sink.tags();
+        expect(eq(out_tags.size(), tags.size()));
+        for (size_t j = 0; j < std::min(tags.size(), out_tags.size()); ++j) {
+            const auto sps = static_cast<ssize_t>(samples_per_symbol);
+            expect(eq(out_tags[j].index, (tag_indices[j] + sps / 2) / sps));
+            expect(out_tags[j].map == tags[j].map);
+        }
+    };
 };
 
 int main() {}
@@ -1,5 +1,6 @@
 #include <gnuradio-4.0/Graph.hpp>
 #include <gnuradio-4.0/Scheduler.hpp>
+#include <gnuradio-4.0/packet-modem/add.hpp>
 #include <gnuradio-4.0/packet-modem/firdes.hpp>
 #include <gnuradio-4.0/packet-modem/interpolating_fir_filter.hpp>
 #include <gnuradio-4.0/packet-modem/mapper.hpp>
@@ -9,16 +10,133 @@
 #include <gnuradio-4.0/packet-modem/vector_sink.hpp>
 #include <gnuradio-4.0/packet-modem/vector_source.hpp>
 #include <boost/ut.hpp>
+#include <algorithm>
 #include <complex>
+#include <filesystem>
+#include <fstream>
 #include <numbers>
 #include <random>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using c64 = std::complex<float>;
+using Modulator = gr::packet_modem::InterpolatingFirFilter<c64, c64, float>;
+
+constexpr size_t samples_per_symbol = 4;
+
+const std::vector<uint8_t> test_syncword = { 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 0, 0, 0,
+                                             1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 0, 1, 1,
+                                             0, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 1, 1,
+                                             1, 0, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 1,
+                                             0, 1, 0, 1, 1, 0, 1, 1, 0, 0, 0, 0 };
+
+const std::vector<c64> bpsk_constellation = { { 1.0f, 0.0f }, { -1.0f, 0.0f } };
+
+// RRC taps normalized to unity RMS norm
+std::vector<float> rrc_taps()
+{
+    auto taps = gr::packet_modem::firdes::root_raised_cosine(
+        1.0, static_cast<double>(samples_per_symbol), 1.0, 0.35, 44U);
+    float norm = 0.0f;
+    for (auto x : taps) {
+        norm += x * x;
+    }
+    norm = std::sqrt(norm);
+    for (auto& x : taps) {
+        x /= norm;
+    }
+    return taps;
+}
+
+// Random BPSK symbols
+std::vector<uint8_t> random_symbols(size_t num_symbols, std::default_random_engine& e)
+{
+    std::uniform_int_distribution<uint8_t> dist(0, 1);
+    std::vector<uint8_t> symbols(num_symbols);
+    for (auto& symbol : symbols) {
+        symbol = dist(e);
+    }
+    return symbols;
+}
+
+// Random BPSK symbols with test_syncword at each of the locations
+std::vector<uint8_t> symbols_with_syncwords(size_t num_symbols,
+                                            const std::vector<size_t>& locations,
+                                            std::default_random_engine& e)
+{
+    auto symbols = random_symbols(num_symbols, e);
+    for (const size_t loc : locations) {
+        std::ranges::copy(test_syncword, &symbols[loc]);
+    }
+    return symbols;
+}
+
+// Complex AWGN with a standard deviation of sigma in each component
+std::vector<c64> awgn(size_t num_samples, float sigma, std::default_random_engine& e)
+{
+    std::normal_distribution<float> noise_dist(0.0f, sigma);
+    std::vector<c64> noise(num_samples);
+    for (auto& z : noise) {
+        z = c64{ noise_dist(e), noise_dist(e) };
+    }
+    return noise;
+}
+
+// Adds to the flowgraph a source of the symbols, mapped with the map and
+// pulse shaped with rrc_taps(), and returns the pulse shaping filter
+Modulator& add_modulator(gr::Graph& fg,
+                         std::vector<uint8_t> symbols,
+                         const std::vector<c64>& map = bpsk_constellation)
+{
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+
+    auto& source = fg.emplaceBlock<VectorSource<uint8_t>>();
+    source.data = std::move(symbols);
+    auto& mapper = fg.emplaceBlock<Mapper<uint8_t, c64>>({ { "map", map } });
+    auto& rrc_interp = fg.emplaceBlock<Modulator>(
+        { { "interpolation", samples_per_symbol }, { "taps", rrc_taps() } });
+    expect(eq(ConnectionResult::SUCCESS, fg.connect<"out">(source).to<"in">(mapper)));
+    expect(
+        eq(ConnectionResult::SUCCESS, fg.connect<"out">(mapper).to<"in">(rrc_interp)));
+    return rrc_interp;
+}
+
+// Adds the noise to the output of the modulator and returns the adder
+gr::packet_modem::Add<c64>&
+add_noise(gr::Graph& fg, Modulator& modulator, std::vector<c64> noise)
+{
+    using namespace boost::ut;
+    using namespace gr;
+    using namespace gr::packet_modem;
+
+    auto& noise_source = fg.emplaceBlock<VectorSource<c64>>();
+    noise_source.data = std::move(noise);
+    auto& add = fg.emplaceBlock<Add<c64>>();
+    expect(eq(ConnectionResult::SUCCESS, fg.connect<"out">(modulator).to<"in0">(add)));
+    expect(
+        eq(ConnectionResult::SUCCESS, fg.connect<"out">(noise_source).to<"in1">(add)));
+    return add;
+}
+
+} // namespace
 
 boost::ut::suite SyncwordDetectionTests = [] {
     using namespace boost::ut;
     using namespace gr;
     using namespace gr::packet_modem;
 
-    "syncword_detection"_test = [](float freq_error) {
+    using Params = std::tuple<float, std::string, size_t, size_t, std::string>;
+
+    const auto test_syncword_detection = []<typename Detection>(const Params& params) {
+        const auto& [freq_error, search_mode, decimation, num_threads, fft_backend] =
+            params;
         Graph fg;
         using c64 = std::complex<float>;
         const size_t num_symbols = 1000000;
@@ -74,12 +192,18 @@ boost::ut::suite SyncwordDetectionTests = [] {
             { { "interpolation", samples_per_symbol }, { "taps", rrc_taps } });
         auto& rotator = fg.emplaceBlock<gr::packet_modem::Rotator<>>(
             { { "phase_incr", freq_error } });
-        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection>(
+        auto& syncword_detection = fg.emplaceBlock<Detection>(
             { { "rrc_taps", rrc_taps },
               { "syncword", syncword },
               { "constellation", constellation },
               { "min_freq_bin", -4 },
               { "max_freq_bin", 4 },
+              { "search_mode", search_mode },
+              { "decimation", decimation },
+              // keep the same FFT duration regardless of decimation
+              { "fft_size", 2048UZ / decimation },
+              { "num_threads", num_threads },
+              { "fft_backend", fft_backend },
               // set a high power threshold to avoid false detections
               { "power_threshold", 20.0f } });
         auto& sink_input = fg.emplaceBlock<VectorSink<c64>>();
@@ -104,7 +228,7 @@ boost::ut::suite SyncwordDetectionTests = [] {
         expect(eq(data_in.size(), samples_per_symbol * num_symbols));
         const auto data_out = sink_output.data();
         expect(data_out.size() <= data_in.size());
-        expect(data_out.size() + syncword_detection.fft_size > data_in.size());
+        expect(data_out.size() + syncword_detection.in.min_samples > data_in.size());
         for (size_t j = 0; j < delay; ++j) {
             expect(eq(data_out[j], c64{ 0.0f, 0.0f }));
         }
@@ -148,7 +272,539 @@ boost::ut::suite SyncwordDetectionTests = [] {
         for (const auto& tag : tags) {
             fmt::println("tag {} {}", tag.index, tag.map);
         }
-    } | std::vector<float>{ 0.0f, 0.005f, 0.015f, -0.005f, -0.015f };
+    };
+
+    "syncword_detection"_test = [&](const Params& params) {
+        test_syncword_detection.template operator()<SyncwordDetection<>>(params);
+    } | std::vector<Params>{
+        { 0.0f, "FULL", 1, 1, "FFTW" },           { 0.005f, "FULL", 1, 1, "FFTW" },
+        { 0.015f, "FULL", 1, 1, "FFTW" },         { -0.005f, "FULL", 1, 1, "FFTW" },
+        { -0.015f, "FULL", 1, 1, "FFTW" },        { 0.0f, "TWO_STAGE", 1, 1, "FFTW" },
+        { 0.005f, "TWO_STAGE", 1, 1, "FFTW" },    { 0.015f, "TWO_STAGE", 1, 1, "FFTW" },
+        { -0.005f, "TWO_STAGE", 1, 1, "FFTW" },   { -0.015f, "TWO_STAGE", 1, 1, "FFTW" },
+        { 0.0f, "FULL", 2, 1, "FFTW" },           { 0.005f, "FULL", 2, 1, "FFTW" },
+        { 0.015f, "FULL", 2, 1, "FFTW" },         { -0.005f, "FULL", 2, 1, "FFTW" },
+        { -0.015f, "FULL", 2, 1, "FFTW" },        { 0.0f, "TWO_STAGE", 2, 1, "FFTW" },
+        { -0.015f, "TWO_STAGE", 2, 1, "FFTW" },   { 0.005f, "FULL", 1, 4, "FFTW" },
+        { -0.015f, "FULL", 1, 3, "FFTW" },        { 0.015f, "FULL", 2, 4, "FFTW" },
+        { 0.005f, "FULL", 1, 1, "MIXED_RADIX" },
+        { -0.015f, "TWO_STAGE", 2, 1, "MIXED_RADIX" }
+    };
+
+    // variant specialised for the parameters used in the test
+    "syncword_detection_fixed"_test = [&](const Params& params) {
+        test_syncword_detection.template operator()<SyncwordDetection<2048, 9, 4>>(
+            params);
+    } | std::vector<Params>{
+        { 0.0f, "FULL", 1, 1, "FFTW" },           { 0.015f, "FULL", 1, 1, "FFTW" },
+        { -0.005f, "TWO_STAGE", 1, 1, "FFTW" },   { -0.015f, "FULL", 1, 3, "FFTW" },
+        { 0.005f, "FULL", 1, 1, "MIXED_RADIX" }
+    };
+
+    "causal_detection"_test = [](const std::string& search_mode) {
+        Graph fg;
+        const size_t num_symbols = 100000;
+        std::default_random_engine e(2468);
+        const std::vector<size_t> syncword_locations = { 100,   1250,  10000, 13721,
+                                                         43124, 58000, 91000 };
+        auto symbols = symbols_with_syncwords(num_symbols, syncword_locations, e);
+        auto noise = awgn(samples_per_symbol * num_symbols, 0.5f, e);
+        auto& modulator = add_modulator(fg, std::move(symbols));
+        auto& add = add_noise(fg, modulator, std::move(noise));
+        const uint64_t causal_lookahead = 32;
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", test_syncword },
+              { "constellation", bpsk_constellation },
+              { "min_freq_bin", -4 },
+              { "max_freq_bin", 4 },
+              { "search_mode", search_mode },
+              { "detection_mode", "CAUSAL" },
+              { "causal_lookahead", causal_lookahead } });
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(add).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        // the output is only delayed by the lookahead
+        const size_t delay = causal_lookahead + 1;
+        expect(eq(syncword_detection._output_delay, delay));
+        const auto tags = sink.tags();
+        expect(eq(syncword_detection._num_detections, tags.size()));
+        // the causal decision trades a few false alarms on the random data
+        // for the shorter delay, but all the syncwords must be detected
+        expect(tags.size() >= syncword_locations.size());
+        expect(tags.size() <= syncword_locations.size() + 2U);
+        for (const size_t loc : syncword_locations) {
+            const auto tag = std::ranges::find_if(tags, [&](const auto& t) {
+                return static_cast<size_t>(t.index) == delay + samples_per_symbol * loc;
+            });
+            expect(tag != tags.end()) << "location =" << loc;
+            if (tag != tags.end()) {
+                const auto syncword_amplitude =
+                    pmtv::cast<float>(tag->map.at("syncword_amplitude"));
+                expect(syncword_amplitude < 1.2f);
+                expect(syncword_amplitude > 0.8f);
+            }
+        }
+    } | std::vector<std::string>{ "FULL", "TWO_STAGE" };
+
+    "fft_size_auto"_test = [] {
+        const auto cache_file =
+            (std::filesystem::temp_directory_path() / "qa_syncword_detection.fft_size")
+                .string();
+        std::filesystem::remove(cache_file);
+        const syncword_detection::FftSizeKey key{
+            300, 9, 1, 1, { FftBackend::MIXED_RADIX, FftPlanner::ESTIMATE }
+        };
+        const auto candidates = syncword_detection::fft_size_candidates(
+            key.template_size, key.fft_config.backend);
+        // 1280 = 5 * 2^8 is a candidate, but 1792 = 7 * 2^8 is not, since
+        // MIXED_RADIX has no radix-7 stage
+        expect(std::ranges::contains(candidates, 1280UZ));
+        expect(!std::ranges::contains(candidates, 1792UZ));
+        const auto [size, cached] = syncword_detection::tune_fft_size(key, cache_file);
+        expect(!cached);
+        expect(std::ranges::contains(candidates, size));
+        expect(std::filesystem::exists(cache_file));
+        // the second time the result is cached
+        const auto [cached_size, second_cached] =
+            syncword_detection::tune_fft_size(key, cache_file);
+        expect(second_cached);
+        expect(eq(cached_size, size));
+        std::filesystem::remove(cache_file);
+    };
+
+    "fft_size_cache_invalid"_test = [](const std::string& cached_value) {
+        const auto cache_file = (std::filesystem::temp_directory_path() /
+                                 "qa_syncword_detection_invalid.fft_size")
+                                    .string();
+        // a template size that is not used by other tests, so that the size is
+        // not in the cache kept for the lifetime of the process
+        static size_t template_size = 400;
+        const syncword_detection::FftSizeKey key{
+            ++template_size, 9, 1, 1, { FftBackend::MIXED_RADIX, FftPlanner::ESTIMATE }
+        };
+        {
+            std::ofstream file(cache_file);
+            file << key.to_string() << ' ' << cached_value << '\n';
+        }
+        const auto candidates = syncword_detection::fft_size_candidates(
+            key.template_size, key.fft_config.backend);
+        // the invalid size is measured again instead of being used
+        const auto [size, cached] = syncword_detection::tune_fft_size(key, cache_file);
+        expect(!cached);
+        expect(std::ranges::find(candidates, size) != candidates.end());
+        // and the line is replaced with the measured size
+        std::ifstream file(cache_file);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        expect(eq(lines.size(), 1UZ));
+        expect(lines.size() == 1 &&
+               lines[0] == fmt::format("{} {}", key.to_string(), size));
+        std::filesystem::remove(cache_file);
+    } | std::vector<std::string>{
+        "abc", "", "0", "12", "2048x", "99999999999999999999999"
+    };
+
+    "multiple_syncwords"_test = [](const std::string& search_mode) {
+        Graph fg;
+        const size_t num_symbols = 100000;
+        const size_t num_syncwords = 3;
+        const size_t syncword_length = 64;
+        std::default_random_engine e(12345);
+        auto symbols = random_symbols(num_symbols, e);
+        // random syncwords, one after another
+        const auto syncwords = random_symbols(num_syncwords * syncword_length, e);
+        const std::vector<std::pair<size_t, int>> syncword_locations = {
+            { 100, 0 },   { 1250, 2 },  { 10000, 1 }, { 13721, 0 },
+            { 43124, 2 }, { 58000, 1 }, { 91000, 2 }
+        };
+        for (const auto& [loc, id] : syncword_locations) {
+            std::copy_n(&syncwords[static_cast<size_t>(id) * syncword_length],
+                        syncword_length,
+                        &symbols[loc]);
+        }
+        auto& modulator = add_modulator(fg, std::move(symbols));
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", syncwords },
+              { "num_syncwords", num_syncwords },
+              { "constellation", bpsk_constellation },
+              { "min_freq_bin", -4 },
+              { "max_freq_bin", 4 },
+              { "search_mode", search_mode },
+              { "power_threshold", 20.0f } });
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(modulator).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        const size_t delay =
+            2 * static_cast<size_t>(syncword_detection.time_threshold) + 1;
+        const auto tags = sink.tags();
+        expect(eq(tags.size(), syncword_locations.size()));
+        for (size_t j = 0; j < std::min(tags.size(), syncword_locations.size()); ++j) {
+            const auto& [loc, id] = syncword_locations[j];
+            expect(eq(static_cast<size_t>(tags[j].index),
+                      delay + samples_per_symbol * loc));
+            expect(eq(pmtv::cast<int>(tags[j].map.at("syncword_id")), id));
+            const auto syncword_amplitude =
+                pmtv::cast<float>(tags[j].map.at("syncword_amplitude"));
+            expect(syncword_amplitude < 1.01f);
+            expect(syncword_amplitude > 0.95f);
+        }
+    } | std::vector<std::string>{ "FULL", "TWO_STAGE" };
+
+    "predicted_window"_test = [](size_t predicted_location) {
+        Graph fg;
+        const size_t num_symbols = 100000;
+        std::default_random_engine e(1357);
+        const std::vector<size_t> syncword_locations = { 100,   1250,  10000, 13721,
+                                                         43124, 58000, 91000 };
+        auto& modulator = add_modulator(
+            fg, symbols_with_syncwords(num_symbols, syncword_locations, e));
+        const uint64_t time_threshold = 768;
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", test_syncword },
+              { "constellation", bpsk_constellation },
+              { "min_freq_bin", -4 },
+              { "max_freq_bin", 4 },
+              { "time_threshold", time_threshold },
+              { "power_threshold", 20.0f },
+              { "prediction_time_window", uint64_t{ 8 } } });
+        const size_t delay = 2 * time_threshold + 1;
+        // repeat set to true in this block because otherwise it says it's DONE
+        // and this causes the flowgraph to terminate
+        auto& prediction_source =
+            fg.emplaceBlock<VectorSource<Message>>({ { "repeat", true } });
+        Message prediction;
+        prediction.data = property_map{
+            { "syncword_index",
+              static_cast<uint64_t>(delay + samples_per_symbol * predicted_location) },
+            { "syncword_freq_bin", 0 }
+        };
+        prediction_source.data = std::vector<Message>{ std::move(prediction) };
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(modulator).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(prediction_source)
+                      .to<"next_syncword">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        // the syncwords before the predicted window are not searched for, and
+        // the full search continues after the window, even if the prediction
+        // is wrong
+        const bool wrong_prediction =
+            std::ranges::find(syncword_locations, predicted_location) ==
+            syncword_locations.end();
+        expect(eq(syncword_detection._missed_predictions,
+                  static_cast<uint64_t>(wrong_prediction)));
+        expect(syncword_detection._skipped_segments > 0U);
+        const std::vector<size_t> expected_locations = { 43124, 58000, 91000 };
+        const auto tags = sink.tags();
+        expect(eq(tags.size(), expected_locations.size()));
+        for (size_t j = 0; j < std::min(tags.size(), expected_locations.size()); ++j) {
+            expect(eq(static_cast<size_t>(tags[j].index),
+                      delay + samples_per_symbol * expected_locations[j]));
+            expect(eq(pmtv::cast<int>(tags[j].map.at("syncword_freq_bin")), 0));
+        }
+    } | std::vector<size_t>{ 43124, 30000 };
+
+    "cfo_tracking"_test = [](const std::string& search_mode) {
+        Graph fg;
+        const size_t num_symbols = 100000;
+        std::default_random_engine e(2468);
+        const std::vector<size_t> syncword_locations = { 100,   1250,  10000, 13721,
+                                                         43124, 58000, 91000 };
+        auto& modulator = add_modulator(
+            fg, symbols_with_syncwords(num_symbols, syncword_locations, e));
+        // the frequency offset is in the centre of frequency bin 2
+        const size_t syncword_samples =
+            (test_syncword.size() - 1) * samples_per_symbol + rrc_taps().size();
+        const float freq =
+            2.0f * std::numbers::pi_v<float> / static_cast<float>(syncword_samples);
+        auto& rotator = fg.emplaceBlock<Rotator<>>({ { "phase_incr", freq } });
+        const uint64_t time_threshold = 768;
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", test_syncword },
+              { "constellation", bpsk_constellation },
+              { "min_freq_bin", -4 },
+              { "max_freq_bin", 4 },
+              { "time_threshold", time_threshold },
+              { "search_mode", search_mode },
+              { "cfo_tracking", true } });
+        const size_t delay = 2 * time_threshold + 1;
+        // the messages simulate the packets decoded by the receiver
+        auto& packet_source =
+            fg.emplaceBlock<VectorSource<Message>>({ { "repeat", true } });
+        Message packet;
+        packet.data = property_map{ { "syncword_freq", freq } };
+        packet_source.data = std::vector<Message>{ std::move(packet) };
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(modulator).to<"in">(rotator)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(rotator).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(packet_source)
+                      .to<"next_syncword">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        expect(syncword_detection._tracking);
+        expect(eq(syncword_detection._tracking_timeouts, uint64_t{ 0 }));
+        // the random symbols can occasionally give a false alarm, so only
+        // check that all the syncwords are detected in the tracked bin
+        const auto tags = sink.tags();
+        for (const size_t loc : syncword_locations) {
+            const auto tag = std::ranges::find_if(tags, [&](const auto& t) {
+                return static_cast<size_t>(t.index) == delay + samples_per_symbol * loc;
+            });
+            expect(tag != tags.end()) << "syncword at" << loc << "not detected";
+            if (tag != tags.end()) {
+                expect(eq(pmtv::cast<int>(tag->map.at("syncword_freq_bin")), 2));
+            }
+        }
+    } | std::vector<std::string>{ "FULL", "TWO_STAGE" };
+
+    "cfo_tracking_window_edge"_test = [](const std::string& search_mode) {
+        // The syncwords are in the last frequency bin of the tracking window
+        // and the coarse threshold is so large that the adjacent bins are
+        // never computed, so the frequency cannot be interpolated. The
+        // frequency of the detected bin must be reported instead of an
+        // interpolation with a missing bin.
+        Graph fg;
+        const size_t num_symbols = 100000;
+        std::default_random_engine e(2468);
+        const std::vector<size_t> syncword_locations = { 100,   1250,  10000, 13721,
+                                                         43124, 58000, 91000 };
+        auto& modulator = add_modulator(
+            fg, symbols_with_syncwords(num_symbols, syncword_locations, e));
+        // the frequency offset is in the centre of frequency bin 2
+        const size_t syncword_samples =
+            (test_syncword.size() - 1) * samples_per_symbol + rrc_taps().size();
+        const float bin_spacing =
+            std::numbers::pi_v<float> / static_cast<float>(syncword_samples);
+        const float freq = 2.0f * bin_spacing;
+        auto& rotator = fg.emplaceBlock<Rotator<>>({ { "phase_incr", freq } });
+        const uint64_t time_threshold = 768;
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", test_syncword },
+              { "constellation", bpsk_constellation },
+              { "min_freq_bin", -4 },
+              { "max_freq_bin", 4 },
+              { "time_threshold", time_threshold },
+              { "search_mode", search_mode },
+              { "coarse_threshold", 1e6f },
+              { "cfo_tracking", true },
+              { "tracking_freq_window", 1 } });
+        const size_t delay = 2 * time_threshold + 1;
+        // the packets are decoded with a frequency in the centre of bin 1, so
+        // the tracking window contains the bins 0 to 2
+        auto& packet_source =
+            fg.emplaceBlock<VectorSource<Message>>({ { "repeat", true } });
+        Message packet;
+        packet.data = property_map{ { "syncword_freq", bin_spacing } };
+        packet_source.data = std::vector<Message>{ std::move(packet) };
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(modulator).to<"in">(rotator)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(rotator).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(packet_source)
+                      .to<"next_syncword">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        expect(syncword_detection._tracking);
+        const auto tags = sink.tags();
+        for (const size_t loc : syncword_locations) {
+            const auto tag = std::ranges::find_if(tags, [&](const auto& t) {
+                return static_cast<size_t>(t.index) == delay + samples_per_symbol * loc;
+            });
+            expect(tag != tags.end()) << "syncword at" << loc << "not detected";
+            if (tag != tags.end()) {
+                expect(eq(pmtv::cast<int>(tag->map.at("syncword_freq_bin")), 2));
+                const auto syncword_freq =
+                    pmtv::cast<float>(tag->map.at("syncword_freq"));
+                expect(std::abs(syncword_freq - freq) < 0.02f * bin_spacing);
+            }
+        }
+    } | std::vector<std::string>{ "FULL", "TWO_STAGE" };
+
+    "energy_gate"_test = [](const std::tuple<std::string, size_t>& params) {
+        const std::string& search_mode = std::get<0>(params);
+        const size_t num_threads = std::get<1>(params);
+        const size_t num_symbols = 200000;
+        // bursts given as (start, length, syncword offset inside the burst)
+        const std::vector<std::tuple<size_t, size_t, size_t>> bursts = {
+            { 7500, 500, 0 },    { 25004, 400, 20 },  { 60000, 1000, 0 },
+            { 72519, 300, 100 }, { 150000, 600, 10 }, { 151000, 500, 0 }
+        };
+        std::vector<size_t> syncword_locations;
+        for (const auto& [start, length, offset] : bursts) {
+            syncword_locations.push_back(start + offset);
+        }
+        // runs the detection with the given number of threads and returns its
+        // output, its tags and the number of skipped segments
+        const auto run = [&](size_t threads) {
+            Graph fg;
+            std::default_random_engine e(4321);
+            std::uniform_int_distribution<uint8_t> dist(0, 1);
+            // the symbol 2 is mapped to zero, which gives silence between the
+            // bursts
+            std::vector<uint8_t> symbols(num_symbols, 2);
+            for (const auto& [start, length, offset] : bursts) {
+                for (const size_t j : std::views::iota(start, start + length)) {
+                    symbols[j] = dist(e);
+                }
+                std::ranges::copy(test_syncword, &symbols[start + offset]);
+            }
+            auto noise = awgn(samples_per_symbol * num_symbols, 0.05f, e);
+            auto& modulator = add_modulator(
+                fg,
+                std::move(symbols),
+                std::vector<c64>{ { 1.0f, 0.0f }, { -1.0f, 0.0f }, {} });
+            auto& add = add_noise(fg, modulator, std::move(noise));
+            auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+                { { "rrc_taps", rrc_taps() },
+                  { "syncword", test_syncword },
+                  { "constellation", bpsk_constellation },
+                  { "min_freq_bin", -4 },
+                  { "max_freq_bin", 4 },
+                  { "search_mode", search_mode },
+                  { "num_threads", threads },
+                  { "energy_gate_threshold", 4.0f } });
+            auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+            expect(eq(ConnectionResult::SUCCESS,
+                      fg.connect<"out">(add).to<"in">(syncword_detection)));
+            expect(eq(ConnectionResult::SUCCESS,
+                      fg.connect<"out">(syncword_detection).to<"in">(sink)));
+            scheduler::Simple sched{ std::move(fg) };
+            expect(sched.runAndWait().has_value());
+            return std::tuple{ sink.data(),
+                               sink.tags(),
+                               static_cast<size_t>(syncword_detection._skipped_segments),
+                               syncword_detection.fft_size -
+                                   syncword_detection._template_size + 1,
+                               static_cast<size_t>(syncword_detection.time_threshold) };
+        };
+        const auto [data, tags, skipped_segments, stride, time_threshold] =
+            run(num_threads);
+        // most of the input is noise, so most of the segments are skipped
+        expect(skipped_segments > samples_per_symbol * num_symbols / stride / 2);
+        const size_t delay = 2 * time_threshold + 1;
+        expect(eq(tags.size(), syncword_locations.size()));
+        for (size_t j = 0; j < std::min(tags.size(), syncword_locations.size()); ++j) {
+            expect(eq(static_cast<size_t>(tags[j].index),
+                      delay + samples_per_symbol * syncword_locations[j]));
+            const auto syncword_amplitude =
+                pmtv::cast<float>(tags[j].map.at("syncword_amplitude"));
+            expect(syncword_amplitude < 1.05f);
+            expect(syncword_amplitude > 0.95f);
+        }
+        if (num_threads > 1) {
+            // the segments correlated in parallel are gated in the same way as
+            // when they are correlated one by one
+            const auto single = run(1);
+            const auto& data_single = std::get<0>(single);
+            const auto& tags_single = std::get<1>(single);
+            const size_t skipped_single = std::get<2>(single);
+            expect(eq(skipped_segments, skipped_single));
+            expect(data == data_single);
+            expect(eq(tags.size(), tags_single.size()));
+            for (size_t j = 0; j < std::min(tags.size(), tags_single.size()); ++j) {
+                expect(eq(tags[j].index, tags_single[j].index));
+                expect(tags[j].map == tags_single[j].map);
+            }
+        }
+    } | std::vector<std::tuple<std::string, size_t>>{
+        { "FULL", 1 }, { "TWO_STAGE", 1 }, { "FULL", 4 }, { "FULL", 3 }
+    };
+
+    "psd"_test = [](const std::string& search_mode) {
+        Graph fg;
+        const size_t num_samples = 400000;
+        const uint64_t psd_frame_length = 50000;
+        // white noise with a power of 0.125 plus a tone of power 1 at a
+        // frequency of 1/8 of the sample rate
+        const float noise_power = 0.125f;
+        std::default_random_engine e(1357);
+        std::normal_distribution<float> noise_dist(0.0f, std::sqrt(noise_power / 2.0f));
+        std::vector<c64> samples(num_samples);
+        for (size_t j = 0; j < num_samples; ++j) {
+            samples[j] = std::polar(1.0f,
+                                    std::numbers::pi_v<float> / 4.0f *
+                                        static_cast<float>(j % 8)) +
+                         c64{ noise_dist(e), noise_dist(e) };
+        }
+        auto& source = fg.emplaceBlock<VectorSource<c64>>();
+        source.data = samples;
+        auto& syncword_detection = fg.emplaceBlock<SyncwordDetection<>>(
+            { { "rrc_taps", rrc_taps() },
+              { "syncword", test_syncword },
+              { "constellation", bpsk_constellation },
+              { "search_mode", search_mode },
+              { "psd_frame_length", psd_frame_length } });
+        auto& sink = fg.emplaceBlock<VectorSink<c64>>();
+        auto& psd_sink = fg.emplaceBlock<VectorSink<Message>>();
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(source).to<"in">(syncword_detection)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"out">(syncword_detection).to<"in">(sink)));
+        expect(eq(ConnectionResult::SUCCESS,
+                  fg.connect<"psd">(syncword_detection).to<"in">(psd_sink)));
+        scheduler::Simple sched{ std::move(fg) };
+        expect(sched.runAndWait().has_value());
+        // the last frame is incomplete when the input ends
+        const auto frames = psd_sink.data();
+        expect(frames.size() >= num_samples / psd_frame_length - 2);
+        expect(eq(syncword_detection._psd_dropped_frames, uint64_t{ 0 }));
+        uint64_t frame_end = 0;
+        for (const auto& frame : frames) {
+            expect(frame.data.has_value());
+            if (!frame.data.has_value()) {
+                continue;
+            }
+            const auto& data = frame.data.value();
+            const auto psd = std::get<std::vector<float>>(data.at("psd"));
+            const size_t nfft = syncword_detection._fft_size;
+            expect(eq(psd.size(), nfft));
+            // the tone is in the bin nfft / 8 after the zero frequency, which
+            // is in the centre
+            const auto peak = std::ranges::max_element(psd);
+            expect(eq(static_cast<size_t>(peak - psd.begin()), nfft / 2 + nfft / 8));
+            // the PSD integrates to the total power
+            float total_power = 0.0f;
+            for (const float x : psd) {
+                total_power += x;
+            }
+            total_power /= static_cast<float>(nfft);
+            expect(std::abs(total_power - (1.0f + noise_power)) < 0.05f);
+            const float frame_noise_power = pmtv::cast<float>(data.at("noise_power"));
+            expect(std::abs(frame_noise_power - noise_power) < 0.1f * noise_power);
+            expect(pmtv::cast<uint64_t>(data.at("num_segments")) > uint64_t{ 0 });
+            const auto sample_index = pmtv::cast<uint64_t>(data.at("sample_index"));
+            expect(sample_index >= frame_end + psd_frame_length);
+            frame_end = sample_index - sample_index % psd_frame_length;
+        }
+    } | std::vector<std::string>{ "FULL", "TWO_STAGE" };
 };
 
 int main() {}